@@ -1,6 +1,13 @@
 set(CPP_FILES
   Statistics.cpp
   Registration.cpp
+  ErrorReduction.cpp
+  PairedPointSolver.cpp
+  CombinationGenerator.cpp
+  FiducialConfigurationEvaluator.cpp
+  MonteCarloTRESimulator.cpp
+  TREPredictor.cpp
+  TREMap.cpp
   SurfaceRefinement.cpp
 )
 
@@ -0,0 +1,73 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef COMBINATION_GENERATOR_H
+#define COMBINATION_GENERATOR_H
+
+#include <cstdint>
+#include <vector>
+
+#include "AlgorithmsExports.h"
+
+/**
+  \class CombinationGenerator
+
+  The combinations of K ids out of N (0..N-1) in lexicographic order, addressed by their rank
+  (combinatorial number system) instead of being stored: any combination can be computed from
+  its rank, so the range can be split among parallel workers that walk their chunk with Next.
+
+  Excluded ids are removed from the alphabet, so the combinations containing them are not part
+  of the range at all (no filtering pass).
+*/
+class Algorithms_EXPORT CombinationGenerator
+{
+public:
+  CombinationGenerator(unsigned int n, unsigned int k);
+
+  /// ids that no combination contains (ids out of range are ignored)
+  void SetExcludedIds(const std::vector<unsigned int>& ids);
+
+  inline unsigned int GetN() const {return mN;}
+  inline unsigned int GetK() const {return mK;}
+
+  /// number of combinations without excluded ids (saturates at UINT64_MAX)
+  uint64_t GetNumberOfCombinations() const;
+
+  /// writes the K ascending ids of the combination with the given rank (< GetNumberOfCombinations)
+  void Unrank(uint64_t rank, unsigned int* ids) const;
+
+  /// rank of a combination of K ascending, not excluded ids
+  uint64_t Rank(const unsigned int* ids) const;
+
+  /// replaces the combination by the next one in rank order, returns false after the last one
+  bool Next(unsigned int* ids) const;
+
+  /// rank range [begin, end) of a chunk, the chunks have the same size (+-1) and cover all ranks (empty if chunks is 0)
+  void GetChunk(unsigned int chunk, unsigned int chunks, uint64_t& begin, uint64_t& end) const;
+
+  /// binomial coefficient, saturates at UINT64_MAX
+  static uint64_t Binomial(unsigned int n, unsigned int k);
+
+private:
+  void BuildTable();
+
+  /// C(n,k) from the table, for n <= number of allowed ids
+  inline uint64_t C(unsigned int n, unsigned int k) const {return (k > n) ? 0 : mBinomial[n*(mK+1) + k];}
+
+  unsigned int                mN;
+  unsigned int                mK;
+
+  // allowed ids, and position of every id among them (-1 if excluded)
+  std::vector<unsigned int>   mAllowed;
+  std::vector<int>            mPosition;
+
+  // pascal triangle up to the number of allowed ids, k <= K
+  std::vector<uint64_t>       mBinomial;
+};
+
+#endif // COMBINATION_GENERATOR_H
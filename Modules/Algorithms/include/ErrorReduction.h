@@ -0,0 +1,54 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef ERROR_REDUCTION_H
+#define ERROR_REDUCTION_H
+
+#include <RigidTransform.h>
+
+#include "AlgorithmsExports.h"
+
+class vtkPoints;
+
+/// statistics of a set of errors (mm), std is the population standard deviation
+struct ErrorStatistics
+{
+  unsigned int  count;
+  double        mean;
+  double        std;
+  double        rms;
+  double        max;
+};
+
+/**
+  \class ErrorReduction
+
+  Single pass statistics of registration errors. The displacement of the points moved by a rigid
+  transform is computed on the fly (|(R - I) p + t|, which does not lose the small errors of far
+  points as T(p) - p does) and reduced without storing it: blocks of points are summed relative to
+  a reference error, the block sums are accumulated with Kahan compensation, and the partial
+  results of the threads are merged with Chan's update, so the rounding error does not grow with
+  the number of points of million vertex surfaces.
+*/
+class Algorithms_EXPORT ErrorReduction
+{
+public:
+  static ErrorStatistics FromValues(const double* values, unsigned int n);
+
+  /// displacement of n points (x,y,z contiguous) read every stride points, split among threads (0 uses all the cores)
+  static ErrorStatistics FromTransform(const RigidTransform& error, const float* points, unsigned int n,
+                                       unsigned int stride=1, unsigned int threads=0);
+  static ErrorStatistics FromTransform(const RigidTransform& error, const double* points, unsigned int n,
+                                       unsigned int stride=1, unsigned int threads=0);
+
+  /// evenly spaced samples of the points, 0 (or more samples than points) uses all of them
+  static ErrorStatistics FromTransform(const RigidTransform& error, vtkPoints* points,
+                                       unsigned int samples=0, unsigned int threads=0);
+};
+
+#endif // ERROR_REDUCTION_H
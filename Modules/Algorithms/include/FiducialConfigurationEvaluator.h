@@ -0,0 +1,121 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef FIDUCIAL_CONFIGURATION_EVALUATOR_H
+#define FIDUCIAL_CONFIGURATION_EVALUATOR_H
+
+#include <atomic>
+#include <vector>
+
+#include <QString>
+
+#include <mitkPointSet.h>
+
+#include <RegistrationPointsMetrics.h>
+#include <RigidTransform.h>
+
+#include "AlgorithmsExports.h"
+
+class vtkPolyData;
+
+/**
+  \class FiducialConfigurationEvaluator
+
+  Evaluates every subset of K registration points (see CombinationGenerator) to find which
+  configurations give the best accuracy. For each subset and model, the paired point registration
+  is solved and compared with the registration using all the points: FRE metrics of the subset
+  (GetErrorMetricsFromPairedPointRegistration), TRE on the target surface (EstimateTREFromMatrix),
+  offset and angle (GetAngleAndOffsetErrorFromMatrix). With a model B, the offset and angle between
+  both subset registrations are the dissociated navigation metrics.
+
+  The ranks are split into chunks that are distributed among the worker threads; idle workers steal
+  chunks from the others. Results are stored by rank, so their order does not depend on the number
+  of threads, and the completed prefix is appended to the output database while the workers run.
+*/
+class Algorithms_EXPORT FiducialConfigurationEvaluator
+{
+public:
+  FiducialConfigurationEvaluator();
+
+  /// planned points are fixed, real points are moving (paired by order, as in PerformPairedPointsRegistration)
+  bool SetModelA(const mitk::PointSet* planned, const mitk::PointSet* real, int markerType=RegistrationPointsMetrics::NoData);
+  /// optional second model, localized on the same fiducials (same number of pairs)
+  bool SetModelB(const mitk::PointSet* planned, const mitk::PointSet* real, int markerType=RegistrationPointsMetrics::NoData);
+
+  void SetSubsetSize(unsigned int k){mSubsetSize = k;}
+  void SetExcludedIds(const std::vector<unsigned int>& ids){mExcludedIds = ids;}
+  /// FLE of the localizer, stored with the metrics
+  void SetFLE(double fle){mFLE = fle;}
+
+  /// TRE is estimated on npoints points of the surface (in planned space), not estimated without surface
+  void SetTargetSurface(vtkPolyData* pd, int npoints);
+
+  /// 0 uses all the cores
+  void SetNumberOfThreads(unsigned int threads){mNumberOfThreads = threads;}
+  /// results are appended to this database while evaluating, nothing is written if empty
+  void SetOutputFile(const QString& filename){mOutputFile = filename;}
+
+  /// blocks until all the subsets are evaluated, results are in rank order
+  bool Run(std::vector<RegistrationPointsMetrics>& results);
+  /// may be called from any thread, Run returns false
+  void Abort(){mAbort = true;}
+
+  uint64_t GetNumberOfSubsets() const;
+  uint64_t GetNumberOfEvaluatedSubsets() const {return mEvaluated;}
+  /// subsets per second of the last run
+  double GetThroughput() const {return mThroughput;}
+
+private:
+  struct Model
+  {
+    std::vector<double>   fixed;
+    std::vector<double>   moving;
+    int                   markerType = RegistrationPointsMetrics::NoData;
+  };
+
+  struct SubsetMetrics
+  {
+    RigidTransform        transform;
+    std::vector<double>   dist;
+    double                mean;
+    double                stdDev;
+    double                fre;
+    double                fle;
+    double                tre;
+    double                offset;
+    double                angle;
+  };
+
+  static bool SetModel(Model& model, const mitk::PointSet* planned, const mitk::PointSet* real, int markerType);
+
+  /// false if the registration of a model is degenerate (collinear points)
+  bool Evaluate(const unsigned int* ids, RegistrationPointsMetrics& metrics) const;
+  bool EvaluateModel(const Model& model, const RigidTransform& inverseReference, const unsigned int* ids, SubsetMetrics& metrics) const;
+
+  Model                       mModelA;
+  Model                       mModelB;
+  bool                        mHasModelB;
+
+  unsigned int                mSubsetSize;
+  std::vector<unsigned int>   mExcludedIds;
+  double                      mFLE;
+  std::vector<double>         mTargets;
+
+  unsigned int                mNumberOfThreads;
+  QString                     mOutputFile;
+
+  // inverse of the registrations with all the (not excluded) points, evaluated when running
+  RigidTransform              mInverseReferenceA;
+  RigidTransform              mInverseReferenceB;
+
+  std::atomic<bool>           mAbort;
+  std::atomic<uint64_t>       mEvaluated;
+  double                      mThroughput;
+};
+
+#endif // FIDUCIAL_CONFIGURATION_EVALUATOR_H
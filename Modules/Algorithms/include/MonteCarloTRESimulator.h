@@ -0,0 +1,98 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef MONTE_CARLO_TRE_SIMULATOR_H
+#define MONTE_CARLO_TRE_SIMULATOR_H
+
+#include <atomic>
+#include <vector>
+
+#include <mitkPointSet.h>
+
+#include <RigidTransform.h>
+
+#include "AlgorithmsExports.h"
+#include "PhiloxRandom.h"
+
+/// TRE distribution of one target over all the trials
+struct TREDistribution
+{
+  double                mean;
+  double                rms;
+  double                max;
+  /// in the order of the requested percentiles
+  std::vector<double>   percentiles;
+};
+
+/**
+  \class MonteCarloTRESimulator
+
+  Simulates the target registration error of a fiducial configuration: in every trial the fiducials
+  are perturbed with the localization error (FLE), registered back onto their true positions, and
+  the displacement of every target is recorded.
+
+  Trial t draws its noise from stream t of a PhiloxRandom generator keyed with the seed, so the
+  distributions only depend on the seed, never on the number of threads or on the scheduling.
+*/
+class Algorithms_EXPORT MonteCarloTRESimulator
+{
+public:
+  MonteCarloTRESimulator();
+
+  void SetFiducials(const mitk::PointSet* fiducials);
+  void SetTargets(const mitk::PointSet* targets);
+  /// n points, x,y,z contiguous
+  void SetTargets(const double* targets, unsigned int n);
+
+  /// isotropic localization error, fle is the rms 3D error (mm)
+  void SetIsotropicFLE(double fle);
+  /// standard deviation along each axis of a frame rotated by orientation (e.g. the camera frame)
+  void SetAnisotropicFLE(const double sigma[3], const Quaternion& orientation=Quaternion::Identity());
+
+  void SetNumberOfTrials(unsigned int trials){mNumberOfTrials = trials;}
+  /// defaults to the global seed (Statistics::GetRandomSeed)
+  void SetSeed(uint64_t seed){mSeed = seed;}
+  /// 0 uses all the cores
+  void SetNumberOfThreads(unsigned int threads){mNumberOfThreads = threads;}
+  /// percentiles of the TRE to report, in [0,100]
+  void SetPercentiles(const std::vector<double>& percentiles){mPercentiles = percentiles;}
+
+  /// blocks until all the trials are simulated
+  bool Run();
+  /// may be called from any thread, Run returns false
+  void Abort(){mAbort = true;}
+
+  /// one distribution per target
+  const std::vector<TREDistribution>& GetResults() const {return mResults;}
+  /// trials where the perturbed fiducials could not be registered (excluded from the distributions)
+  unsigned int GetNumberOfDegenerateTrials() const {return mDegenerateTrials;}
+
+private:
+  /// false if the perturbed fiducials cannot be registered
+  bool SimulateTrial(unsigned int trial, PhiloxRandom& generator, std::vector<double>& noise, std::vector<double>& moving);
+
+  std::vector<double>           mFiducials;
+  std::vector<double>           mTargets;
+
+  // noise = mNoiseRotation * (sigma .* standard normal)
+  double                        mSigma[3];
+  RigidTransform                mNoiseRotation;
+
+  unsigned int                  mNumberOfTrials;
+  uint64_t                      mSeed;
+  unsigned int                  mNumberOfThreads;
+  std::vector<double>           mPercentiles;
+
+  // TRE of every target (rows) in every trial (columns)
+  std::vector<double>           mTRE;
+  std::vector<TREDistribution>  mResults;
+  std::atomic<unsigned int>     mDegenerateTrials;
+  std::atomic<bool>             mAbort;
+};
+
+#endif // MONTE_CARLO_TRE_SIMULATOR_H
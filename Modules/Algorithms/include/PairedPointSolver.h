@@ -0,0 +1,53 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef PAIRED_POINT_SOLVER_H
+#define PAIRED_POINT_SOLVER_H
+
+#include <RigidTransform.h>
+
+#include "AlgorithmsExports.h"
+
+/// rigid registration of a set of paired points and its residuals
+struct PairedPointResult
+{
+  RigidTransform  transform;    // moving to fixed points
+  double          fre;          // rms of the residuals, mm
+  double          meanError;    // mm
+  double          maxError;     // mm
+  bool            valid;
+};
+
+/**
+  \class PairedPointSolver
+
+  Closed-form least squares rigid registration of paired points (Horn's unit quaternion method):
+  the rotation is the eigenvector of the largest eigenvalue of the 4x4 matrix built from the
+  cross-covariance of the centered points, computed with Jacobi rotations.
+
+  Points are contiguous x,y,z triplets. Nothing is allocated, so many subsets can be solved
+  concurrently from the same point arrays.
+*/
+class Algorithms_EXPORT PairedPointSolver
+{
+public:
+  /*  Registers the moving points onto the fixed ones (n >= 3 non collinear pairs).
+      The distance of every transformed moving point to its fixed point is written in residuals,
+      if given. Returns an invalid result for degenerate configurations.*/
+  static PairedPointResult Solve(const double* fixed, const double* moving, unsigned int n, double* residuals=nullptr);
+
+  /// same, with the pairs given by their ids in the point arrays
+  static PairedPointResult Solve(const double* fixed, const double* moving, const unsigned int* ids, unsigned int n, double* residuals=nullptr);
+
+  /*  Solves count subsets of subsetSize pairs each, stored one after the other in subsets (ids in
+      the point arrays). Returns the number of valid registrations.*/
+  static unsigned int SolveSubsets(const double* fixed, const double* moving, const unsigned int* subsets,
+                                   unsigned int subsetSize, unsigned int count, PairedPointResult* results);
+};
+
+#endif // PAIRED_POINT_SOLVER_H
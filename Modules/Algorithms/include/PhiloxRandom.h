@@ -0,0 +1,120 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef PHILOX_RANDOM_H
+#define PHILOX_RANDOM_H
+
+#include <cstdint>
+#include <cmath>
+
+/**
+  \class PhiloxRandom
+
+  Counter-based random numbers (Philox4x32-10, Salmon et al., "Parallel random numbers: as easy as
+  1, 2, 3", SC 2011). Every value is a pure function of (seed, stream, position), so a stream can
+  be assigned to each trial or thread and a simulation is reproduced exactly from its seed, with
+  any number of threads. No state is shared between generators.
+*/
+class PhiloxRandom
+{
+public:
+  PhiloxRandom(uint64_t seed=0, uint64_t stream=0)
+  {
+    SetSeed(seed);
+    SetStream(stream);
+  }
+
+  void SetSeed(uint64_t seed)
+  {
+    mKey[0] = static_cast<uint32_t>(seed);
+    mKey[1] = static_cast<uint32_t>(seed >> 32);
+    mAvailable = 0;
+    mBlock = 0;
+  }
+
+  /// restarts the generator at the beginning of a stream
+  void SetStream(uint64_t stream)
+  {
+    mStream = stream;
+    mAvailable = 0;
+    mBlock = 0;
+  }
+
+  uint32_t NextUInt32()
+  {
+    if (mAvailable == 0)
+    {
+      const uint32_t counter[4] = {static_cast<uint32_t>(mBlock), static_cast<uint32_t>(mBlock >> 32),
+                                   static_cast<uint32_t>(mStream), static_cast<uint32_t>(mStream >> 32)};
+      Block(counter,mKey,mBuffer);
+      mBlock++;
+      mAvailable = 4;
+    }
+    return mBuffer[4 - mAvailable--];
+  }
+
+  /// uniform in (0,1), 53 random bits
+  double Uniform()
+  {
+    // two words, drawn in a fixed order
+    const uint64_t high = NextUInt32();
+    const uint64_t low = NextUInt32();
+    const uint64_t bits = (high << 21) ^ (low >> 11);
+    return (static_cast<double>(bits) + 0.5) * (1.0/9007199254740992.0);
+  }
+
+  /// n standard normal values (Box-Muller), one random block per pair
+  void Normal(double* values, unsigned int n)
+  {
+    for (unsigned int i=0; i<n; i+=2)
+    {
+      const double r = std::sqrt(-2.0*std::log(Uniform()));
+      const double phi = 6.283185307179586 * Uniform();
+      values[i] = r*std::cos(phi);
+      if (i+1 < n)
+        values[i+1] = r*std::sin(phi);
+    }
+  }
+
+  double Normal()
+  {
+    double value;
+    Normal(&value,1);
+    return value;
+  }
+
+  /// the Philox4x32 bijection: 10 rounds of the counter with the key
+  static void Block(const uint32_t counter[4], const uint32_t key[2], uint32_t out[4])
+  {
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+    for (unsigned int round=0; round<10; round++)
+    {
+      const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * c0;
+      const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * c2;
+      const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+      const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+      c1 = static_cast<uint32_t>(p1);
+      c3 = static_cast<uint32_t>(p0);
+      c0 = n0;
+      c2 = n2;
+      k0 += 0x9E3779B9u;
+      k1 += 0xBB67AE85u;
+    }
+    out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+  }
+
+private:
+  uint32_t    mKey[2];
+  uint64_t    mStream;
+  uint64_t    mBlock;
+  uint32_t    mBuffer[4];
+  unsigned    mAvailable;
+};
+
+#endif // PHILOX_RANDOM_H
@@ -13,6 +13,8 @@ navCAS navigation system
 
 #include <mitkPointSet.h>
 
+#include <RigidTransform.h>
+
 #include "AlgorithmsExports.h"
 
 #include <vtkSmartPointer.h>
@@ -35,10 +37,19 @@ public:
                                                            std::vector<double> &distances,
                                                            double &meanError, double &std, double &fre, double &fle);
 
+  /// same metrics from the distances between the transformed and the planned points
+  static void GetErrorMetricsFromDistances(const double* distances, unsigned int numberOfPoints,
+                                           double &meanError, double &std, double &fre, double &fle);
+
   static void GetAngleAndOffsetErrorFromMatrix(const vtkMatrix4x4* matrix, double &offset, double &angle);
+  static void GetAngleAndOffsetErrorFromTransform(const RigidTransform& error, double &offset, double &angle);
 
+  /// rms displacement of npoints evenly spaced vertices of the surface, all of them (exact) if npoints is 0 or larger
   static double EstimateTREFromMatrix(const vtkMatrix4x4* matrixA, vtkPolyData* pd, const int npoints);
 
+  /// rms displacement of the n target points (x,y,z contiguous) moved by the error transform, in this thread
+  static double EstimateTREFromTransform(const RigidTransform& error, const double* targets, unsigned int n);
+
 private:
 
 };
@@ -9,6 +9,7 @@ navCAS navigation system
 #ifndef CAS_STATISTICS_H
 #define CAS_STATISTICS_H
 
+#include <cstdint>
 #include <vector>
 
 #include <mitkPointSet.h>
@@ -21,7 +22,7 @@ class Algorithms_EXPORT Statistics
 
 public:
 
-  /// picks all the combinations of K elements from a group of N
+  /// picks all the combinations of K elements from a group of N (see CombinationGenerator to avoid storing them)
   static std::vector<std::vector<int> > comb(int N, int K);
 
   /// The K value determines if the combinations should be resized to desired length K, or if they should be discarded directly.
@@ -29,8 +30,17 @@ public:
 
   static bool getPointCloudMainAxes(const mitk::PointSet* ps, mitk::Vector3D &ax, mitk::Vector3D &ay, mitk::Vector3D &az);
 
+  /// gaussian noise on each coordinate. Every thread draws from its own stream, numbered in the order the
+  /// threads first draw after a new seed: the noise is reproducible from the global seed on a single thread only
   static void AddNoiseToPoint(mitk::Point3D &point, double mean, double std);
 
+  /// gaussian noise from the stream chosen by the caller (e.g. trial and point ids), reproducible with any threads
+  static void AddNoiseToPoint(mitk::Point3D &point, double mean, double std, uint64_t stream);
+
+  /// global seed of the simulations, restarts the random streams of all threads
+  static void SetRandomSeed(uint64_t seed);
+  static uint64_t GetRandomSeed();
+
 private:
 
 };
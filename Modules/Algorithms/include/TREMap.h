@@ -0,0 +1,86 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef TRE_MAP_H
+#define TRE_MAP_H
+
+#include <list>
+#include <vector>
+
+#include <mitkDataNode.h>
+#include <mitkPointSet.h>
+
+#include <vtkSmartPointer.h>
+#include <vtkFloatArray.h>
+#include <vtkPolyData.h>
+#include <vtkType.h>
+
+#include "AlgorithmsExports.h"
+
+/**
+  \class TREMap
+
+  Predicted TRE (see TREPredictor) of every vertex of a surface, shown as a colormap while the
+  registration points are planned. The maps of the last configurations (surface, fiducials, FLE)
+  are cached, so going back to a previous configuration does not compute them again.
+  The map is added to the surface as a named array: the scalars and the properties of the node
+  are restored when it is hidden.
+*/
+class Algorithms_EXPORT TREMap
+{
+public:
+  TREMap();
+
+  void SetFLE(double fle){mFLE = fle;}
+  double GetFLE() const {return mFLE;}
+  /// upper limit of the colormap (mm), 0 uses the largest TRE of the surface
+  void SetMaximumTRE(double maximum){mMaximumTRE = maximum;}
+  void SetCacheSize(unsigned int maps);
+
+  /// TRE of every vertex, nullptr if the fiducials cannot be registered (less than 3 or collinear)
+  vtkSmartPointer<vtkFloatArray> Compute(vtkPolyData* pd, const mitk::PointSet* fiducials);
+
+  /// colors the surface of the node with the predicted TRE, false if it cannot be predicted
+  bool Show(mitk::DataNode* node, const mitk::PointSet* fiducials);
+  /// removes the map from the node, if shown, and restores its scalars and properties
+  void Hide(mitk::DataNode* node);
+
+  unsigned int GetNumberOfCacheHits() const {return mCacheHits;}
+
+private:
+  struct Configuration
+  {
+    const vtkPolyData*    surface;
+    vtkMTimeType          surfaceTime;
+    double                fle;
+    std::vector<double>   fiducials;
+
+    bool operator==(const Configuration& c) const
+    {
+      return (surface == c.surface) && (surfaceTime == c.surfaceTime) && (fle == c.fle) && (fiducials == c.fiducials);
+    }
+  };
+
+  typedef std::pair<Configuration, vtkSmartPointer<vtkFloatArray> > CachedMap;
+
+  double                  mFLE;
+  double                  mMaximumTRE;
+
+  // most recently used first
+  std::list<CachedMap>    mCache;
+  unsigned int            mCacheSize;
+  unsigned int            mCacheHits;
+
+  // node colored by the map, with its previous active scalars and properties (nullptr if not set)
+  mitk::DataNode::Pointer                 mShownNode;
+  vtkSmartPointer<vtkPolyData>            mShownSurface;
+  vtkSmartPointer<vtkDataArray>           mPreviousScalars;
+  std::vector<mitk::BaseProperty::Pointer> mPreviousProperties;
+};
+
+#endif // TRE_MAP_H
@@ -0,0 +1,62 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef TRE_PREDICTOR_H
+#define TRE_PREDICTOR_H
+
+#include "AlgorithmsExports.h"
+
+/**
+  \class TREPredictor
+
+  Expected target registration error of a fiducial configuration (Fitzpatrick, West and Maurer,
+  "Predicting error in rigid-body point-based registration", IEEE TMI 17(5), 1998):
+
+    TRE^2(r) = FLE^2/N (1 + 1/3 sum_k d_k^2/f_k^2)
+
+  where d_k is the distance of the target to the k-th principal axis of the fiducials and f_k the
+  rms distance of the fiducials to that axis. The sum is the quadratic form p^T M p of the target
+  relative to the centroid, with M = trace(A^-1) I - A^-1 and A = trace(C) I - C (C the covariance
+  of the fiducials), so M is computed once per configuration and each target costs a few products.
+*/
+class Algorithms_EXPORT TREPredictor
+{
+public:
+  TREPredictor();
+
+  /// n points, x,y,z contiguous; false if there are less than 3 or they are collinear
+  bool SetFiducials(const double* fiducials, unsigned int n);
+  /// rms localization error (mm)
+  void SetFLE(double fle){mFLE = fle;}
+  double GetFLE() const {return mFLE;}
+
+  bool IsValid() const {return mValid;}
+
+  /// rms TRE at the target (mm)
+  double Predict(const double target[3]) const;
+
+  /// rms TRE of n targets (x,y,z contiguous), split among threads (0 uses all the cores)
+  void Predict(const float* targets, unsigned int n, float* tre, unsigned int threads=0) const;
+  void Predict(const double* targets, unsigned int n, float* tre, unsigned int threads=0) const;
+
+private:
+  template <typename T>
+  double Evaluate(const T* target) const;
+  template <typename T>
+  void PredictRange(const T* targets, unsigned int begin, unsigned int end, float* tre) const;
+  template <typename T>
+  void PredictParallel(const T* targets, unsigned int n, float* tre, unsigned int threads) const;
+
+  bool          mValid;
+  unsigned int  mNumberOfFiducials;
+  double        mFLE;
+  double        mCentroid[3];
+  double        mM[3][3];
+};
+
+#endif // TRE_PREDICTOR_H
@@ -0,0 +1,153 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <limits>
+
+#include "CombinationGenerator.h"
+
+static inline uint64_t SaturatedAdd(uint64_t a, uint64_t b)
+{
+  return (a > std::numeric_limits<uint64_t>::max() - b) ? std::numeric_limits<uint64_t>::max() : a + b;
+}
+
+CombinationGenerator::CombinationGenerator(unsigned int n, unsigned int k) :
+  mN(n),
+  mK(k)
+{
+  SetExcludedIds(std::vector<unsigned int>());
+}
+
+void CombinationGenerator::SetExcludedIds(const std::vector<unsigned int>& ids)
+{
+  mPosition.assign(mN,0);
+  for (unsigned int id : ids)
+    if (id < mN)
+      mPosition[id] = -1;
+
+  mAllowed.clear();
+  for (unsigned int id=0; id<mN; id++)
+  {
+    if (mPosition[id] < 0)
+      continue;
+
+    mPosition[id] = mAllowed.size();
+    mAllowed.push_back(id);
+  }
+
+  BuildTable();
+}
+
+void CombinationGenerator::BuildTable()
+{
+  const unsigned int m = mAllowed.size();
+  mBinomial.assign((m+1)*(mK+1),0);
+
+  for (unsigned int n=0; n<=m; n++)
+  {
+    mBinomial[n*(mK+1)] = 1;
+    for (unsigned int k=1; (k<=mK) && (k<=n); k++)
+      mBinomial[n*(mK+1) + k] = SaturatedAdd(mBinomial[(n-1)*(mK+1) + k-1], (k < n) ? mBinomial[(n-1)*(mK+1) + k] : 0);
+  }
+}
+
+uint64_t CombinationGenerator::Binomial(unsigned int n, unsigned int k)
+{
+  if (k > n)
+    return 0;
+  if (k > n-k)
+    k = n-k;
+
+  // C(n-k+i, i) for increasing i: every intermediate value is a binomial coefficient
+  uint64_t c = 1;
+  for (unsigned int i=1; i<=k; i++)
+  {
+    const uint64_t a = n-k+i;
+    const uint64_t q = c/i;
+    if (q > std::numeric_limits<uint64_t>::max() / a)
+      return std::numeric_limits<uint64_t>::max();
+    c = SaturatedAdd(q*a, ((c%i)*a)/i);
+  }
+  return c;
+}
+
+uint64_t CombinationGenerator::GetNumberOfCombinations() const
+{
+  return C(mAllowed.size(),mK);
+}
+
+void CombinationGenerator::Unrank(uint64_t rank, unsigned int* ids) const
+{
+  const unsigned int m = mAllowed.size();
+
+  // at every position, skip the blocks of combinations starting with a smaller id
+  unsigned int x = 0;
+  for (unsigned int i=0; i<mK; i++)
+  {
+    while (x < m)
+    {
+      const uint64_t block = C(m-x-1, mK-i-1);
+      if (rank < block)
+        break;
+      rank -= block;
+      x++;
+    }
+    ids[i] = mAllowed[x];
+    x++;
+  }
+}
+
+uint64_t CombinationGenerator::Rank(const unsigned int* ids) const
+{
+  const unsigned int m = mAllowed.size();
+
+  uint64_t rank = 0;
+  unsigned int x = 0;
+  for (unsigned int i=0; i<mK; i++)
+  {
+    const unsigned int position = mPosition[ids[i]];
+    for (; x<position; x++)
+      rank += C(m-x-1, mK-i-1);
+    x = position+1;
+  }
+  return rank;
+}
+
+bool CombinationGenerator::Next(unsigned int* ids) const
+{
+  const unsigned int m = mAllowed.size();
+
+  // rightmost position that can still be increased
+  int i = static_cast<int>(mK)-1;
+  while ((i >= 0) && (static_cast<unsigned int>(mPosition[ids[i]]) == m - mK + i))
+    i--;
+  if (i < 0)
+    return false;
+
+  unsigned int x = mPosition[ids[i]] + 1;
+  for (unsigned int j=i; j<mK; j++)
+    ids[j] = mAllowed[x++];
+  return true;
+}
+
+void CombinationGenerator::GetChunk(unsigned int chunk, unsigned int chunks, uint64_t& begin, uint64_t& end) const
+{
+  // no chunks: empty range
+  if (chunks == 0)
+  {
+    begin = end = 0;
+    return;
+  }
+
+  const uint64_t total = GetNumberOfCombinations();
+  const uint64_t size = total / chunks;
+  const uint64_t remainder = total % chunks;
+
+  // the first chunks take one more combination
+  begin = size*chunk + ((chunk < remainder) ? chunk : remainder);
+  end = begin + size + ((chunk < remainder) ? 1 : 0);
+}
@@ -0,0 +1,247 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <vtkDoubleArray.h>
+#include <vtkFloatArray.h>
+#include <vtkPoints.h>
+
+#include "ErrorReduction.h"
+
+/// points below which a single thread is faster than starting others
+static const unsigned int MINIMUM_POINTS_PER_THREAD = 65536;
+
+/// points summed without compensation, in independent lanes (vectorized)
+static const unsigned int BLOCK_SIZE = 1024;
+static const unsigned int LANES = 4;
+
+namespace
+{
+  /// statistics of a range of errors, merged with Chan's update
+  struct Partial
+  {
+    unsigned int  count;
+    double        mean;
+    double        m2;
+    double        max;
+  };
+
+  /// Kahan compensated sum
+  struct CompensatedSum
+  {
+    double sum = 0.0;
+    double compensation = 0.0;
+
+    inline void Add(double value)
+    {
+      const double y = value - compensation;
+      const double t = sum + y;
+      compensation = (t - sum) - y;
+      sum = t;
+    }
+  };
+
+  /// error of value i
+  struct Values
+  {
+    const double* values;
+    inline double operator()(unsigned int i) const {return values[i];}
+  };
+
+  /// displacement of point i, |D p + t| with D = R - I
+  template <typename T>
+  struct Displacements
+  {
+    const T*      points;
+    unsigned int  stride;
+    double        D[3][3];
+    double        t[3];
+
+    Displacements(const RigidTransform& error, const T* p, unsigned int s) :
+      points(p),
+      stride(s)
+    {
+      for (unsigned int i=0; i<3; i++)
+      {
+        for (unsigned int j=0; j<3; j++)
+          D[i][j] = error.rotation[i][j] - ((i == j) ? 1.0 : 0.0);
+        t[i] = error.translation[i];
+      }
+    }
+
+    inline double operator()(unsigned int i) const
+    {
+      const T* p = points + 3*static_cast<size_t>(i)*stride;
+      const double x = p[0], y = p[1], z = p[2];
+      const double dx = D[0][0]*x + D[0][1]*y + D[0][2]*z + t[0];
+      const double dy = D[1][0]*x + D[1][1]*y + D[1][2]*z + t[1];
+      const double dz = D[2][0]*x + D[2][1]*y + D[2][2]*z + t[2];
+      return std::sqrt(dx*dx + dy*dy + dz*dz);
+    }
+  };
+}
+
+static Partial Merge(const Partial& a, const Partial& b)
+{
+  if (a.count == 0)
+    return b;
+  if (b.count == 0)
+    return a;
+
+  const double na = a.count, nb = b.count, n = na + nb;
+  const double delta = b.mean - a.mean;
+
+  Partial result;
+  result.count = a.count + b.count;
+  result.mean = a.mean + delta*nb/n;
+  result.m2 = a.m2 + b.m2 + delta*delta*na*nb/n;
+  result.max = std::max(a.max,b.max);
+  return result;
+}
+
+/*  Errors are summed relative to the first one of the range (close to the mean, so the sum of
+    squares does not cancel when the spread is small).*/
+template <typename Errors>
+static Partial ReduceRange(const Errors& errors, unsigned int begin, unsigned int end)
+{
+  Partial result = {0, 0.0, 0.0, 0.0};
+  if (begin >= end)
+    return result;
+
+  const double reference = errors(begin);
+  CompensatedSum sum, sum2;
+  double max = 0.0;
+
+  for (unsigned int block=begin; block<end; block+=std::min(BLOCK_SIZE,end-block))
+  {
+    const unsigned int blockEnd = block + std::min(BLOCK_SIZE,end-block);
+
+    double s[LANES] = {0.0}, s2[LANES] = {0.0}, m[LANES] = {0.0};
+    unsigned int i = block;
+    for (; i+LANES<=blockEnd; i+=LANES)
+    {
+      for (unsigned int l=0; l<LANES; l++)
+      {
+        const double error = errors(i+l);
+        const double d = error - reference;
+        s[l] += d;
+        s2[l] += d*d;
+        m[l] = std::max(m[l],error);
+      }
+    }
+    for (; i<blockEnd; i++)
+    {
+      const double error = errors(i);
+      const double d = error - reference;
+      s[0] += d;
+      s2[0] += d*d;
+      m[0] = std::max(m[0],error);
+    }
+
+    sum.Add((s[0] + s[1]) + (s[2] + s[3]));
+    sum2.Add((s2[0] + s2[1]) + (s2[2] + s2[3]));
+    max = std::max(max,std::max(std::max(m[0],m[1]),std::max(m[2],m[3])));
+  }
+
+  const double n = end - begin;
+  result.count = end - begin;
+  result.mean = reference + sum.sum/n;
+  result.m2 = std::max(0.0,sum2.sum - sum.sum*sum.sum/n);
+  result.max = max;
+  return result;
+}
+
+static ErrorStatistics ToStatistics(const Partial& partial)
+{
+  ErrorStatistics statistics = {partial.count, 0.0, 0.0, 0.0, 0.0};
+  if (partial.count == 0)
+    return statistics;
+
+  const double variance = partial.m2/partial.count;
+  statistics.mean = partial.mean;
+  statistics.std = std::sqrt(variance);
+  statistics.rms = std::sqrt(partial.mean*partial.mean + variance);
+  statistics.max = partial.max;
+  return statistics;
+}
+
+/// contiguous ranges, this thread reduces the last one
+template <typename Errors>
+static ErrorStatistics ReduceParallel(const Errors& errors, unsigned int n, unsigned int threads)
+{
+  if (threads == 0)
+    threads = std::max(1u,std::thread::hardware_concurrency());
+  threads = std::max(1u,std::min(threads,n/MINIMUM_POINTS_PER_THREAD));
+
+  std::vector<Partial> partials(threads);
+  std::vector<std::thread> workers;
+  for (unsigned int w=0; w+1<threads; w++)
+  {
+    const unsigned int begin = static_cast<unsigned int>(static_cast<uint64_t>(n)*w/threads);
+    const unsigned int end = static_cast<unsigned int>(static_cast<uint64_t>(n)*(w+1)/threads);
+    workers.emplace_back([&errors,&partials,w,begin,end](){partials[w] = ReduceRange(errors,begin,end);});
+  }
+  partials.back() = ReduceRange(errors,static_cast<unsigned int>(static_cast<uint64_t>(n)*(threads-1)/threads),n);
+
+  for (std::thread& worker : workers)
+    worker.join();
+
+  // always merged in the same order, the result does not depend on the scheduling
+  Partial result = partials.front();
+  for (unsigned int w=1; w<threads; w++)
+    result = Merge(result,partials[w]);
+
+  return ToStatistics(result);
+}
+
+ErrorStatistics ErrorReduction::FromValues(const double* values, unsigned int n)
+{
+  return ToStatistics(ReduceRange(Values{values},0,n));
+}
+
+ErrorStatistics ErrorReduction::FromTransform(const RigidTransform& error, const float* points, unsigned int n,
+                                              unsigned int stride, unsigned int threads)
+{
+  return ReduceParallel(Displacements<float>(error,points,std::max(1u,stride)),n,threads);
+}
+
+ErrorStatistics ErrorReduction::FromTransform(const RigidTransform& error, const double* points, unsigned int n,
+                                              unsigned int stride, unsigned int threads)
+{
+  return ReduceParallel(Displacements<double>(error,points,std::max(1u,stride)),n,threads);
+}
+
+ErrorStatistics ErrorReduction::FromTransform(const RigidTransform& error, vtkPoints* points,
+                                              unsigned int samples, unsigned int threads)
+{
+  const unsigned int N = (points != nullptr) ? points->GetNumberOfPoints() : 0;
+  if (N == 0)
+    return ToStatistics(Partial{0, 0.0, 0.0, 0.0});
+
+  // exact: every vertex
+  if ((samples == 0) || (samples >= N))
+    samples = N;
+  const unsigned int stride = N/samples;
+
+  // the points are read from their array (vtkPoints::GetPoint is not thread safe)
+  vtkDataArray* data = points->GetData();
+  if (vtkFloatArray* floatData = vtkFloatArray::SafeDownCast(data))
+    return FromTransform(error,floatData->GetPointer(0),samples,stride,threads);
+  if (vtkDoubleArray* doubleData = vtkDoubleArray::SafeDownCast(data))
+    return FromTransform(error,doubleData->GetPointer(0),samples,stride,threads);
+
+  std::vector<double> copy(3*static_cast<size_t>(samples));
+  for (unsigned int i=0; i<samples; i++)
+    points->GetPoint(static_cast<vtkIdType>(i)*stride,&copy[3*static_cast<size_t>(i)]);
+  return FromTransform(error,copy.data(),samples,1,threads);
+}
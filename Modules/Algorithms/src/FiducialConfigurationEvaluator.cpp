@@ -0,0 +1,378 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include <vtkPolyData.h>
+
+#include <RigidTransformVtk.h>
+
+#include "FiducialConfigurationEvaluator.h"
+#include "CombinationGenerator.h"
+#include "PairedPointSolver.h"
+#include "Registration.h"
+
+using namespace std;
+
+namespace
+{
+  /// subsets per chunk, small enough to balance the threads and to stream the results often
+  const uint64_t CHUNK_SIZE = 256;
+  /// period of the progress report
+  const double REPORT_PERIOD = 1.0; // s
+
+  /// chunks of a worker, the owner takes them from the front and thieves from the back
+  struct ChunkQueue
+  {
+    std::mutex            mutex;
+    std::deque<unsigned>  chunks;
+  };
+
+  bool TakeChunk(std::vector<std::unique_ptr<ChunkQueue> >& queues, unsigned int worker, unsigned int& chunk, std::atomic<unsigned int>& stolen)
+  {
+    {
+      ChunkQueue& own = *queues[worker];
+      std::lock_guard<std::mutex> lock(own.mutex);
+      if (!own.chunks.empty())
+      {
+        chunk = own.chunks.front();
+        own.chunks.pop_front();
+        return true;
+      }
+    }
+
+    // no chunk is ever added, so all the queues are empty when stealing fails
+    for (unsigned int v=1; v<queues.size(); v++)
+    {
+      ChunkQueue& victim = *queues[(worker+v) % queues.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.chunks.empty())
+      {
+        chunk = victim.chunks.back();
+        victim.chunks.pop_back();
+        stolen++;
+        return true;
+      }
+    }
+    return false;
+  }
+}
+
+FiducialConfigurationEvaluator::FiducialConfigurationEvaluator() :
+  mHasModelB(false),
+  mSubsetSize(3),
+  mFLE(0.0),
+  mNumberOfThreads(0),
+  mInverseReferenceA(RigidTransform::Identity()),
+  mInverseReferenceB(RigidTransform::Identity()),
+  mAbort(false),
+  mEvaluated(0),
+  mThroughput(0.0)
+{
+}
+
+bool FiducialConfigurationEvaluator::SetModel(Model& model, const mitk::PointSet* planned, const mitk::PointSet* real, int markerType)
+{
+  model.fixed.clear();
+  model.moving.clear();
+  model.markerType = markerType;
+  if ((planned == nullptr) || (real == nullptr))
+    return false;
+
+  // paired by order, as in PerformPairedPointsRegistration
+  auto pIt = planned->Begin();
+  for (auto rIt = real->Begin(); (rIt != real->End()) && (pIt != planned->End()); ++rIt, ++pIt)
+  {
+    for (unsigned int i=0; i<3; i++)
+    {
+      model.fixed.push_back(pIt->Value()[i]);
+      model.moving.push_back(rIt->Value()[i]);
+    }
+  }
+  return !model.fixed.empty();
+}
+
+bool FiducialConfigurationEvaluator::SetModelA(const mitk::PointSet* planned, const mitk::PointSet* real, int markerType)
+{
+  return SetModel(mModelA,planned,real,markerType);
+}
+
+bool FiducialConfigurationEvaluator::SetModelB(const mitk::PointSet* planned, const mitk::PointSet* real, int markerType)
+{
+  mHasModelB = SetModel(mModelB,planned,real,markerType);
+  return mHasModelB;
+}
+
+void FiducialConfigurationEvaluator::SetTargetSurface(vtkPolyData* pd, int npoints)
+{
+  mTargets.clear();
+  if ((pd == nullptr) || (npoints <= 0) || (pd->GetNumberOfPoints() == 0))
+    return;
+
+  // same evenly spaced points as EstimateTREFromMatrix, copied once: vtkPolyData::GetPoint is not thread safe
+  const vtkIdType N = pd->GetNumberOfPoints();
+  const vtkIdType n = std::min<vtkIdType>(npoints,N);
+  const vtkIdType step = N/n;
+  mTargets.resize(3*n);
+  for (vtkIdType i=0; i<n; i++)
+    pd->GetPoint(i*step,&mTargets[3*i]);
+}
+
+uint64_t FiducialConfigurationEvaluator::GetNumberOfSubsets() const
+{
+  CombinationGenerator generator(mModelA.fixed.size()/3,mSubsetSize);
+  generator.SetExcludedIds(mExcludedIds);
+  return generator.GetNumberOfCombinations();
+}
+
+bool FiducialConfigurationEvaluator::EvaluateModel(const Model& model, const RigidTransform& inverseReference, const unsigned int* ids, SubsetMetrics& metrics) const
+{
+  const unsigned int k = mSubsetSize;
+
+  metrics.dist.resize(k);
+  const PairedPointResult registration = PairedPointSolver::Solve(model.fixed.data(),model.moving.data(),ids,k,metrics.dist.data());
+  if (!registration.valid)
+    return false;
+
+  metrics.transform = registration.transform;
+  Registration::GetErrorMetricsFromDistances(metrics.dist.data(),k,metrics.mean,metrics.stdDev,metrics.fre,metrics.fle);
+
+  // error of the subset registration in planned space, against the registration with all the points
+  const RigidTransform error = registration.transform * inverseReference;
+  Registration::GetAngleAndOffsetErrorFromTransform(error,metrics.offset,metrics.angle);
+  metrics.tre = mTargets.empty() ? -1.0 : Registration::EstimateTREFromTransform(error,mTargets.data(),mTargets.size()/3);
+
+  return true;
+}
+
+bool FiducialConfigurationEvaluator::Evaluate(const unsigned int* ids, RegistrationPointsMetrics& metrics) const
+{
+  metrics.FLE = mFLE;
+
+  SubsetMetrics a;
+  metrics.A_combination.assign(ids,ids+mSubsetSize);
+  metrics.A_markerType = mModelA.markerType;
+  metrics.A_nFiducials = mSubsetSize;
+  if (!EvaluateModel(mModelA,mInverseReferenceA,ids,a))
+    return false;
+
+  metrics.A_matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  RigidTransformToVtk(a.transform,metrics.A_matrix);
+  metrics.A_dist = std::move(a.dist);
+  metrics.A_mean = a.mean;
+  metrics.A_std = a.stdDev;
+  metrics.A_FRE = a.fre;
+  metrics.A_FLE = a.fle;
+  metrics.A_TRE = a.tre;
+  metrics.A_offset = a.offset;
+  metrics.A_angle = a.angle;
+
+  if (!mHasModelB)
+    return true;
+
+  SubsetMetrics b;
+  metrics.B_combination = metrics.A_combination;
+  metrics.B_markerType = mModelB.markerType;
+  metrics.B_nFiducials = mSubsetSize;
+  if (!EvaluateModel(mModelB,mInverseReferenceB,ids,b))
+    return false;
+
+  metrics.B_matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  RigidTransformToVtk(b.transform,metrics.B_matrix);
+  metrics.B_dist = std::move(b.dist);
+  metrics.B_mean = b.mean;
+  metrics.B_std = b.stdDev;
+  metrics.B_FRE = b.fre;
+  metrics.B_FLE = b.fle;
+  metrics.B_TRE = b.tre;
+  metrics.B_offset = b.offset;
+  metrics.B_angle = b.angle;
+
+  // dissociated navigation: model B registration against the model A one
+  Registration::GetAngleAndOffsetErrorFromTransform(b.transform * a.transform.Inverse(),metrics.offset,metrics.angle);
+
+  return true;
+}
+
+bool FiducialConfigurationEvaluator::Run(std::vector<RegistrationPointsMetrics>& results)
+{
+  results.clear();
+  mAbort = false;
+  mEvaluated = 0;
+  mThroughput = 0.0;
+
+  const unsigned int n = mModelA.fixed.size()/3;
+  if (mHasModelB && (mModelB.fixed.size() != mModelA.fixed.size()))
+  {
+    cout << "ERROR: models A and B have a different number of registration points" << std::endl;
+    return false;
+  }
+  if ((mSubsetSize < 3) || (mSubsetSize > n))
+  {
+    cout << "ERROR: cannot evaluate subsets of " << mSubsetSize << " points out of " << n << std::endl;
+    return false;
+  }
+
+  CombinationGenerator generator(n,mSubsetSize);
+  generator.SetExcludedIds(mExcludedIds);
+  const uint64_t total = generator.GetNumberOfCombinations();
+  if (total == 0)
+  {
+    cout << "ERROR: not enough registration points after excluding " << mExcludedIds.size() << std::endl;
+    return false;
+  }
+
+  // reference registrations, with all the points that are not excluded
+  std::vector<unsigned int> allowed;
+  for (unsigned int id=0; id<n; id++)
+    if (std::find(mExcludedIds.begin(),mExcludedIds.end(),id) == mExcludedIds.end())
+      allowed.push_back(id);
+
+  const PairedPointResult referenceA = PairedPointSolver::Solve(mModelA.fixed.data(),mModelA.moving.data(),allowed.data(),allowed.size());
+  const PairedPointResult referenceB = mHasModelB ? PairedPointSolver::Solve(mModelB.fixed.data(),mModelB.moving.data(),allowed.data(),allowed.size()) : referenceA;
+  if (!referenceA.valid || !referenceB.valid)
+  {
+    cout << "ERROR: degenerate registration with all the points" << std::endl;
+    return false;
+  }
+  mInverseReferenceA = referenceA.transform.Inverse();
+  mInverseReferenceB = referenceB.transform.Inverse();
+
+  try
+  {
+    results.resize(total);
+  }
+  catch (const std::bad_alloc&)
+  {
+    cout << "ERROR: not enough memory to store the metrics of " << total << " subsets" << std::endl;
+    return false;
+  }
+
+  const unsigned int threads = (mNumberOfThreads > 0) ? mNumberOfThreads : std::max(1u,std::thread::hardware_concurrency());
+  const unsigned int chunks = std::min<uint64_t>(total,std::max<uint64_t>(threads,total/CHUNK_SIZE));
+
+  // round robin, so the lowest chunks are evaluated first and the results can be streamed in order
+  std::vector<std::unique_ptr<ChunkQueue> > queues;
+  for (unsigned int w=0; w<threads; w++)
+    queues.emplace_back(new ChunkQueue);
+  for (unsigned int c=0; c<chunks; c++)
+    queues[c % threads]->chunks.push_back(c);
+
+  std::unique_ptr<std::atomic<bool>[]> done(new std::atomic<bool>[chunks]);
+  for (unsigned int c=0; c<chunks; c++)
+    done[c] = false;
+
+  std::mutex progressMutex;
+  std::condition_variable progress;
+  unsigned int finishedWorkers = 0;
+  std::atomic<unsigned int> stolen(0);
+  std::atomic<uint64_t> degenerate(0);
+
+  auto worker = [&](unsigned int w)
+  {
+    std::vector<unsigned int> ids(mSubsetSize);
+    unsigned int chunk;
+    while (!mAbort && TakeChunk(queues,w,chunk,stolen))
+    {
+      uint64_t begin, end;
+      generator.GetChunk(chunk,chunks,begin,end);
+
+      generator.Unrank(begin,ids.data());
+      for (uint64_t rank=begin; rank<end; rank++)
+      {
+        if (!Evaluate(ids.data(),results[rank]))
+          degenerate++;
+        generator.Next(ids.data());
+      }
+
+      mEvaluated += end-begin;
+      done[chunk].store(true,std::memory_order_release);
+    }
+
+    std::lock_guard<std::mutex> lock(progressMutex);
+    finishedWorkers++;
+    progress.notify_all();
+  };
+
+  cout << "Evaluating " << total << " subsets of " << mSubsetSize << " points with " << threads << " threads" << std::endl;
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (unsigned int w=0; w<threads; w++)
+    workers.emplace_back(worker,w);
+
+  // this thread writes the completed prefix of the results and reports the progress
+  bool streaming = !mOutputFile.isEmpty();
+  bool outputError = false;
+  unsigned int flushedChunks = 0;
+  double lastReport = 0.0;
+  for (;;)
+  {
+    // read before flushing, so the chunks completed before the workers finished are written
+    bool finished;
+    {
+      std::lock_guard<std::mutex> lock(progressMutex);
+      finished = (finishedWorkers == threads);
+    }
+
+    unsigned int completedChunks = flushedChunks;
+    while ((completedChunks < chunks) && done[completedChunks].load(std::memory_order_acquire))
+      completedChunks++;
+
+    if (streaming && (completedChunks > flushedChunks))
+    {
+      uint64_t begin, end, unused;
+      generator.GetChunk(flushedChunks,chunks,begin,unused);
+      generator.GetChunk(completedChunks-1,chunks,unused,end);
+      if (!RegistrationPointsMetrics::ExportMetricsToFile(results.data()+begin,end-begin,mOutputFile))
+      {
+        cout << "ERROR: could not write the metrics to " << mOutputFile.toStdString() << ", streaming stopped" << std::endl;
+        streaming = false;
+        outputError = true;
+      }
+    }
+    flushedChunks = completedChunks;
+
+    if (finished)
+      break;
+
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if (elapsed - lastReport >= REPORT_PERIOD)
+    {
+      lastReport = elapsed;
+      cout << "Evaluated " << mEvaluated << "/" << total << " subsets (" << mEvaluated/elapsed << " subsets/s)" << std::endl;
+    }
+
+    std::unique_lock<std::mutex> lock(progressMutex);
+    progress.wait_for(lock,std::chrono::milliseconds(100),[&]{return finishedWorkers == threads;});
+  }
+
+  for (std::thread& t : workers)
+    t.join();
+
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  mThroughput = (elapsed > 0.0) ? mEvaluated/elapsed : 0.0;
+
+  cout << "Evaluated " << mEvaluated << " subsets in " << elapsed << " s: " << mThroughput << " subsets/s, "
+       << stolen << " chunks stolen, " << degenerate << " degenerate subsets" << std::endl;
+
+  if (mAbort)
+  {
+    cout << "Subsets evaluation aborted" << std::endl;
+    return false;
+  }
+
+  return !outputError;
+}
@@ -0,0 +1,214 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <iostream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+#include "MonteCarloTRESimulator.h"
+#include "PairedPointSolver.h"
+#include "Statistics.h"
+
+using namespace std;
+
+/// trials taken at once by a worker
+static const unsigned int TRIAL_BATCH = 64;
+
+/// copies the points of a point set, x,y,z contiguous
+static void CopyPoints(const mitk::PointSet* ps, std::vector<double>& points)
+{
+  points.clear();
+  if (ps == nullptr)
+    return;
+
+  for (auto it = ps->Begin(); it != ps->End(); ++it)
+    for (unsigned int i=0; i<3; i++)
+      points.push_back(it->Value()[i]);
+}
+
+MonteCarloTRESimulator::MonteCarloTRESimulator() :
+  mNoiseRotation(RigidTransform::Identity()),
+  mNumberOfTrials(10000),
+  mSeed(Statistics::GetRandomSeed()),
+  mNumberOfThreads(0),
+  mPercentiles{50.0, 90.0, 95.0, 99.0},
+  mDegenerateTrials(0),
+  mAbort(false)
+{
+  SetIsotropicFLE(0.0);
+}
+
+void MonteCarloTRESimulator::SetFiducials(const mitk::PointSet* fiducials)
+{
+  CopyPoints(fiducials,mFiducials);
+}
+
+void MonteCarloTRESimulator::SetTargets(const mitk::PointSet* targets)
+{
+  CopyPoints(targets,mTargets);
+}
+
+void MonteCarloTRESimulator::SetTargets(const double* targets, unsigned int n)
+{
+  mTargets.assign(targets,targets+3*n);
+}
+
+void MonteCarloTRESimulator::SetIsotropicFLE(double fle)
+{
+  // the rms 3D error is split evenly among the axes
+  const double sigma[3] = {fle/std::sqrt(3.0), fle/std::sqrt(3.0), fle/std::sqrt(3.0)};
+  SetAnisotropicFLE(sigma);
+}
+
+void MonteCarloTRESimulator::SetAnisotropicFLE(const double sigma[3], const Quaternion& orientation)
+{
+  for (unsigned int i=0; i<3; i++)
+    mSigma[i] = sigma[i];
+
+  const double zero[3] = {0.0, 0.0, 0.0};
+  mNoiseRotation = RigidTransform::FromQuaternion(orientation.Normalized(),zero);
+}
+
+bool MonteCarloTRESimulator::SimulateTrial(unsigned int trial, PhiloxRandom& generator, std::vector<double>& noise, std::vector<double>& moving)
+{
+  const unsigned int nFiducials = mFiducials.size()/3;
+  const unsigned int nTargets = mTargets.size()/3;
+
+  // all the noise of the trial at once, then scaled and rotated to the noise frame
+  generator.SetStream(trial);
+  generator.Normal(noise.data(),noise.size());
+  for (unsigned int p=0; p<nFiducials; p++)
+  {
+    const double scaled[3] = {mSigma[0]*noise[3*p], mSigma[1]*noise[3*p+1], mSigma[2]*noise[3*p+2]};
+    mNoiseRotation.TransformVector(scaled,&moving[3*p]);
+  }
+  for (unsigned int k=0; k<moving.size(); k++)
+    moving[k] += mFiducials[k];
+
+  // the true registration is the identity, the targets move by the registration error
+  const PairedPointResult registration = PairedPointSolver::Solve(mFiducials.data(),moving.data(),nFiducials);
+  if (!registration.valid)
+  {
+    for (unsigned int t=0; t<nTargets; t++)
+      mTRE[t*mNumberOfTrials + trial] = std::numeric_limits<double>::quiet_NaN();
+    return false;
+  }
+
+  for (unsigned int t=0; t<nTargets; t++)
+  {
+    const double* target = &mTargets[3*t];
+    double transformed[3];
+    registration.transform.TransformPoint(target,transformed);
+    const double d[3] = {transformed[0]-target[0], transformed[1]-target[1], transformed[2]-target[2]};
+    mTRE[t*mNumberOfTrials + trial] = std::sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+  }
+  return true;
+}
+
+bool MonteCarloTRESimulator::Run()
+{
+  mResults.clear();
+  mDegenerateTrials = 0;
+  mAbort = false;
+
+  const unsigned int nFiducials = mFiducials.size()/3;
+  const unsigned int nTargets = mTargets.size()/3;
+  if ((nFiducials < 3) || (nTargets == 0) || (mNumberOfTrials == 0))
+  {
+    cout << "ERROR: TRE simulation requires 3 fiducials, a target and a trial (" << nFiducials << ", "
+         << nTargets << ", " << mNumberOfTrials << " given)" << std::endl;
+    return false;
+  }
+
+  mTRE.assign(static_cast<size_t>(nTargets)*mNumberOfTrials,0.0);
+
+  const unsigned int threads = (mNumberOfThreads > 0) ? mNumberOfThreads : std::max(1u,std::thread::hardware_concurrency());
+  std::atomic<unsigned int> nextTrial(0);
+
+  auto worker = [&]()
+  {
+    // per thread generator and buffers, re-keyed with the stream of every trial
+    PhiloxRandom generator(mSeed);
+    std::vector<double> noise(3*nFiducials);
+    std::vector<double> moving(3*nFiducials);
+
+    while (!mAbort)
+    {
+      const unsigned int begin = nextTrial.fetch_add(TRIAL_BATCH);
+      if (begin >= mNumberOfTrials)
+        break;
+
+      const unsigned int end = std::min(begin + TRIAL_BATCH, mNumberOfTrials);
+      for (unsigned int trial=begin; trial<end; trial++)
+        if (!SimulateTrial(trial,generator,noise,moving))
+          mDegenerateTrials++;
+    }
+  };
+
+  const auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> workers;
+  for (unsigned int w=0; w<threads; w++)
+    workers.emplace_back(worker);
+  for (std::thread& t : workers)
+    t.join();
+
+  if (mAbort)
+  {
+    cout << "TRE simulation aborted" << std::endl;
+    return false;
+  }
+
+  // distributions, ignoring the degenerate trials
+  std::vector<double> values;
+  values.reserve(mNumberOfTrials);
+  mResults.resize(nTargets);
+  for (unsigned int t=0; t<nTargets; t++)
+  {
+    values.clear();
+    for (unsigned int trial=0; trial<mNumberOfTrials; trial++)
+    {
+      const double tre = mTRE[t*mNumberOfTrials + trial];
+      if (!std::isnan(tre))
+        values.push_back(tre);
+    }
+
+    TREDistribution& distribution = mResults[t];
+    distribution.mean = distribution.rms = distribution.max = 0.0;
+    distribution.percentiles.assign(mPercentiles.size(),0.0);
+    if (values.empty())
+      continue;
+
+    std::sort(values.begin(),values.end());
+    for (double tre : values)
+    {
+      distribution.mean += tre;
+      distribution.rms += tre*tre;
+    }
+    distribution.mean /= values.size();
+    distribution.rms = std::sqrt(distribution.rms / values.size());
+    distribution.max = values.back();
+
+    // linear interpolation between the closest ranks
+    for (unsigned int p=0; p<mPercentiles.size(); p++)
+    {
+      const double position = std::min(std::max(mPercentiles[p],0.0),100.0) / 100.0 * (values.size()-1);
+      const size_t below = static_cast<size_t>(position);
+      const size_t above = std::min(below+1,values.size()-1);
+      distribution.percentiles[p] = values[below] + (position-below)*(values[above]-values[below]);
+    }
+  }
+
+  const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  cout << "Simulated " << mNumberOfTrials << " trials with " << nFiducials << " fiducials and " << nTargets << " targets in "
+       << elapsed << " s (" << mNumberOfTrials/elapsed << " trials/s), " << mDegenerateTrials << " degenerate" << std::endl;
+
+  return true;
+}
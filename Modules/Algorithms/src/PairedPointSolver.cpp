@@ -0,0 +1,219 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <cmath>
+
+#include "PairedPointSolver.h"
+
+namespace
+{
+  /// ids of the pairs used from the point arrays
+  struct AllPoints
+  {
+    inline unsigned int operator[](unsigned int p) const {return p;}
+  };
+
+  struct SelectedPoints
+  {
+    const unsigned int* ids;
+    inline unsigned int operator[](unsigned int p) const {return ids[p];}
+  };
+}
+
+/*  Eigenvector of the largest eigenvalue of a symmetric 4x4 matrix (destroyed). Returns the
+    difference with the second largest eigenvalue: the rotation is undetermined if it is null.*/
+static double LargestEigenvector(double N[4][4], double v[4])
+{
+  double V[4][4] = {{1.0,0.0,0.0,0.0},{0.0,1.0,0.0,0.0},{0.0,0.0,1.0,0.0},{0.0,0.0,0.0,1.0}};
+
+  double norm2 = 0.0;
+  for (unsigned int i=0; i<4; i++)
+    for (unsigned int j=0; j<4; j++)
+      norm2 += N[i][j]*N[i][j];
+
+  // cyclic Jacobi rotations, converges quadratically (a few sweeps for 4x4)
+  for (unsigned int sweep=0; sweep<50; sweep++)
+  {
+    double off2 = 0.0;
+    for (unsigned int p=0; p<3; p++)
+      for (unsigned int q=p+1; q<4; q++)
+        off2 += N[p][q]*N[p][q];
+    if (off2 <= 1e-30*norm2)
+      break;
+
+    for (unsigned int p=0; p<3; p++)
+    {
+      for (unsigned int q=p+1; q<4; q++)
+      {
+        if (N[p][q] == 0.0)
+          continue;
+
+        const double theta = (N[q][q] - N[p][p]) / (2.0*N[p][q]);
+        const double t = ((theta >= 0.0) ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta*theta + 1.0));
+        const double c = 1.0 / std::sqrt(t*t + 1.0);
+        const double s = t*c;
+
+        for (unsigned int k=0; k<4; k++)
+        {
+          const double nkp = N[k][p], nkq = N[k][q];
+          N[k][p] = c*nkp - s*nkq;
+          N[k][q] = s*nkp + c*nkq;
+        }
+        for (unsigned int k=0; k<4; k++)
+        {
+          const double npk = N[p][k], nqk = N[q][k];
+          N[p][k] = c*npk - s*nqk;
+          N[q][k] = s*npk + c*nqk;
+        }
+        for (unsigned int k=0; k<4; k++)
+        {
+          const double vkp = V[k][p], vkq = V[k][q];
+          V[k][p] = c*vkp - s*vkq;
+          V[k][q] = s*vkp + c*vkq;
+        }
+      }
+    }
+  }
+
+  // eigenvalues are on the diagonal, eigenvectors in the columns of V
+  unsigned int largest = 0;
+  for (unsigned int i=1; i<4; i++)
+    if (N[i][i] > N[largest][largest])
+      largest = i;
+
+  double second = -HUGE_VAL;
+  for (unsigned int i=0; i<4; i++)
+    if ((i != largest) && (N[i][i] > second))
+      second = N[i][i];
+
+  for (unsigned int k=0; k<4; k++)
+    v[k] = V[k][largest];
+
+  return N[largest][largest] - second;
+}
+
+/*  Horn, "Closed-form solution of absolute orientation using unit quaternions", JOSA A 4(4), 1987.
+    The moving points are rotated onto the fixed ones after removing their centroids.*/
+template <typename Ids>
+static PairedPointResult SolvePairs(const double* fixed, const double* moving, const Ids& ids, unsigned int n,
+                                    double* residuals)
+{
+  PairedPointResult result;
+  result.transform = RigidTransform::Identity();
+  result.fre = result.meanError = result.maxError = 0.0;
+  result.valid = false;
+
+  if (n < 3)
+    return result;
+
+  double fixedCenter[3] = {0.0, 0.0, 0.0};
+  double movingCenter[3] = {0.0, 0.0, 0.0};
+  for (unsigned int p=0; p<n; p++)
+  {
+    const double* f = fixed + 3*ids[p];
+    const double* m = moving + 3*ids[p];
+    for (unsigned int i=0; i<3; i++)
+    {
+      fixedCenter[i] += f[i];
+      movingCenter[i] += m[i];
+    }
+  }
+  for (unsigned int i=0; i<3; i++)
+  {
+    fixedCenter[i] /= n;
+    movingCenter[i] /= n;
+  }
+
+  // cross-covariance S[i][j] = sum m'_i f'_j
+  double S[3][3] = {{0.0,0.0,0.0},{0.0,0.0,0.0},{0.0,0.0,0.0}};
+  double spread = 0.0;
+  for (unsigned int p=0; p<n; p++)
+  {
+    const double* f = fixed + 3*ids[p];
+    const double* m = moving + 3*ids[p];
+    const double fc[3] = {f[0]-fixedCenter[0], f[1]-fixedCenter[1], f[2]-fixedCenter[2]};
+    const double mc[3] = {m[0]-movingCenter[0], m[1]-movingCenter[1], m[2]-movingCenter[2]};
+    for (unsigned int i=0; i<3; i++)
+    {
+      for (unsigned int j=0; j<3; j++)
+        S[i][j] += mc[i]*fc[j];
+      spread += mc[i]*mc[i] + fc[i]*fc[i];
+    }
+  }
+
+  double N[4][4];
+  N[0][0] = S[0][0] + S[1][1] + S[2][2];
+  N[1][1] = S[0][0] - S[1][1] - S[2][2];
+  N[2][2] = -S[0][0] + S[1][1] - S[2][2];
+  N[3][3] = -S[0][0] - S[1][1] + S[2][2];
+  N[0][1] = N[1][0] = S[1][2] - S[2][1];
+  N[0][2] = N[2][0] = S[2][0] - S[0][2];
+  N[0][3] = N[3][0] = S[0][1] - S[1][0];
+  N[1][2] = N[2][1] = S[0][1] + S[1][0];
+  N[1][3] = N[3][1] = S[2][0] + S[0][2];
+  N[2][3] = N[3][2] = S[1][2] + S[2][1];
+
+  // coincident or collinear points leave the rotation undetermined
+  double q[4];
+  const double gap = LargestEigenvector(N,q);
+  if (!(spread > 0.0) || (gap <= 1e-10*spread))
+    return result;
+
+  const Quaternion rotation = Quaternion{q[0],q[1],q[2],q[3]}.Normalized();
+  result.transform = RigidTransform::FromQuaternion(rotation,fixedCenter);
+  double rotatedCenter[3];
+  result.transform.TransformVector(movingCenter,rotatedCenter);
+  for (unsigned int i=0; i<3; i++)
+    result.transform.translation[i] -= rotatedCenter[i];
+
+  // residuals
+  double sum2 = 0.0;
+  for (unsigned int p=0; p<n; p++)
+  {
+    const double* f = fixed + 3*ids[p];
+    double t[3];
+    result.transform.TransformPoint(moving + 3*ids[p],t);
+    const double dist2 = (t[0]-f[0])*(t[0]-f[0]) + (t[1]-f[1])*(t[1]-f[1]) + (t[2]-f[2])*(t[2]-f[2]);
+    const double dist = std::sqrt(dist2);
+
+    sum2 += dist2;
+    result.meanError += dist;
+    if (dist > result.maxError)
+      result.maxError = dist;
+    if (residuals != nullptr)
+      residuals[p] = dist;
+  }
+  result.meanError /= n;
+  result.fre = std::sqrt(sum2/n);
+  result.valid = true;
+
+  return result;
+}
+
+PairedPointResult PairedPointSolver::Solve(const double* fixed, const double* moving, unsigned int n, double* residuals)
+{
+  return SolvePairs(fixed,moving,AllPoints(),n,residuals);
+}
+
+PairedPointResult PairedPointSolver::Solve(const double* fixed, const double* moving, const unsigned int* ids, unsigned int n, double* residuals)
+{
+  return SolvePairs(fixed,moving,SelectedPoints{ids},n,residuals);
+}
+
+unsigned int PairedPointSolver::SolveSubsets(const double* fixed, const double* moving, const unsigned int* subsets,
+                                             unsigned int subsetSize, unsigned int count, PairedPointResult* results)
+{
+  unsigned int valid = 0;
+  for (unsigned int s=0; s<count; s++)
+  {
+    results[s] = SolvePairs(fixed,moving,SelectedPoints{subsets + s*subsetSize},subsetSize,nullptr);
+    if (results[s].valid)
+      valid++;
+  }
+  return valid;
+}
@@ -6,22 +6,20 @@ navCAS navigation system
 
 ===================================================================*/
 
+#include <algorithm>
 #include <iostream>
 
-// itk
-#include <itkVersorRigid3DTransform.h>
-#include <itkLandmarkBasedTransformInitializer.h>
-#include <itkRigid3DTransform.h>
-
 // vtk
 #include <vtkSmartPointer.h>
 #include <vtkPoints.h>
 #include <vtkMath.h>
-#include <vtkTransform.h>
 #include <vtkPolyData.h>
 
+#include <RigidTransformVtk.h>
+
 #include "Registration.h"
-#include "SurfaceRefinement.h"
+#include "ErrorReduction.h"
+#include "PairedPointSolver.h"
 
 using namespace std;
 
@@ -32,41 +30,23 @@ void Registration::GetErrorMetricsFromPairedPointRegistration(  const mitk::Poin
 {
   const unsigned int numberOfPoints = plannedPoints->GetSize();
 
-  distances.clear();
-  meanError = 0.0;
-  double fre2 = 0.0;
+  distances.resize(numberOfPoints);
   for (unsigned int i=0; i<numberOfPoints; i++)
-  {
-    double dist2 = vtkMath::Distance2BetweenPoints(transformedPoints->GetPoint(i).GetDataPointer(),plannedPoints->GetPoint(i).GetDataPointer());
-    double dist = sqrt(dist2);
-    //cout << "Error in point " << i << ": " << dist << " mm" << std::endl;
-    meanError += dist;
-    fre2 += dist2;
-
-    distances.push_back(dist);
-  }
+    distances[i] = sqrt(vtkMath::Distance2BetweenPoints(transformedPoints->GetPoint(i).GetDataPointer(),plannedPoints->GetPoint(i).GetDataPointer()));
 
-  meanError /= numberOfPoints;
-  fre2 /= numberOfPoints;
-  //cout << "Mean error: " << meanError << " mm" << std::endl;
-
-  // compute std
-  std = 0.0;
-  for (unsigned int i=0; i<numberOfPoints; i++)
-  {
-    double dist = sqrt(vtkMath::Distance2BetweenPoints(transformedPoints->GetPoint(i).GetDataPointer(),plannedPoints->GetPoint(i).GetDataPointer()));
-    std += pow(dist - meanError,2);
-  }
-  std /= numberOfPoints;
-  std = sqrt(std);
+  GetErrorMetricsFromDistances(distances.data(),numberOfPoints,meanError,std,fre,fle);
+}
 
-  //cout << "std: " << std << " mm" << std::endl;
+void Registration::GetErrorMetricsFromDistances(const double* distances, unsigned int numberOfPoints,
+                                                double &meanError, double &std, double &fre, double &fle)
+{
+  // single pass
+  const ErrorStatistics statistics = ErrorReduction::FromValues(distances,numberOfPoints);
 
-  //cout << "FRE^2: " << fre2 << " mm^2" << std::endl;
-  fre = sqrt(fre2);
-  //cout << "FRE (rms): " << fre << " mm" << std::endl;
-  fle = fre/(1.0-1.0/(2.0*numberOfPoints));
-  //cout << "Estimated FLE: " << fle << " mm" << std::endl;
+  meanError = statistics.mean;
+  std = statistics.std;
+  fre = statistics.rms;
+  fle = (numberOfPoints > 0) ? fre/(1.0-1.0/(2.0*numberOfPoints)) : 0.0;
 }
 
 vtkSmartPointer<vtkMatrix4x4> Registration::PerformPairedPointsRegistration(const mitk::PointSet::Pointer plannedPoints, const mitk::PointSet::Pointer realPoints, mitk::PointSet::Pointer transformedPoints, bool verbose)
@@ -76,65 +56,53 @@ vtkSmartPointer<vtkMatrix4x4> Registration::PerformPairedPointsRegistration(cons
     cout << "Real number of valid points: " << realPoints->GetSize() << std::endl;
     cout << "Planned points size: " << plannedPoints->GetSize() << std::endl;
   }
-  using Rigid3DTransformType = itk::VersorRigid3DTransform< double >;
 
-  typedef itk::Image<double,3> ImageType;
-  using LandmarkBasedTransformInitializerType = itk::LandmarkBasedTransformInitializer< Rigid3DTransformType, ImageType, ImageType >;
+  // Paired points as contiguous arrays (planned points are fixed, real points are moving)
+  std::vector<double> fixed;
+  std::vector<double> moving;
+  fixed.reserve(3*realPoints->GetSize());
+  moving.reserve(3*realPoints->GetSize());
 
-  LandmarkBasedTransformInitializerType::Pointer landmarkBasedTransformInitializer =
-    LandmarkBasedTransformInitializerType::New();
-  //  Create source and target landmarks.
-  using LandmarkContainerType = LandmarkBasedTransformInitializerType::LandmarkPointContainer;
-  using LandmarkPointType = LandmarkBasedTransformInitializerType::LandmarkPointType;
-  LandmarkContainerType fixedLandmarks;
-  LandmarkContainerType movingLandmarks;
-
-  // Add paired points for registration
   auto pIt = plannedPoints->Begin();
-  for (auto rIt = realPoints->Begin(); rIt != realPoints->End(); ++rIt, ++pIt)
+  for (auto rIt = realPoints->Begin(); (rIt != realPoints->End()) && (pIt != plannedPoints->End()); ++rIt, ++pIt)
   {
-    mitk::Point3D rPoint = rIt->Value();
-    mitk::Point3D pPoint = pIt->Value();
-
-    LandmarkPointType fixedPoint = pPoint.GetDataPointer();
-    LandmarkPointType movingPoint = rPoint.GetDataPointer();
-    fixedLandmarks.push_back(fixedPoint);
-    movingLandmarks.push_back(movingPoint);
+    for (unsigned int i=0; i<3; i++)
+    {
+      fixed.push_back(pIt->Value()[i]);
+      moving.push_back(rIt->Value()[i]);
+    }
   }
 
-  // Set points
-  landmarkBasedTransformInitializer->SetFixedLandmarks( fixedLandmarks );
-  landmarkBasedTransformInitializer->SetMovingLandmarks( movingLandmarks );
-
-  Rigid3DTransformType::Pointer transform = Rigid3DTransformType::New();
-  transform->SetIdentity();
-
-  landmarkBasedTransformInitializer->SetTransform(transform);
-  //landmarkBasedTransformInitializer->InitializeTransform();
-  landmarkBasedTransformInitializer->InitializeTransform();
+  const unsigned int numberOfPairs = fixed.size()/3;
+  const PairedPointResult registration = PairedPointSolver::Solve(fixed.data(),moving.data(),numberOfPairs);
+  if (!registration.valid)
+    cout << "ERROR: paired point registration requires at least 3 non collinear points (" << numberOfPairs << " given)" << std::endl;
 
   if (verbose)
   {
-    MITK_INFO << "Considered points: " << fixedLandmarks.size();
-    cout << "Center of rotation: " << transform->GetCenter() << std::endl;
-    cout << "Offset: " << transform->GetOffset() << std::endl;
-    cout << "Total translation: " << transform->GetTranslation() << std::endl;
-    cout << "Rotation matrix: " << std::endl << transform->GetMatrix() << std::endl;
+    double angle;
+    double axis[3];
+    registration.transform.GetQuaternion().GetAngleAxis(angle,axis);
+
+    MITK_INFO << "Considered points: " << numberOfPairs;
+    cout << "Angle: " << vtkMath::DegreesFromRadians(angle) << std::endl;
+    cout << "Versor: " << mitk::Vector3D(axis) << std::endl;
+    cout << "Translation: " << mitk::Vector3D(registration.transform.translation) << std::endl;
+    cout << "FRE: " << registration.fre << " mm" << std::endl;
   }
-  auto matrix = SurfaceRefinementThread::GetVtkRegistrationMatrix(static_cast<itk::Rigid3DTransform<double>*>(transform),verbose);
+
+  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  RigidTransformToVtk(registration.transform,matrix);
 
   if (transformedPoints.IsNotNull())
   {
     // Transform points
-    vtkSmartPointer<vtkTransform> registrationTransform = vtkSmartPointer<vtkTransform>::New();
-    registrationTransform->SetMatrix(matrix);
-    registrationTransform->Update();
-
     transformedPoints->Clear();
     for (auto rIt = realPoints->Begin(); rIt != realPoints->End(); ++rIt)
     {
-      mitk::Point3D rPoint = rIt->Value();
-      transformedPoints->InsertPoint(rIt->Index(),mitk::Point3D(registrationTransform->TransformDoublePoint(rPoint.GetDataPointer())));
+      mitk::Point3D tPoint;
+      registration.transform.TransformPoint(rIt->Value().GetDataPointer(),tPoint.GetDataPointer());
+      transformedPoints->InsertPoint(rIt->Index(),tPoint);
     }
   }
 
@@ -143,58 +111,27 @@ vtkSmartPointer<vtkMatrix4x4> Registration::PerformPairedPointsRegistration(cons
 
 void Registration::GetAngleAndOffsetErrorFromMatrix(const vtkMatrix4x4* matrix, double &offset, double &angle)
 {
-  double wxyz[4];
-  double translation[3];
-
-  vtkSmartPointer<vtkTransform> errorTransform = vtkSmartPointer<vtkTransform>::New();
-  errorTransform->SetMatrix(const_cast<vtkMatrix4x4*>(matrix));
-  errorTransform->Update();
-  //cout << "Total error transformation: " << std::endl;
-
-  errorTransform->GetOrientationWXYZ(wxyz);
-  angle = abs(wxyz[0]);
-  //cout << "Angle error: " << angle << " deg" << std::endl;
-
-  errorTransform->GetPosition(translation);
-  mitk::Vector3D offsetVec(translation);
-  offset = offsetVec.GetNorm();
+  GetAngleAndOffsetErrorFromTransform(RigidTransformFromVtk(matrix),offset,angle);
+}
 
-  if (angle > 180.0)
-    angle = 360.0 - angle;
-  //cout << "Offset error: " << offset << " mm" << std::endl;
+void Registration::GetAngleAndOffsetErrorFromTransform(const RigidTransform& error, double &offset, double &angle)
+{
+  // shortest rotation, in [0, 180] deg
+  angle = vtkMath::DegreesFromRadians(error.GetRotationAngle());
+  offset = error.GetTranslationNorm();
 }
 
 double Registration::EstimateTREFromMatrix(const vtkMatrix4x4* matrix, vtkPolyData* pd, const int npoints)
 {
-  auto transform = vtkSmartPointer<vtkTransform>::New();
-  transform->SetMatrix(const_cast<vtkMatrix4x4*>(matrix));
-  transform->Update();
+  if ((pd == nullptr) || (pd->GetPoints() == nullptr))
+    return 0.0;
 
-  //std::vector<mitk::Vector3D> dist;
-  //dist.reserve(npoints);
-
-  const int N = pd->GetNumberOfPoints();
-  const int step = N/npoints;
-  double sum = 0.0;
-  for (int i=0; i<npoints; ++i)
-  {
-    // pick pd point
-    const int id = i*step;
-    mitk::Point3D pdPoint(pd->GetPoint(id));
-
-    // transform using matrix
-    mitk::Point3D transformedPoint(transform->TransformDoublePoint(pdPoint.GetDataPointer()));
-
-    // store difference
-    //dist.push_back(pdPoint-transformedPoint);
-
-    // compute distance
-    double dist2 = vtkMath::Distance2BetweenPoints(pdPoint.GetDataPointer(),transformedPoint.GetDataPointer());
-    sum += dist2;
-  }
-
-  double mean = sqrt(sum / npoints);
-
-  return mean;
+  // the transform is applied to the vertices on the fly, in parallel
+  return ErrorReduction::FromTransform(RigidTransformFromVtk(matrix),pd->GetPoints(),std::max(npoints,0)).rms;
 }
 
+double Registration::EstimateTREFromTransform(const RigidTransform& error, const double* targets, unsigned int n)
+{
+  // the fiducial configuration evaluator calls it from its own threads
+  return ErrorReduction::FromTransform(error,targets,n,1,1).rms;
+}
@@ -8,69 +8,65 @@ navCAS navigation system
 
 #include <iostream>
 #include <algorithm>
+#include <atomic>
 #include <string>
-#include <random>
 
 #include <vtkSmartPointer.h>
 #include <vtkPoints.h>
 #include <vtkOBBTree.h>
 
 #include "Statistics.h"
+#include "CombinationGenerator.h"
+#include "PhiloxRandom.h"
 
 using namespace std;
 
+// global seed, and generation of the streams (increased with every new seed)
+static std::atomic<uint64_t> gRandomSeed(0);
+static std::atomic<uint64_t> gRandomGeneration(0);
+static std::atomic<uint64_t> gRandomStreams(0);
+
 std::vector<std::vector<int> > Statistics::comb(int N, int K)
 {
   std::vector<std::vector<int> > combinations;
+  if ((N < 0) || (K < 0))
+    return combinations;
+
+  // more ids than available: the single combination of all of them, as the former bitmask enumeration
+  K = std::min(K,N);
 
-  std::string bitmask(K, 1); // K leading 1's
-  bitmask.resize(N, 0); // N-K trailing 0's
+  // lexicographic order, as the ranks of CombinationGenerator
+  CombinationGenerator generator(N,K);
+  combinations.reserve(generator.GetNumberOfCombinations());
 
-  // print integers and permute bitmask
+  std::vector<unsigned int> ids(K);
+  generator.Unrank(0,ids.data());
   do
   {
-    std::vector<int> newCombination;
-    for (int i = 0; i < N; ++i) // [0..N-1] integers
-    {
-      if (bitmask[i]) newCombination.push_back(i);
-    }
-    combinations.push_back(newCombination);
-  } while (std::prev_permutation(bitmask.begin(), bitmask.end()));
+    combinations.emplace_back(ids.begin(),ids.end());
+  } while (generator.Next(ids.data()));
 
   return combinations;
 }
 
 void Statistics::removeCombinationsWithIds(std::vector<std::vector<int>>& combinations, unsigned int K, const std::vector<int>& excludeIds)
 {
+  if (combinations.empty())
+    return;
+
   const bool resizeMetrics = (combinations[0].size() - excludeIds.size() == K);
+  auto isExcluded = [&excludeIds](int id){return std::find(excludeIds.begin(),excludeIds.end(),id) != excludeIds.end();};
 
-  for (unsigned long c = 0; c<combinations.size(); ++c)
+  // single pass, the kept combinations are moved instead of erased one by one
+  if (resizeMetrics)
   {
-    auto& combination = combinations[c];
-
-    bool remove = false;
-    for (unsigned int i=0; i<excludeIds.size(); ++i)
-    {
-      auto it = std::find(combination.begin(),combination.end(),excludeIds[i]);
-      if (it != combination.end())
-      {
-        if (resizeMetrics)
-        {
-          combination.erase(it);
-        }
-        else
-        {
-          remove = true;
-          break;
-        }
-      }
-    }
-
-    if (remove)
-    {
-      combinations.erase(combinations.begin()+c);
-      --c;
-    }
+    for (auto& combination : combinations)
+      combination.erase(std::remove_if(combination.begin(),combination.end(),isExcluded),combination.end());
+  }
+  else
+  {
+    auto containsExcluded = [&isExcluded](const std::vector<int>& combination){return std::any_of(combination.begin(),combination.end(),isExcluded);};
+    combinations.erase(std::remove_if(combinations.begin(),combinations.end(),containsExcluded),combinations.end());
   }
 }
 
@@ -102,14 +98,42 @@ bool Statistics::getPointCloudMainAxes(const mitk::PointSet* ps, mitk::Vector3D
 
 void Statistics::AddNoiseToPoint(mitk::Point3D &point, double mean, double std)
 {
-  std::random_device rd;
-  std::mt19937 gen(rd());
+  // one stream per thread, created after every new seed
+  thread_local PhiloxRandom generator;
+  thread_local uint64_t generation = ~0ull;
+  if (generation != gRandomGeneration)
+  {
+    generation = gRandomGeneration;
+    generator.SetSeed(gRandomSeed);
+    generator.SetStream(gRandomStreams++);
+  }
 
   // add noise
+  double noise[3];
+  generator.Normal(noise,3);
   for (int i=0; i<3; ++i)
-  {
-    std::normal_distribution<double> distribution(mean,std);
-    double noise = distribution(gen);
-    point[i] += noise;
-  }
+    point[i] += mean + std*noise[i];
+}
+
+void Statistics::AddNoiseToPoint(mitk::Point3D &point, double mean, double std, uint64_t stream)
+{
+  // a pure function of the seed and the stream, whatever thread calls it
+  PhiloxRandom generator(gRandomSeed,stream);
+
+  double noise[3];
+  generator.Normal(noise,3);
+  for (int i=0; i<3; ++i)
+    point[i] += mean + std*noise[i];
+}
+
+void Statistics::SetRandomSeed(uint64_t seed)
+{
+  gRandomSeed = seed;
+  gRandomStreams = 0;
+  gRandomGeneration++;
+}
+
+uint64_t Statistics::GetRandomSeed()
+{
+  return gRandomSeed;
 }
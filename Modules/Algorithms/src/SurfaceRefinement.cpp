@@ -16,10 +16,14 @@ navCAS navigation system
 
 #include <vtkPolyData.h>
 #include <vtkCleanPolyData.h>
+#include <vtkMath.h>
 
 #include <mitkSurface.h>
 #include <mitkNodePredicateProperty.h>
 
+#include <RigidTransformItk.h>
+#include <RigidTransformVtk.h>
+
 #include "SurfaceRefinement.h"
 
 using namespace std;
@@ -28,80 +32,25 @@ using namespace std;
 
 vtkSmartPointer<vtkMatrix4x4> SurfaceRefinementThread::GetVtkRegistrationMatrix(itk::Rigid3DTransform<double>::Pointer transform, bool verbose)
 {
-  // Build 4x4 matrix
-  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  for (int i=0; i<3; i++)
-  {
-    for (int j=0; j<3; j++)
-      matrix->SetElement(i,j,transform->GetMatrix()[i][j]);//transposed matrix is (j,i)
+  // the ITK offset already includes the center of rotation, so the registration is its rigid inverse
+  const RigidTransform registration = RigidTransformFromItk(transform.GetPointer()).Inverse();
 
-    matrix->SetElement(i,3,transform->GetTranslation()[i]);
-  }
-  matrix->SetElement(3,0,0.0);
-  matrix->SetElement(3,1,0.0);
-  matrix->SetElement(3,2,0.0);
-  matrix->SetElement(3,3,1.0);
+  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  RigidTransformToVtk(registration,matrix);
 
-  /*
   if (verbose)
   {
-    cout << "Before invert: " << std::endl;
-    for (int i=0; i<4; i++)
-    {
-      for (int j =0; j<4; j++)
-        cout << matrix->GetElement(i,j) << " ";
+    double angle;
+    double axis[3];
+    registration.GetQuaternion().GetAngleAxis(angle,axis);
 
-      cout << std::endl;
-    }
-  }
-  */
-
-  matrix->Invert();
-
-  /*
-  if (verbose)
-  {
-    cout << "After invert: " << std::endl;
-    for (int i=0; i<4; i++)
-    {
-      for (int j =0; j<4; j++)
-        cout << matrix->GetElement(i,j) << " ";
-
-      cout << std::endl;
-    }
-  }
-  */
-
-  double center[3];
-  for (unsigned int i=0; i<3; i++)
-    center[i] = transform->GetCenter()[i];
-
-  vtkSmartPointer<vtkTransform> registrationTransform = vtkSmartPointer<vtkTransform>::New();
-  registrationTransform->Identity();
-  registrationTransform->Translate(-center[0],-center[1],-center[2]);
-  registrationTransform->PostMultiply();
-  registrationTransform->Concatenate(matrix);
-  registrationTransform->Translate(center);
-  registrationTransform->Update();
-
-  double wxyz[4];
-  registrationTransform->GetOrientationWXYZ(wxyz);
-  double axis[3];axis[0]=wxyz[1]; axis[1]=wxyz[2]; axis[2]=wxyz[3];
-
-  double translation[3];
-  translation[0] = matrix->GetElement(0,3);
-  translation[1] = matrix->GetElement(1,3);
-  translation[2] = matrix->GetElement(2,3);
-
-  if (verbose)
-  {
-    cout << "Angle: " << wxyz[0] << std::endl;
+    cout << "Angle: " << vtkMath::DegreesFromRadians(angle) << std::endl;
     cout << "Versor: " << mitk::Vector3D(axis) << std::endl;
     cout << "Translation: " << mitk::Vector3D(transform->GetTranslation()) << std::endl;
-    cout << "Translation after invert: " << mitk::Vector3D(translation) << std::endl;
+    cout << "Translation after invert: " << mitk::Vector3D(registration.translation) << std::endl;
   }
 
-  return registrationTransform->GetMatrix();
+  return matrix;
 }
 
 void SurfaceRefinementThread::run()
@@ -0,0 +1,193 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <iostream>
+
+#include <mitkSurface.h>
+#include <mitkLookupTable.h>
+#include <mitkLookupTableProperty.h>
+#include <mitkVtkScalarModeProperty.h>
+
+#include <vtkDoubleArray.h>
+#include <vtkLookupTable.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+
+#include "TREMap.h"
+#include "TREPredictor.h"
+
+using namespace std;
+
+static const char* TREArrayName = "Predicted TRE";
+
+// properties of the node overwritten by the map, restored when it is hidden
+static const char* ShownProperties[] = {"LookupTable", "ScalarsRangeMinimum", "ScalarsRangeMaximum",
+                                        "scalar visibility", "color mode", "scalar mode"};
+
+TREMap::TREMap() :
+  mFLE(0.5),
+  mMaximumTRE(0.0),
+  mCacheSize(8),
+  mCacheHits(0)
+{
+}
+
+void TREMap::SetCacheSize(unsigned int maps)
+{
+  mCacheSize = maps;
+  while (mCache.size() > mCacheSize)
+    mCache.pop_back();
+}
+
+vtkSmartPointer<vtkFloatArray> TREMap::Compute(vtkPolyData* pd, const mitk::PointSet* fiducials)
+{
+  if ((pd == nullptr) || (pd->GetPoints() == nullptr) || (fiducials == nullptr))
+    return nullptr;
+
+  // only the geometry of the surface matters, not its scalars (modified when showing the map)
+  Configuration configuration;
+  configuration.surface = pd;
+  configuration.surfaceTime = pd->GetPoints()->GetMTime();
+  configuration.fle = mFLE;
+  for (auto it = fiducials->Begin(); it != fiducials->End(); ++it)
+    for (unsigned int i=0; i<3; i++)
+      configuration.fiducials.push_back(it->Value()[i]);
+
+  for (auto it = mCache.begin(); it != mCache.end(); ++it)
+  {
+    if (it->first == configuration)
+    {
+      mCache.splice(mCache.begin(),mCache,it);
+      mCacheHits++;
+      return mCache.front().second;
+    }
+  }
+
+  TREPredictor predictor;
+  predictor.SetFLE(mFLE);
+  if (!predictor.SetFiducials(configuration.fiducials.data(),configuration.fiducials.size()/3))
+    return nullptr;
+
+  const vtkIdType n = pd->GetNumberOfPoints();
+  auto tre = vtkSmartPointer<vtkFloatArray>::New();
+  tre->SetName(TREArrayName);
+  tre->SetNumberOfValues(n);
+
+  // vertices are read from the array of the points (vtkPoints::GetPoint is not thread safe)
+  vtkDataArray* data = pd->GetPoints()->GetData();
+  if (vtkFloatArray* floatData = vtkFloatArray::SafeDownCast(data))
+    predictor.Predict(floatData->GetPointer(0),n,tre->GetPointer(0));
+  else if (vtkDoubleArray* doubleData = vtkDoubleArray::SafeDownCast(data))
+    predictor.Predict(doubleData->GetPointer(0),n,tre->GetPointer(0));
+  else
+  {
+    std::vector<double> points(3*n);
+    for (vtkIdType i=0; i<n; i++)
+      pd->GetPoint(i,&points[3*i]);
+    predictor.Predict(points.data(),n,tre->GetPointer(0));
+  }
+
+  mCache.emplace_front(configuration,tre);
+  while (mCache.size() > mCacheSize)
+    mCache.pop_back();
+
+  return tre;
+}
+
+bool TREMap::Show(mitk::DataNode* node, const mitk::PointSet* fiducials)
+{
+  mitk::Surface* surface = (node != nullptr) ? dynamic_cast<mitk::Surface*>(node->GetData()) : nullptr;
+  if (surface == nullptr)
+    return false;
+
+  vtkPolyData* pd = surface->GetVtkPolyData();
+  vtkSmartPointer<vtkFloatArray> tre = Compute(pd,fiducials);
+  if (tre.GetPointer() == nullptr)
+  {
+    Hide(node);
+    return false;
+  }
+
+  // another node (or another surface of the node) is colored
+  if (mShownNode.IsNotNull() && ((mShownNode.GetPointer() != node) || (mShownSurface.GetPointer() != pd)))
+    Hide(mShownNode);
+
+  vtkPointData* pointData = pd->GetPointData();
+  if (mShownNode.IsNull())
+  {
+    mShownNode = node;
+    mShownSurface = pd;
+    mPreviousScalars = pointData->GetScalars();
+    mPreviousProperties.clear();
+    for (const char* name : ShownProperties)
+    {
+      // a copy: setting a property of the same type assigns the existing one
+      mitk::BaseProperty* property = node->GetPropertyList()->GetProperty(name);
+      mPreviousProperties.push_back((property != nullptr) ? property->Clone() : nullptr);
+    }
+  }
+
+  // the map is an array of its own, selected while shown (SetScalars would remove the current scalars)
+  if (pointData->GetAbstractArray(TREArrayName) != tre.GetPointer())
+    pointData->AddArray(tre);
+  if (pointData->GetScalars() != tre.GetPointer())
+    pointData->SetActiveScalars(TREArrayName);
+
+  const double maximum = (mMaximumTRE > 0.0) ? mMaximumTRE : tre->GetRange()[1];
+
+  // green (accurate) to red, as RegistrationErrorVisualization
+  vtkSmartPointer<vtkLookupTable> lut = vtkSmartPointer<vtkLookupTable>::New();
+  lut->SetTableRange(0, maximum);
+  lut->SetSaturationRange(1, 1);
+  lut->SetHueRange(0.33, 0.0);
+  lut->SetValueRange(1, 1);
+  lut->Build();
+
+  mitk::LookupTable::Pointer mitkLut = mitk::LookupTable::New();
+  mitkLut->SetVtkLookupTable(lut);
+
+  node->SetProperty("LookupTable", mitk::LookupTableProperty::New(mitkLut));
+  node->SetFloatProperty("ScalarsRangeMinimum", 0.0);
+  node->SetFloatProperty("ScalarsRangeMaximum", maximum);
+  node->SetBoolProperty("scalar visibility", true);
+  node->SetBoolProperty("color mode", true);
+
+  mitk::VtkScalarModeProperty::Pointer scalarMode = mitk::VtkScalarModeProperty::New();
+  scalarMode->SetScalarModeToPointData();
+  node->SetProperty("scalar mode", scalarMode);
+
+  return true;
+}
+
+void TREMap::Hide(mitk::DataNode* node)
+{
+  if ((node == nullptr) || (node != mShownNode.GetPointer()))
+    return;
+
+  // the previous scalars may have no name, they are selected by index
+  vtkPointData* pointData = mShownSurface->GetPointData();
+  pointData->RemoveArray(TREArrayName);
+  for (int i=0; i<pointData->GetNumberOfArrays(); i++)
+    if ((mPreviousScalars.GetPointer() != nullptr) && (pointData->GetAbstractArray(i) == mPreviousScalars.GetPointer()))
+      pointData->SetActiveAttribute(i,vtkDataSetAttributes::SCALARS);
+
+  // without a previous property the node uses the default of its mapper again
+  for (unsigned int i=0; i<mPreviousProperties.size(); i++)
+  {
+    if (mPreviousProperties[i].IsNotNull())
+      node->GetPropertyList()->SetProperty(ShownProperties[i],mPreviousProperties[i]);
+    else
+      node->GetPropertyList()->DeleteProperty(ShownProperties[i]);
+  }
+
+  mShownNode = nullptr;
+  mShownSurface = nullptr;
+  mPreviousScalars = nullptr;
+  mPreviousProperties.clear();
+}
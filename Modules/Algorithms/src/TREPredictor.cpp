@@ -0,0 +1,140 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "TREPredictor.h"
+
+/// targets below which a single thread is faster than starting others
+static const unsigned int MINIMUM_TARGETS_PER_THREAD = 32768;
+
+TREPredictor::TREPredictor() :
+  mValid(false),
+  mNumberOfFiducials(0),
+  mFLE(0.0)
+{
+  for (unsigned int i=0; i<3; i++)
+  {
+    mCentroid[i] = 0.0;
+    for (unsigned int j=0; j<3; j++)
+      mM[i][j] = 0.0;
+  }
+}
+
+bool TREPredictor::SetFiducials(const double* fiducials, unsigned int n)
+{
+  mValid = false;
+  mNumberOfFiducials = n;
+  if (n < 3)
+    return false;
+
+  for (unsigned int i=0; i<3; i++)
+  {
+    mCentroid[i] = 0.0;
+    for (unsigned int p=0; p<n; p++)
+      mCentroid[i] += fiducials[3*p+i];
+    mCentroid[i] /= n;
+  }
+
+  double C[3][3] = {{0.0,0.0,0.0},{0.0,0.0,0.0},{0.0,0.0,0.0}};
+  for (unsigned int p=0; p<n; p++)
+  {
+    const double d[3] = {fiducials[3*p]-mCentroid[0], fiducials[3*p+1]-mCentroid[1], fiducials[3*p+2]-mCentroid[2]};
+    for (unsigned int i=0; i<3; i++)
+      for (unsigned int j=0; j<3; j++)
+        C[i][j] += d[i]*d[j]/n;
+  }
+
+  // A has the same axes as C, and the mean squared distances of the fiducials to them (f_k^2) as eigenvalues
+  const double trace = C[0][0] + C[1][1] + C[2][2];
+  double A[3][3];
+  for (unsigned int i=0; i<3; i++)
+    for (unsigned int j=0; j<3; j++)
+      A[i][j] = ((i == j) ? trace : 0.0) - C[i][j];
+
+  // collinear fiducials: one f_k is null
+  const double det = A[0][0]*(A[1][1]*A[2][2] - A[1][2]*A[2][1])
+                   - A[0][1]*(A[1][0]*A[2][2] - A[1][2]*A[2][0])
+                   + A[0][2]*(A[1][0]*A[2][1] - A[1][1]*A[2][0]);
+  if (!(trace > 0.0) || (det <= 1e-12*trace*trace*trace))
+    return false;
+
+  double inverse[3][3];
+  for (unsigned int i=0; i<3; i++)
+  {
+    for (unsigned int j=0; j<3; j++)
+    {
+      const unsigned int i1 = (j+1)%3, i2 = (j+2)%3;
+      const unsigned int j1 = (i+1)%3, j2 = (i+2)%3;
+      inverse[i][j] = (A[i1][j1]*A[i2][j2] - A[i1][j2]*A[i2][j1]) / det;
+    }
+  }
+
+  const double inverseTrace = inverse[0][0] + inverse[1][1] + inverse[2][2];
+  for (unsigned int i=0; i<3; i++)
+    for (unsigned int j=0; j<3; j++)
+      mM[i][j] = ((i == j) ? inverseTrace : 0.0) - inverse[i][j];
+
+  mValid = true;
+  return true;
+}
+
+template <typename T>
+inline double TREPredictor::Evaluate(const T* target) const
+{
+  const double p[3] = {target[0]-mCentroid[0], target[1]-mCentroid[1], target[2]-mCentroid[2]};
+  const double q = p[0]*(mM[0][0]*p[0] + mM[0][1]*p[1] + mM[0][2]*p[2])
+                 + p[1]*(mM[1][0]*p[0] + mM[1][1]*p[1] + mM[1][2]*p[2])
+                 + p[2]*(mM[2][0]*p[0] + mM[2][1]*p[1] + mM[2][2]*p[2]);
+  return mValid ? std::sqrt(mFLE*mFLE/mNumberOfFiducials*(1.0 + q/3.0)) : 0.0;
+}
+
+double TREPredictor::Predict(const double target[3]) const
+{
+  return Evaluate(target);
+}
+
+template <typename T>
+void TREPredictor::PredictRange(const T* targets, unsigned int begin, unsigned int end, float* tre) const
+{
+  for (unsigned int t=begin; t<end; t++)
+    tre[t] = Evaluate(targets + 3*t);
+}
+
+template <typename T>
+void TREPredictor::PredictParallel(const T* targets, unsigned int n, float* tre, unsigned int threads) const
+{
+  if (threads == 0)
+    threads = std::max(1u,std::thread::hardware_concurrency());
+  threads = std::max(1u,std::min(threads,n/MINIMUM_TARGETS_PER_THREAD));
+
+  // contiguous ranges, this thread computes the last one
+  std::vector<std::thread> workers;
+  for (unsigned int w=0; w+1<threads; w++)
+    workers.emplace_back(&TREPredictor::PredictRange<T>,this,targets,
+                         static_cast<unsigned int>(static_cast<uint64_t>(n)*w/threads),
+                         static_cast<unsigned int>(static_cast<uint64_t>(n)*(w+1)/threads),tre);
+  PredictRange(targets,static_cast<unsigned int>(static_cast<uint64_t>(n)*(threads-1)/threads),n,tre);
+
+  for (std::thread& worker : workers)
+    worker.join();
+}
+
+void TREPredictor::Predict(const float* targets, unsigned int n, float* tre, unsigned int threads) const
+{
+  PredictParallel(targets,n,tre,threads);
+}
+
+void TREPredictor::Predict(const double* targets, unsigned int n, float* tre, unsigned int threads) const
+{
+  PredictParallel(targets,n,tre,threads);
+}
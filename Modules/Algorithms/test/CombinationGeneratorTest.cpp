@@ -0,0 +1,124 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <algorithm>
+// Module includes
+#include "CombinationGenerator.h"
+#include "Statistics.h"
+
+class CombinationGeneratorTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(CombinationGeneratorTestSuite);
+  MITK_TEST(SameOrderAsComb);
+  MITK_TEST(UnrankAnyIndex);
+  MITK_TEST(ExcludedIdsAreSkipped);
+  MITK_TEST(ChunksCoverTheRange);
+  CPPUNIT_TEST_SUITE_END();
+
+public:
+  void setUp() override
+  {
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void SameOrderAsComb()
+  {
+    const std::vector<std::vector<int> > combinations = Statistics::comb(7,3);
+    CombinationGenerator generator(7,3);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Number of combinations", static_cast<uint64_t>(combinations.size()), generator.GetNumberOfCombinations());
+
+    unsigned int ids[3];
+    generator.Unrank(0,ids);
+    for (const std::vector<int>& combination : combinations)
+    {
+      for (unsigned int i=0; i<3; i++)
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Lexicographic order", combination[i], static_cast<int>(ids[i]));
+      generator.Next(ids);
+    }
+    CPPUNIT_ASSERT_MESSAGE("No combination after the last one", !generator.Next(ids));
+
+    // K > N takes every id once
+    const std::vector<std::vector<int> > all = Statistics::comb(3,5);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Single combination", static_cast<size_t>(1), all.size());
+    CPPUNIT_ASSERT_MESSAGE("All the ids", all[0] == std::vector<int>({0,1,2}));
+  }
+
+  void UnrankAnyIndex()
+  {
+    // 20 fiducials taken 10 at a time, without storing them
+    CombinationGenerator generator(20,10);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("C(20,10)", static_cast<uint64_t>(184756), generator.GetNumberOfCombinations());
+
+    unsigned int ids[10];
+    generator.Unrank(184755,ids);
+    for (unsigned int i=0; i<10; i++)
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Last combination", 10+i, ids[i]);
+
+    const uint64_t ranks[] = {0, 1, 999, 92377, 184754};
+    for (uint64_t rank : ranks)
+    {
+      generator.Unrank(rank,ids);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Rank of the unranked combination", rank, generator.Rank(ids));
+
+      unsigned int next[10];
+      generator.Unrank(rank+1,next);
+      generator.Next(ids);
+      CPPUNIT_ASSERT_MESSAGE("Next is the following rank", std::equal(ids,ids+10,next));
+    }
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("C(64,32)", static_cast<uint64_t>(1832624140942590534ULL), CombinationGenerator::Binomial(64,32));
+  }
+
+  void ExcludedIdsAreSkipped()
+  {
+    CombinationGenerator generator(10,4);
+    generator.SetExcludedIds(std::vector<unsigned int>{2,5});
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("C(8,4)", static_cast<uint64_t>(70), generator.GetNumberOfCombinations());
+
+    uint64_t count = 0;
+    unsigned int ids[4];
+    generator.Unrank(0,ids);
+    do
+    {
+      CPPUNIT_ASSERT_MESSAGE("Excluded ids never appear", (std::find(ids,ids+4,2) == ids+4) && (std::find(ids,ids+4,5) == ids+4));
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Ranks are consecutive", count, generator.Rank(ids));
+      count++;
+    } while (generator.Next(ids));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All combinations walked", generator.GetNumberOfCombinations(), count);
+  }
+
+  void ChunksCoverTheRange()
+  {
+    CombinationGenerator generator(12,5);
+    const unsigned int chunks = 7;
+
+    uint64_t previousEnd = 0;
+    for (unsigned int c=0; c<chunks; c++)
+    {
+      uint64_t begin, end;
+      generator.GetChunk(c,chunks,begin,end);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Contiguous chunks", previousEnd, begin);
+      CPPUNIT_ASSERT_MESSAGE("Balanced chunks", (end-begin) >= generator.GetNumberOfCombinations()/chunks);
+      previousEnd = end;
+    }
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Last chunk ends at the last rank", generator.GetNumberOfCombinations(), previousEnd);
+
+    uint64_t begin = 1, end = 1;
+    generator.GetChunk(0,0,begin,end);
+    CPPUNIT_ASSERT_MESSAGE("No chunks, empty range", begin == end);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(CombinationGenerator)
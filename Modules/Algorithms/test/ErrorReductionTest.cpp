@@ -0,0 +1,151 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+// VTK includes
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+// Module includes
+#include <RigidTransformVtk.h>
+#include "ErrorReduction.h"
+#include "Registration.h"
+
+class ErrorReductionTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(ErrorReductionTestSuite);
+  MITK_TEST(SinglePassValues);
+  MITK_TEST(SurfaceDisplacement);
+  MITK_TEST(SmallSpreadOfFarPoints);
+  MITK_TEST(MoreSamplesThanPoints);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  static const unsigned int N = 300000;
+
+  RigidTransform                mError;
+  vtkSmartPointer<vtkPoints>    mPoints;
+
+public:
+  void setUp() override
+  {
+    const double rotation[3] = {0.002, -0.001, 0.003};
+    const double translation[3] = {0.4, -0.2, 0.1};
+    mError = RigidTransform::FromQuaternion(Quaternion::FromRotationVector(rotation),translation);
+
+    std::mt19937 generator(11);
+    std::uniform_real_distribution<double> coordinate(-150.0,150.0);
+    mPoints = vtkSmartPointer<vtkPoints>::New();
+    mPoints->SetDataTypeToFloat();
+    for (unsigned int p=0; p<N; p++)
+      mPoints->InsertNextPoint(coordinate(generator),coordinate(generator),coordinate(generator));
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void SinglePassValues()
+  {
+    const double values[5] = {1.0, 2.5, 0.5, 4.0, 2.0};
+    const ErrorStatistics statistics = ErrorReduction::FromValues(values,5);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Count", 5u, statistics.count);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Mean", 2.0, statistics.mean, 1e-15);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Std", std::sqrt(1.5), statistics.std, 1e-15);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Rms", std::sqrt(5.5), statistics.rms, 1e-15);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Max", 4.0, statistics.max, 0.0);
+
+    double mean, std, fre, fle;
+    Registration::GetErrorMetricsFromDistances(values,5,mean,std,fre,fle);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("FRE", statistics.rms, fre, 0.0);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("FLE", fre/0.9, fle, 1e-15);
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("No values", 0u, ErrorReduction::FromValues(values,0).count);
+  }
+
+  void SurfaceDisplacement()
+  {
+    // two pass reference, transforming each point
+    std::vector<double> distances(N);
+    for (unsigned int p=0; p<N; p++)
+    {
+      double point[3], transformed[3];
+      mPoints->GetPoint(p,point);
+      mError.TransformPoint(point,transformed);
+      distances[p] = std::sqrt(vtkMath::Distance2BetweenPoints(point,transformed));
+    }
+    double mean = 0.0;
+    for (double d : distances)
+      mean += d;
+    mean /= N;
+    double variance = 0.0;
+    for (double d : distances)
+      variance += (d-mean)*(d-mean);
+    variance /= N;
+
+    for (unsigned int threads : {1u, 4u})
+    {
+      const ErrorStatistics statistics = ErrorReduction::FromTransform(mError,mPoints,0,threads);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Every vertex", N, statistics.count);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Mean", mean, statistics.mean, 1e-10);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Std", std::sqrt(variance), statistics.std, 1e-10);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Rms", std::sqrt(mean*mean + variance), statistics.rms, 1e-10);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Max", *std::max_element(distances.begin(),distances.end()), statistics.max, 1e-10);
+    }
+
+    // same estimation as the registration, with evenly spaced samples
+    vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+    pd->SetPoints(mPoints);
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    RigidTransformToVtk(mError,matrix);
+
+    double sum2 = 0.0;
+    for (unsigned int i=0; i<1000; i++)
+      sum2 += distances[i*(N/1000)]*distances[i*(N/1000)];
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Sampled TRE", std::sqrt(sum2/1000), Registration::EstimateTREFromMatrix(matrix,pd,1000), 1e-10);
+  }
+
+  void SmallSpreadOfFarPoints()
+  {
+    // a translation moves every point the same: no spread, even far from the origin
+    vtkSmartPointer<vtkPoints> far = vtkSmartPointer<vtkPoints>::New();
+    far->SetDataTypeToDouble();
+    for (unsigned int p=0; p<N; p++)
+      far->InsertNextPoint(1e5 + p, 2e5, -1e5);
+
+    const double translation[3] = {0.0, 0.3, 0.4};
+    const ErrorStatistics statistics = ErrorReduction::FromTransform(RigidTransform::FromQuaternion(Quaternion::Identity(),translation),far);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Mean", 0.5, statistics.mean, 1e-12);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Std", 0.0, statistics.std, 1e-12);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Max", 0.5, statistics.max, 1e-12);
+  }
+
+  void MoreSamplesThanPoints()
+  {
+    vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+    pd->SetPoints(mPoints);
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    RigidTransformToVtk(mError,matrix);
+
+    // used to divide by zero
+    const double exact = ErrorReduction::FromTransform(mError,mPoints).rms;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("All the vertices", exact, Registration::EstimateTREFromMatrix(matrix,pd,2*N), 1e-12);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Full surface", exact, Registration::EstimateTREFromMatrix(matrix,pd,0), 1e-12);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(ErrorReduction)
@@ -0,0 +1,150 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <random>
+// MITK includes
+#include <mitkPointSet.h>
+// VTK includes
+#include <vtkMatrix4x4.h>
+// Module includes
+#include "CombinationGenerator.h"
+#include "FiducialConfigurationEvaluator.h"
+#include "Registration.h"
+
+class FiducialConfigurationEvaluatorTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(FiducialConfigurationEvaluatorTestSuite);
+  MITK_TEST(SameResultsWithAnyNumberOfThreads);
+  MITK_TEST(MetricsMatchSingleRegistration);
+  MITK_TEST(InvalidConfigurations);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  static const unsigned int N = 12;
+  static const unsigned int K = 5;
+
+  mitk::PointSet::Pointer   mPlanned;
+  mitk::PointSet::Pointer   mReal;
+  mitk::PointSet::Pointer   mRealB;
+
+public:
+  void setUp() override
+  {
+    mPlanned = mitk::PointSet::New();
+    mReal = mitk::PointSet::New();
+    mRealB = mitk::PointSet::New();
+
+    std::mt19937 generator(5);
+    std::uniform_real_distribution<double> coordinate(-80.0,80.0);
+    std::normal_distribution<double> noise(0.0,0.4);
+    for (unsigned int p=0; p<N; p++)
+    {
+      mitk::Point3D planned, real, realB;
+      for (unsigned int i=0; i<3; i++)
+      {
+        planned[i] = coordinate(generator);
+        real[i] = planned[i] + 10.0 + noise(generator);
+        realB[i] = planned[i] + 10.0 + noise(generator);
+      }
+      mPlanned->InsertPoint(p,planned);
+      mReal->InsertPoint(p,real);
+      mRealB->InsertPoint(p,realB);
+    }
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void SameResultsWithAnyNumberOfThreads()
+  {
+    FiducialConfigurationEvaluator evaluator;
+    evaluator.SetModelA(mPlanned,mReal,RegistrationPointsMetrics::FlatSmall);
+    evaluator.SetModelB(mPlanned,mRealB,RegistrationPointsMetrics::SphereSmall);
+    evaluator.SetSubsetSize(K);
+    evaluator.SetExcludedIds(std::vector<unsigned int>{4});
+
+    std::vector<RegistrationPointsMetrics> single, parallel;
+    evaluator.SetNumberOfThreads(1);
+    CPPUNIT_ASSERT_MESSAGE("Single thread run", evaluator.Run(single));
+    evaluator.SetNumberOfThreads(4);
+    CPPUNIT_ASSERT_MESSAGE("Parallel run", evaluator.Run(parallel));
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All subsets evaluated", CombinationGenerator::Binomial(N-1,K), static_cast<uint64_t>(parallel.size()));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Same number of results", single.size(), parallel.size());
+
+    CombinationGenerator generator(N,K);
+    generator.SetExcludedIds(std::vector<unsigned int>{4});
+    unsigned int ids[K];
+    for (unsigned int r=0; r<parallel.size(); r++)
+    {
+      generator.Unrank(r,ids);
+      for (unsigned int i=0; i<K; i++)
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Results in rank order", static_cast<int>(ids[i]), parallel[r].A_combination[i]);
+
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Same FRE", single[r].A_FRE, parallel[r].A_FRE);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Same offset", single[r].B_offset, parallel[r].B_offset);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Same dissociated angle", single[r].angle, parallel[r].angle);
+    }
+  }
+
+  void MetricsMatchSingleRegistration()
+  {
+    FiducialConfigurationEvaluator evaluator;
+    evaluator.SetModelA(mPlanned,mReal);
+    evaluator.SetSubsetSize(K);
+    evaluator.SetNumberOfThreads(2);
+
+    std::vector<RegistrationPointsMetrics> results;
+    CPPUNIT_ASSERT_MESSAGE("Run", evaluator.Run(results));
+
+    const unsigned int rank = 321;
+    mitk::PointSet::Pointer planned = mitk::PointSet::New();
+    mitk::PointSet::Pointer real = mitk::PointSet::New();
+    for (unsigned int i=0; i<K; i++)
+    {
+      planned->InsertPoint(i,mPlanned->GetPoint(results[rank].A_combination[i]));
+      real->InsertPoint(i,mReal->GetPoint(results[rank].A_combination[i]));
+    }
+
+    mitk::PointSet::Pointer transformed = mitk::PointSet::New();
+    vtkSmartPointer<vtkMatrix4x4> matrix = Registration::PerformPairedPointsRegistration(planned,real,transformed);
+    std::vector<double> distances;
+    double mean, std, fre, fle;
+    Registration::GetErrorMetricsFromPairedPointRegistration(planned,transformed,distances,mean,std,fre,fle);
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Same FRE", fre, results[rank].A_FRE, 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Same mean", mean, results[rank].A_mean, 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Same std", std, results[rank].A_std, 1e-9);
+    for (unsigned int i=0; i<3; i++)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Same matrix", matrix->GetElement(i,3), results[rank].A_matrix->GetElement(i,3), 1e-9);
+    CPPUNIT_ASSERT_MESSAGE("No model B", results[rank].B_matrix.GetPointer() == nullptr);
+  }
+
+  void InvalidConfigurations()
+  {
+    FiducialConfigurationEvaluator evaluator;
+    std::vector<RegistrationPointsMetrics> results;
+    CPPUNIT_ASSERT_MESSAGE("No points", !evaluator.Run(results));
+
+    evaluator.SetModelA(mPlanned,mReal);
+    evaluator.SetSubsetSize(N+1);
+    CPPUNIT_ASSERT_MESSAGE("Subsets larger than the points", !evaluator.Run(results));
+
+    evaluator.SetSubsetSize(K);
+    evaluator.SetExcludedIds(std::vector<unsigned int>{0,1,2,3,4,5,6,7});
+    CPPUNIT_ASSERT_MESSAGE("Not enough points after excluding", !evaluator.Run(results));
+    CPPUNIT_ASSERT_MESSAGE("No results", results.empty());
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(FiducialConfigurationEvaluator)
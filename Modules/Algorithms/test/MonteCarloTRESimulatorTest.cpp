@@ -0,0 +1,143 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <cmath>
+#include <thread>
+// MITK includes
+#include <mitkPointSet.h>
+// Module includes
+#include "MonteCarloTRESimulator.h"
+#include "PhiloxRandom.h"
+#include "Statistics.h"
+
+class MonteCarloTRESimulatorTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(MonteCarloTRESimulatorTestSuite);
+  MITK_TEST(PhiloxKnownAnswers);
+  MITK_TEST(ReproducibleWithAnyNumberOfThreads);
+  MITK_TEST(MatchesFitzpatrickPrediction);
+  MITK_TEST(ReproducibleNoiseFromGlobalSeed);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::PointSet::Pointer   mFiducials;
+  mitk::PointSet::Pointer   mTargets;
+
+public:
+  void setUp() override
+  {
+    // fiducials around the origin, principal axes along x, y, z
+    const double fiducials[6][3] = {{60,0,0}, {-60,0,0}, {0,40,0}, {0,-40,0}, {0,0,25}, {0,0,-25}};
+    mFiducials = mitk::PointSet::New();
+    for (unsigned int p=0; p<6; p++)
+      mFiducials->InsertPoint(p,mitk::Point3D(fiducials[p]));
+
+    const double targets[3][3] = {{0,0,0}, {0,0,80}, {100,50,0}};
+    mTargets = mitk::PointSet::New();
+    for (unsigned int t=0; t<3; t++)
+      mTargets->InsertPoint(t,mitk::Point3D(targets[t]));
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void PhiloxKnownAnswers()
+  {
+    // Random123 known answer test
+    const uint32_t counter[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344};
+    const uint32_t key[2] = {0xa4093822, 0x299f31d0};
+    const uint32_t expected[4] = {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1};
+    uint32_t out[4];
+    PhiloxRandom::Block(counter,key,out);
+    for (unsigned int i=0; i<4; i++)
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Philox4x32-10 block", expected[i], out[i]);
+  }
+
+  void ReproducibleWithAnyNumberOfThreads()
+  {
+    MonteCarloTRESimulator simulator;
+    simulator.SetFiducials(mFiducials);
+    simulator.SetTargets(mTargets);
+    simulator.SetIsotropicFLE(0.5);
+    simulator.SetNumberOfTrials(2000);
+    simulator.SetSeed(1234);
+
+    simulator.SetNumberOfThreads(1);
+    CPPUNIT_ASSERT_MESSAGE("Single thread run", simulator.Run());
+    const std::vector<TREDistribution> single = simulator.GetResults();
+
+    simulator.SetNumberOfThreads(4);
+    CPPUNIT_ASSERT_MESSAGE("Parallel run", simulator.Run());
+    const std::vector<TREDistribution> parallel = simulator.GetResults();
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("One distribution per target", static_cast<size_t>(3), parallel.size());
+    for (unsigned int t=0; t<3; t++)
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Same rms", single[t].rms, parallel[t].rms);
+      for (unsigned int p=0; p<parallel[t].percentiles.size(); p++)
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Same percentiles", single[t].percentiles[p], parallel[t].percentiles[p]);
+      CPPUNIT_ASSERT_MESSAGE("Ordered percentiles", parallel[t].percentiles.front() <= parallel[t].percentiles.back());
+      CPPUNIT_ASSERT_MESSAGE("Maximum above the percentiles", parallel[t].percentiles.back() <= parallel[t].max);
+    }
+
+    simulator.SetSeed(4321);
+    CPPUNIT_ASSERT_MESSAGE("Other seed", simulator.Run());
+    CPPUNIT_ASSERT_MESSAGE("Different trials", simulator.GetResults()[0].rms != single[0].rms);
+  }
+
+  void MatchesFitzpatrickPrediction()
+  {
+    const double fle = 0.5;
+    MonteCarloTRESimulator simulator;
+    simulator.SetFiducials(mFiducials);
+    simulator.SetTargets(mTargets);
+    simulator.SetIsotropicFLE(fle);
+    simulator.SetNumberOfTrials(20000);
+    CPPUNIT_ASSERT_MESSAGE("Run", simulator.Run());
+
+    // TRE^2 = FLE^2/N (1 + 1/3 sum d_k^2/f_k^2), f_k^2 = mean squared distance of the fiducials to axis k
+    const double f2[3] = {(2*40.0*40.0 + 2*25.0*25.0)/6.0, (2*60.0*60.0 + 2*25.0*25.0)/6.0, (2*60.0*60.0 + 2*40.0*40.0)/6.0};
+    for (unsigned int t=0; t<3; t++)
+    {
+      const mitk::Point3D target = mTargets->GetPoint(t);
+      const double d2[3] = {target[1]*target[1] + target[2]*target[2], target[0]*target[0] + target[2]*target[2], target[0]*target[0] + target[1]*target[1]};
+      const double expected = std::sqrt(fle*fle/6.0 * (1.0 + (d2[0]/f2[0] + d2[1]/f2[1] + d2[2]/f2[2])/3.0));
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("rms TRE", expected, simulator.GetResults()[t].rms, 0.05*expected);
+    }
+  }
+
+  void ReproducibleNoiseFromGlobalSeed()
+  {
+    mitk::Point3D first, second;
+    first.Fill(0.0);
+    second.Fill(0.0);
+
+    Statistics::SetRandomSeed(99);
+    Statistics::AddNoiseToPoint(first,0.0,1.0);
+    Statistics::SetRandomSeed(99);
+    Statistics::AddNoiseToPoint(second,0.0,1.0);
+    CPPUNIT_ASSERT_MESSAGE("Same noise with the same seed", first == second);
+    CPPUNIT_ASSERT_MESSAGE("Some noise", (first[0] != 0.0) && (first[1] != 0.0) && (first[2] != 0.0));
+
+    // streams chosen by the caller do not depend on the thread
+    mitk::Point3D keyed[2];
+    keyed[0].Fill(0.0);
+    keyed[1].Fill(0.0);
+    std::thread worker([&keyed]{Statistics::AddNoiseToPoint(keyed[0],0.0,1.0,7);});
+    worker.join();
+    Statistics::AddNoiseToPoint(keyed[1],0.0,1.0,7);
+    CPPUNIT_ASSERT_MESSAGE("Same noise from any thread", keyed[0] == keyed[1]);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(MonteCarloTRESimulator)
@@ -0,0 +1,147 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <cmath>
+#include <random>
+// MITK includes
+#include <mitkPointSet.h>
+// VTK includes
+#include <vtkMatrix4x4.h>
+// Module includes
+#include "PairedPointSolver.h"
+#include "Registration.h"
+
+class PairedPointSolverTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(PairedPointSolverTestSuite);
+  MITK_TEST(ExactRegistration);
+  MITK_TEST(NoisyRegistrationIsOptimal);
+  MITK_TEST(DegenerateConfigurations);
+  MITK_TEST(SubsetsMatchSingleSolves);
+  MITK_TEST(PointSetRegistration);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  static const unsigned int N = 8;
+
+  RigidTransform    mTransform;
+  double            mMoving[3*N];
+  double            mFixed[3*N];
+
+public:
+  void setUp() override
+  {
+    const double rotation[3] = {0.3, -0.8, 0.5};
+    const double translation[3] = {-40.0, 12.5, 103.0};
+    mTransform = RigidTransform::FromQuaternion(Quaternion::FromRotationVector(rotation),translation);
+
+    std::mt19937 generator(7);
+    std::uniform_real_distribution<double> coordinate(-80.0,80.0);
+    for (unsigned int p=0; p<N; p++)
+    {
+      for (unsigned int i=0; i<3; i++)
+        mMoving[3*p+i] = coordinate(generator);
+      mTransform.TransformPoint(mMoving + 3*p, mFixed + 3*p);
+    }
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void ExactRegistration()
+  {
+    double residuals[N];
+    const PairedPointResult result = PairedPointSolver::Solve(mFixed,mMoving,N,residuals);
+    CPPUNIT_ASSERT_MESSAGE("Valid registration", result.valid);
+
+    const RigidTransform difference = mTransform.Inverse() * result.transform;
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Translation recovered", 0.0, difference.GetTranslationNorm(), 1e-8);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Rotation recovered", 0.0, difference.GetRotationAngle(), 1e-9);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("No residual", 0.0, result.fre, 1e-8);
+    for (unsigned int p=0; p<N; p++)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("No point residual", 0.0, residuals[p], 1e-8);
+  }
+
+  void NoisyRegistrationIsOptimal()
+  {
+    std::mt19937 generator(11);
+    std::normal_distribution<double> noise(0.0,0.5);
+    for (unsigned int k=0; k<3*N; k++)
+      mFixed[k] += noise(generator);
+
+    const PairedPointResult result = PairedPointSolver::Solve(mFixed,mMoving,N);
+    CPPUNIT_ASSERT_MESSAGE("Valid registration", result.valid);
+    CPPUNIT_ASSERT_MESSAGE("Consistent metrics", (result.meanError <= result.fre) && (result.fre <= result.maxError));
+
+    // least squares: a small change of the solution does not reduce the residual
+    for (unsigned int k=0; k<20; k++)
+    {
+      const double rotation[3] = {1e-3*noise(generator), 1e-3*noise(generator), 1e-3*noise(generator)};
+      const double translation[3] = {1e-2*noise(generator), 1e-2*noise(generator), 1e-2*noise(generator)};
+      const RigidTransform perturbed = RigidTransform::FromQuaternion(Quaternion::FromRotationVector(rotation),translation) * result.transform;
+
+      double sum2 = 0.0;
+      for (unsigned int p=0; p<N; p++)
+      {
+        double t[3];
+        perturbed.TransformPoint(mMoving + 3*p, t);
+        for (unsigned int i=0; i<3; i++)
+          sum2 += (t[i]-mFixed[3*p+i])*(t[i]-mFixed[3*p+i]);
+      }
+      CPPUNIT_ASSERT_MESSAGE("Minimum residual", std::sqrt(sum2/N) >= result.fre - 1e-12);
+    }
+  }
+
+  void DegenerateConfigurations()
+  {
+    CPPUNIT_ASSERT_MESSAGE("Two points are not enough", !PairedPointSolver::Solve(mFixed,mMoving,2).valid);
+
+    const double line[9] = {0.0,0.0,0.0, 1.0,2.0,3.0, 2.0,4.0,6.0};
+    CPPUNIT_ASSERT_MESSAGE("Collinear points", !PairedPointSolver::Solve(line,line,3).valid);
+  }
+
+  void SubsetsMatchSingleSolves()
+  {
+    const unsigned int subsets[3][3] = {{0,1,2}, {3,5,7}, {2,4,6}};
+    PairedPointResult results[3];
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("All subsets solved", 3u, PairedPointSolver::SolveSubsets(mFixed,mMoving,&subsets[0][0],3,3,results));
+
+    for (unsigned int s=0; s<3; s++)
+    {
+      const PairedPointResult single = PairedPointSolver::Solve(mFixed,mMoving,subsets[s],3);
+      for (unsigned int i=0; i<3; i++)
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Same translation", single.transform.translation[i], results[s].transform.translation[i], 1e-12);
+    }
+  }
+
+  void PointSetRegistration()
+  {
+    mitk::PointSet::Pointer planned = mitk::PointSet::New();
+    mitk::PointSet::Pointer real = mitk::PointSet::New();
+    for (unsigned int p=0; p<N; p++)
+    {
+      planned->InsertPoint(p,mitk::Point3D(mFixed + 3*p));
+      real->InsertPoint(p,mitk::Point3D(mMoving + 3*p));
+    }
+
+    mitk::PointSet::Pointer transformed = mitk::PointSet::New();
+    vtkSmartPointer<vtkMatrix4x4> matrix = Registration::PerformPairedPointsRegistration(planned,real,transformed);
+
+    for (unsigned int i=0; i<3; i++)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Real to planned matrix", mTransform.translation[i], matrix->GetElement(i,3), 1e-8);
+    for (unsigned int p=0; p<N; p++)
+      CPPUNIT_ASSERT_MESSAGE("Real points moved onto planned points", transformed->GetPoint(p).EuclideanDistanceTo(planned->GetPoint(p)) < 1e-8);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(PairedPointSolver)
@@ -0,0 +1,180 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <random>
+#include <string>
+// MITK includes
+#include <mitkDataNode.h>
+#include <mitkPointSet.h>
+#include <mitkSurface.h>
+// VTK includes
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+// Module includes
+#include "MonteCarloTRESimulator.h"
+#include "TREMap.h"
+#include "TREPredictor.h"
+
+class TREPredictorTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TREPredictorTestSuite);
+  MITK_TEST(MatchesSimulation);
+  MITK_TEST(ParallelPrediction);
+  MITK_TEST(CollinearFiducials);
+  MITK_TEST(MapsAreCached);
+  MITK_TEST(HideRestoresSurface);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::PointSet::Pointer   mFiducials;
+
+public:
+  void setUp() override
+  {
+    // not aligned with the axes, so the covariance is not diagonal
+    const double fiducials[5][3] = {{60,10,0}, {-50,0,5}, {3,40,-2}, {0,-45,8}, {10,5,30}};
+    mFiducials = mitk::PointSet::New();
+    for (unsigned int p=0; p<5; p++)
+      mFiducials->InsertPoint(p,mitk::Point3D(fiducials[p]));
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void MatchesSimulation()
+  {
+    const double targets[3][3] = {{0,0,0}, {0,0,90}, {120,-30,20}};
+
+    MonteCarloTRESimulator simulator;
+    simulator.SetFiducials(mFiducials);
+    simulator.SetTargets(&targets[0][0],3);
+    simulator.SetIsotropicFLE(0.6);
+    simulator.SetNumberOfTrials(20000);
+    CPPUNIT_ASSERT_MESSAGE("Simulation", simulator.Run());
+
+    TREPredictor predictor;
+    predictor.SetFLE(0.6);
+    std::vector<double> fiducials;
+    for (int p=0; p<mFiducials->GetSize(); p++)
+      for (unsigned int i=0; i<3; i++)
+        fiducials.push_back(mFiducials->GetPoint(p)[i]);
+    CPPUNIT_ASSERT_MESSAGE("Valid fiducials", predictor.SetFiducials(fiducials.data(),5));
+
+    for (unsigned int t=0; t<3; t++)
+    {
+      const double expected = simulator.GetResults()[t].rms;
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Predicted rms TRE", expected, predictor.Predict(targets[t]), 0.03*expected);
+    }
+  }
+
+  void ParallelPrediction()
+  {
+    const double fiducials[4][3] = {{50,0,0}, {0,50,0}, {0,0,50}, {-30,-30,-30}};
+    TREPredictor predictor;
+    predictor.SetFLE(0.3);
+    CPPUNIT_ASSERT_MESSAGE("Valid fiducials", predictor.SetFiducials(&fiducials[0][0],4));
+
+    const unsigned int n = 200000;
+    std::vector<float> targets(3*n);
+    std::mt19937 generator(3);
+    std::uniform_real_distribution<float> coordinate(-150.0,150.0);
+    for (float& v : targets)
+      v = coordinate(generator);
+
+    std::vector<float> single(n), parallel(n);
+    predictor.Predict(targets.data(),n,single.data(),1);
+    predictor.Predict(targets.data(),n,parallel.data(),4);
+    CPPUNIT_ASSERT_MESSAGE("Same map with any number of threads", single == parallel);
+
+    const double target[3] = {targets[3*777], targets[3*777+1], targets[3*777+2]};
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Same as a single target", predictor.Predict(target), parallel[777], 1e-5);
+  }
+
+  void CollinearFiducials()
+  {
+    const double line[9] = {0.0,0.0,0.0, 1.0,2.0,3.0, 2.0,4.0,6.0};
+    TREPredictor predictor;
+    CPPUNIT_ASSERT_MESSAGE("Collinear fiducials", !predictor.SetFiducials(line,3));
+    CPPUNIT_ASSERT_MESSAGE("Two fiducials", !predictor.SetFiducials(line,2));
+    CPPUNIT_ASSERT_MESSAGE("Invalid predictor", !predictor.IsValid());
+  }
+
+  void MapsAreCached()
+  {
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    for (unsigned int i=0; i<1000; i++)
+      points->InsertNextPoint(i*0.1, 100.0 - i*0.2, 20.0);
+    vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+    pd->SetPoints(points);
+
+    TREMap map;
+    vtkSmartPointer<vtkFloatArray> first = map.Compute(pd,mFiducials);
+    CPPUNIT_ASSERT_MESSAGE("Map computed", (first.GetPointer() != nullptr) && (first->GetNumberOfValues() == 1000));
+
+    // another configuration, then back to the first one
+    mitk::PointSet::Pointer moved = mitk::PointSet::New();
+    for (int p=0; p<mFiducials->GetSize(); p++)
+      moved->InsertPoint(p,mFiducials->GetPoint(p));
+    moved->SetPoint(0,mitk::Point3D(0.0));
+    CPPUNIT_ASSERT_MESSAGE("Other configuration", map.Compute(pd,moved).GetPointer() != first.GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Cached configuration", map.Compute(pd,mFiducials).GetPointer() == first.GetPointer());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("One cache hit", 1u, map.GetNumberOfCacheHits());
+
+    // moving the surface invalidates the map
+    points->SetPoint(0, 1.0, 1.0, 1.0);
+    points->Modified();
+    CPPUNIT_ASSERT_MESSAGE("Surface modified", map.Compute(pd,mFiducials).GetPointer() != first.GetPointer());
+  }
+
+  void HideRestoresSurface()
+  {
+    vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+    vtkSmartPointer<vtkFloatArray> scalars = vtkSmartPointer<vtkFloatArray>::New();
+    scalars->SetName("Curvature");
+    for (unsigned int i=0; i<100; i++)
+    {
+      points->InsertNextPoint(i, 2.0*i, 10.0);
+      scalars->InsertNextValue(i);
+    }
+    vtkSmartPointer<vtkPolyData> pd = vtkSmartPointer<vtkPolyData>::New();
+    pd->SetPoints(points);
+    pd->GetPointData()->SetScalars(scalars);
+
+    mitk::Surface::Pointer surface = mitk::Surface::New();
+    surface->SetVtkPolyData(pd);
+    mitk::DataNode::Pointer node = mitk::DataNode::New();
+    node->SetData(surface);
+    node->SetBoolProperty("scalar visibility", false);
+
+    TREMap map;
+    CPPUNIT_ASSERT_MESSAGE("Shown", map.Show(node,mFiducials));
+    CPPUNIT_ASSERT_MESSAGE("Map selected", pd->GetPointData()->GetScalars()->GetName() == std::string("Predicted TRE"));
+    CPPUNIT_ASSERT_MESSAGE("Scalars kept", pd->GetPointData()->GetArray("Curvature") == scalars.GetPointer());
+    bool visible = false;
+    CPPUNIT_ASSERT_MESSAGE("Scalars visible", node->GetBoolProperty("scalar visibility",visible) && visible);
+
+    // the same map again is not added twice
+    CPPUNIT_ASSERT_MESSAGE("Shown again", map.Show(node,mFiducials));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Arrays", 2, pd->GetPointData()->GetNumberOfArrays());
+
+    map.Hide(node);
+    CPPUNIT_ASSERT_MESSAGE("Scalars restored", pd->GetPointData()->GetScalars() == scalars.GetPointer());
+    CPPUNIT_ASSERT_MESSAGE("Map removed", pd->GetPointData()->GetArray("Predicted TRE") == nullptr);
+    CPPUNIT_ASSERT_MESSAGE("Visibility restored", node->GetBoolProperty("scalar visibility",visible) && !visible);
+    CPPUNIT_ASSERT_MESSAGE("Lookup table removed", node->GetProperty("LookupTable") == nullptr);
+    CPPUNIT_ASSERT_MESSAGE("Color mode removed", node->GetProperty("color mode") == nullptr);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(TREPredictor)
@@ -0,0 +1,10 @@
+set(MODULE_TESTS
+  PairedPointSolverTest.cpp
+  CombinationGeneratorTest.cpp
+  FiducialConfigurationEvaluatorTest.cpp
+  MonteCarloTRESimulatorTest.cpp
+  TREPredictorTest.cpp
+  ErrorReductionTest.cpp
+)
+SET(MODULE_CUSTOM_TESTS
+)
@@ -1,5 +1,12 @@
 set(COMMON_FILES
-  navAPI.cpp)
+  navAPI.cpp
+  CameraConnectionManager.cpp
+  AtracsysTrackingSource.cpp
+  ReplayTrackingSource.cpp
+  TrackingLog.cpp
+  TrackingRecorder.cpp
+  PoseFilter.cpp
+  LatencyMonitor.cpp)
 
 IF(WIN32)
   set(CPP_FILES
@@ -18,4 +25,5 @@ set(RESOURCE_FILES
 
 set(MOC_H_FILES
   include/navAPI.h
+  include/CameraConnectionManager.h
 )
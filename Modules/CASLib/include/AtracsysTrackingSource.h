@@ -0,0 +1,68 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef ATRACSYSTRACKINGSOURCE_H
+#define ATRACSYSTRACKINGSOURCE_H
+
+#include <ftkInterface.h>
+
+#include "TrackingSource.h"
+
+/*  Tracking source for Atracsys cameras (spryTrack/fusionTrack), using the ftk SDK.*/
+class CASLib_EXPORT AtracsysTrackingSource : public TrackingSource
+{
+public:
+  AtracsysTrackingSource();
+  ~AtracsysTrackingSource() override;
+
+  std::string GetName() const override {return "Atracsys camera";}
+
+  bool Detect() override;
+  bool Open() override;
+  bool Close() override;
+  bool IsOpen() const override {return mLib != 0;}
+
+  bool AddGeometry(uint32_t geometryId, const std::string& geometryFile) override;
+
+  bool StartStreaming() override;
+  void StopStreaming() override;
+  FrameStatus WaitForFrame(TrackingFrame& frame, unsigned int timeout) override;
+
+  /// Disables image sending and creates a frame sized for the added geometries
+  bool SetModeToStandard();
+
+  inline uint32_t GetMarkerCapacity() const {return mMarkerCapacity;}
+  inline uint32_t GetFiducialCapacity() const {return mFiducialCapacity;}
+
+private:
+  /*  Creates mFrame if needed and sets its capacities. The initial capacities fit the added
+      geometries, they grow when the device reports an overflow.*/
+  bool ConfigureFrame();
+
+  /// Copies the ftk frame content into the device independent frame
+  void CopyFrame(TrackingFrame& frame) const;
+
+  /// spurious reflections expected in a frame, on top of the geometry fiducials
+  static const uint32_t   FIDUCIAL_MARGIN = 8;
+
+  ftkLibrary              mLib;
+  uint64                  mSn;
+  ftkFrameQuery*          mFrame;
+
+  // frame capacities
+  uint32_t                mGeometries;
+  uint32_t                mGeometryFiducials;
+  std::atomic<uint32_t>   mMarkerCapacity;
+  std::atomic<uint32_t>   mFiducialCapacity;
+
+  /// device counter of the last frame, to detect skipped frames
+  bool                    mHasLastCounter;
+  uint32                  mLastCounter;
+};
+
+#endif // ATRACSYSTRACKINGSOURCE_H
@@ -0,0 +1,95 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef CAMERACONNECTIONMANAGER_H
+#define CAMERACONNECTIONMANAGER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include <QThread>
+
+#include <CASLibExports.h>
+
+#include "navAPI.h"
+
+/*  Connects the camera of a navAPI in the background, so the GUI thread never blocks on the SDK.
+    A state machine detects the device, opens it, loads the geometries and starts the acquisition
+    thread. Failed attempts are retried every retry period, and a device that stops delivering
+    frames while streaming is reconnected. Connect and Disconnect only queue a request for the
+    connection thread, which is the only one calling the camera functions of navAPI; the result is
+    reported with StateChanged.*/
+class CASLib_EXPORT CameraConnectionManager : public QThread
+{
+  Q_OBJECT
+public:
+  enum State{Disconnected, Detecting, Connecting, Configuring, Streaming, WaitingForCamera};
+
+  explicit CameraConnectionManager(navAPI* api);
+  ~CameraConnectionManager();
+
+  static const char* GetStateName(State state);
+  inline State GetState() const {return mState;}
+
+  /*  Requests a connection and returns immediately. A running connection is closed first by the
+      connection thread. Only the latest request is kept.*/
+  void Connect(const std::vector<navAPI::MarkerId>& geometries);
+
+  /*  Requests the acquisition to stop and the camera to close, and returns immediately.
+      StateChanged(Disconnected) is emitted once the camera is closed.*/
+  void Disconnect();
+
+  /// true from Connect until Disconnect, or until the connection ends by itself (end of a recorded session)
+  inline bool IsConnectionRequested() const {return mConnectionRequested;}
+
+  /// Time in ms between connection attempts
+  inline void SetRetryPeriod(unsigned int ms){mRetryPeriod = ms;}
+
+  /// Time in ms without frames (device errors) after which a streaming camera is reconnected
+  inline void SetDeviceLostTimeout(unsigned int ms){mDeviceLostTimeout = ms;}
+
+signals:
+  /// emitted from the connection thread on every transition (state is a State value)
+  void StateChanged(int state);
+
+protected:
+  void run() override;
+
+private:
+  enum Request{NoRequest, ConnectRequest, DisconnectRequest, QuitRequest};
+
+  /// queues a request for the connection thread, replacing a pending one
+  void PostRequest(Request request, const std::vector<navAPI::MarkerId>& geometries);
+
+  /// detects, configures and supervises the camera until another request arrives, then closes it
+  void RunConnection(const std::vector<navAPI::MarkerId>& geometries);
+
+  void SetState(State state);
+
+  /// sleeps up to ms, returns false if a request is pending
+  bool Sleep(unsigned int ms);
+
+  static const unsigned int   SUPERVISION_PERIOD = 100; // ms
+
+  navAPI*                     mAPI;
+
+  std::atomic<State>          mState;
+  std::atomic<unsigned int>   mRetryPeriod;
+  std::atomic<unsigned int>   mDeviceLostTimeout;
+  std::atomic<bool>           mConnectionRequested;
+
+  // pending request, guarded by mMutex
+  Request                     mRequest;
+  std::vector<navAPI::MarkerId> mRequestedGeometries;
+  std::mutex                  mMutex;
+  std::condition_variable     mWakeUp;
+};
+
+#endif // CAMERACONNECTIONMANAGER_H
@@ -0,0 +1,82 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef LATENCYMONITOR_H
+#define LATENCYMONITOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <CASLibExports.h>
+
+/*  Rolling latency statistics of the tracking-to-render path.
+
+    Stages (consecutive, so a regression can be attributed to one of them):
+      Capture -> publish:       device capture until navAPI publishes the pose
+      Publish -> delivery:      until the GUI thread reads the pose
+      Delivery -> scene update: NodesManager update of the marker
+      Scene update -> render:   until the render windows finished drawing
+      Publish -> render:        total, as seen on screen
+
+    The device clock is not synchronized with the host clock, so the capture stage is reported
+    relative to its minimum in the window (constant transport delays are not included).
+    Not thread safe: samples are added and read by the GUI thread.*/
+class CASLib_EXPORT LatencyMonitor
+{
+public:
+  enum Stage{CaptureToPublish, PublishToDelivery, DeliveryToSceneUpdate, SceneUpdateToRender, PublishToRender, NumberOfStages};
+
+  struct Statistics
+  {
+    std::size_t count;
+    double      p50;      // us
+    double      p95;
+    double      p99;
+    double      maximum;
+  };
+
+  explicit LatencyMonitor(std::size_t window = 1024);
+
+  /// Host time in us (monotonic clock, comparable between threads)
+  static uint64_t Now();
+
+  static const char* GetStageName(Stage stage);
+
+  /// Adds a stage duration in us
+  void AddSample(Stage stage, double us);
+
+  /// Adds a capture sample from the device timestamp and the host publish time (both in us)
+  void AddCaptureSample(uint64_t deviceTimestamp, uint64_t publishTime);
+
+  /// Percentiles over the last samples of the stage
+  Statistics GetStatistics(Stage stage) const;
+
+  void Reset();
+
+  std::string ToText() const;
+  std::string ToJSON() const;
+  bool ExportCSV(const std::string& fileName) const;
+  bool ExportJSON(const std::string& fileName) const;
+
+private:
+  struct Window
+  {
+    std::vector<double> samples;
+    std::size_t         next;
+    std::size_t         count;
+  };
+
+  std::size_t         mWindowSize;
+  Window              mStages[NumberOfStages];
+
+  // percentile computation buffer
+  mutable std::vector<double> mScratch;
+};
+
+#endif // LATENCYMONITOR_H
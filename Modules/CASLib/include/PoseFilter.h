@@ -0,0 +1,91 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef POSEFILTER_H
+#define POSEFILTER_H
+
+#include <CASLibExports.h>
+
+#include <RigidTransform.h>
+
+/*  Smoothing and latency compensation for the pose of a single tool.
+
+    OneEuro: adaptive low-pass filter, strong smoothing when the tool is still (removes jitter)
+             and little smoothing when it moves fast (avoids lag).
+    Kalman:  constant-velocity Kalman filter, per translation axis and per rotation axis (the
+             rotation is filtered as a small error angle around the predicted orientation).
+
+    Both estimate the velocity, which is used to extrapolate the pose by the prediction horizon
+    (the expected delay until the pose is displayed).
+    Poses are 3x4 matrices: rotation and translation in mm.*/
+class CASLib_EXPORT PoseFilter
+{
+public:
+  enum FilterType{NoFilter=0, OneEuro=1, Kalman=2};
+
+  PoseFilter();
+
+  void SetType(FilterType type);
+  inline FilterType GetType() const {return mType;}
+
+  /*  minCutoff (Hz): cutoff frequency when the tool is still
+      beta: cutoff increase per mm/s of speed, rotationBeta: per rad/s of angular speed
+      derivativeCutoff (Hz): cutoff frequency of the velocity estimate*/
+  void SetOneEuroParameters(double minCutoff, double beta, double rotationBeta, double derivativeCutoff);
+
+  /*  Standard deviation of the measurement noise (mm, rad) and of the
+      acceleration (mm/s^2, rad/s^2) that drives the velocity changes*/
+  void SetKalmanParameters(double positionNoise, double orientationNoise, double acceleration, double angularAcceleration);
+
+  /// Extrapolation of the filtered pose, in ms (0 disables the prediction)
+  inline void SetPredictionHorizon(double ms){mPredictionHorizon = ms/1000.0;}
+  inline double GetPredictionHorizon() const {return mPredictionHorizon*1000.0;}
+
+  /// Forget the filter state: the next pose is taken as is
+  inline void Reset(){mInitialized = false;}
+
+  /*  Filters a pose sampled at time (seconds, any monotonic clock).
+      The filter restarts if the time goes backwards or after a gap longer than MAXIMUM_GAP.*/
+  void Update(const double pose[3][4], double time, double filtered[3][4]);
+
+  static const double MAXIMUM_GAP;   // s
+
+private:
+  void UpdateOneEuro(const double position[3], const Quaternion& orientation, double dt);
+  void UpdateKalman(const double position[3], const Quaternion& orientation, double dt);
+
+  FilterType  mType;
+
+  // one euro parameters
+  double      mMinCutoff;
+  double      mBeta;
+  double      mRotationBeta;
+  double      mDerivativeCutoff;
+
+  // kalman parameters
+  double      mPositionNoise;
+  double      mOrientationNoise;
+  double      mAcceleration;
+  double      mAngularAcceleration;
+
+  double      mPredictionHorizon;   // s
+
+  // state: filtered pose and its velocity
+  bool        mInitialized;
+  double      mLastTime;
+  double      mPosition[3];
+  Quaternion  mOrientation;           // unit quaternion
+  double      mVelocity[3];           // mm/s
+  double      mAngularVelocity[3];    // rad/s, in the tool frame
+
+  // kalman covariance of (value, velocity) per axis
+  double      mTranslationCovariance[3][2][2];
+  double      mRotationCovariance[3][2][2];
+};
+
+#endif // POSEFILTER_H
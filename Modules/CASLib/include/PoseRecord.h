@@ -0,0 +1,34 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef POSERECORD_H
+#define POSERECORD_H
+
+#include <cstdint>
+
+/*  Pose of a marker relative to the reference marker, as published by the tracking thread.
+    Plain value type, so it can be copied through lock-free buffers.*/
+struct PoseRecord
+{
+  /// geometry id of the marker (navAPI::MarkerId)
+  uint32_t  markerId;
+
+  /// rotation (3x3) and translation (last column, mm)
+  double    pose[3][4];
+
+  /// device timestamp in us
+  uint64_t  timestamp;
+
+  /// host time (LatencyMonitor::Now) when the pose was published
+  uint64_t  publishTime;
+
+  /// marker registration error in mm (lower is better)
+  double    quality;
+};
+
+#endif // POSERECORD_H
@@ -0,0 +1,67 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef RELATIVEPOSEKERNEL_H
+#define RELATIVEPOSEKERNEL_H
+
+#include <cstddef>
+
+/*  Poses of several tools in structure-of-arrays form: element k of every pose is stored
+    contiguously (rotation[k][tool], translation[k][tool]), so the kernel below runs every
+    element over all tools in a single unit-stride loop that the compiler vectorizes.*/
+template <std::size_t Capacity>
+struct PoseBatch
+{
+  static constexpr std::size_t GetCapacity(){return Capacity;}
+
+  std::size_t     count = 0;
+  alignas(32) double rotation[9][Capacity];     // row major r00 r01 r02 r10 ... r22
+  alignas(32) double translation[3][Capacity];
+};
+
+/*  Relative poses of all the tools of a batch with respect to the reference pose (R_ref, t_ref):
+      R = R_ref^T * R_tool
+      t = R_ref^T * (t_tool - t_ref)
+    Since the rotation is a matrix from SO(3), its inverse is the transposed matrix.*/
+template <std::size_t Capacity>
+inline void ComputeRelativePoses(const double referenceRotation[3][3], const double referenceTranslation[3],
+                                 const PoseBatch<Capacity>& tools, PoseBatch<Capacity>& relative)
+{
+  const std::size_t n = tools.count;
+  relative.count = n;
+
+  for (unsigned int i=0; i<3; i++)
+  {
+    // column i of the reference rotation is row i of its inverse
+    const double a0 = referenceRotation[0][i];
+    const double a1 = referenceRotation[1][i];
+    const double a2 = referenceRotation[2][i];
+    const double at = a0*referenceTranslation[0] + a1*referenceTranslation[1] + a2*referenceTranslation[2];
+
+    for (unsigned int j=0; j<3; j++)
+    {
+      const double* r0 = tools.rotation[j];
+      const double* r1 = tools.rotation[3+j];
+      const double* r2 = tools.rotation[6+j];
+      double* out = relative.rotation[3*i+j];
+
+      for (std::size_t t=0; t<n; t++)
+        out[t] = a0*r0[t] + a1*r1[t] + a2*r2[t];
+    }
+
+    const double* t0 = tools.translation[0];
+    const double* t1 = tools.translation[1];
+    const double* t2 = tools.translation[2];
+    double* out = relative.translation[i];
+
+    for (std::size_t t=0; t<n; t++)
+      out[t] = a0*t0[t] + a1*t1[t] + a2*t2[t] - at;
+  }
+}
+
+#endif // RELATIVEPOSEKERNEL_H
@@ -0,0 +1,100 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef REPLAYTRACKINGSOURCE_H
+#define REPLAYTRACKINGSOURCE_H
+
+#include <chrono>
+#include <fstream>
+#include <set>
+
+#include "TrackingSource.h"
+#include "TrackingLog.h"
+
+/*  Tracking source that plays back a recorded session, so the navigation pipeline can be run
+    and profiled without a camera.
+
+    Recording format (text, one marker per line, '#' starts a comment):
+      timestampUS;geometryId;r00;r01;r02;r10;r11;r12;r20;r21;r22;tx;ty;tz;registrationErrorMM
+    Consecutive lines with the same timestamp belong to the same frame.
+    A line with only a timestamp is a frame without markers.
+    Binary tracking logs written by TrackingRecorder are replayed as well (detected by their header).*/
+class CASLib_EXPORT ReplayTrackingSource : public TrackingSource
+{
+public:
+  ReplayTrackingSource();
+  ~ReplayTrackingSource() override;
+
+  void SetFileName(const std::string& fileName){mFileName = fileName;}
+  const std::string& GetFileName() const {return mFileName;}
+
+  /*  Playback speed: 1 keeps the original timing, 2 plays twice as fast, etc.
+      0 delivers frames as fast as possible.*/
+  void SetSpeed(double speed){mSpeed = speed;}
+  double GetSpeed() const {return mSpeed;}
+
+  /// Restart from the beginning when the end of the recording is reached
+  void SetLoop(bool loop){mLoop = loop;}
+
+  std::string GetName() const override {return "Replay of " + mFileName;}
+
+  bool Detect() override;
+  bool Open() override;
+  bool Close() override;
+  bool IsOpen() const override {return mFile.is_open() || mLog.IsOpen();}
+
+  /// Only markers of added geometries are replayed (all of them if none is added)
+  bool AddGeometry(uint32_t geometryId, const std::string& geometryFile) override;
+
+  bool StartStreaming() override;
+  void StopStreaming() override;
+  FrameStatus WaitForFrame(TrackingFrame& frame, unsigned int timeout) override;
+
+  /// Continue the replay from the given device timestamp (tracking logs only)
+  bool SeekToTimestamp(uint64_t timestamp);
+
+  /// Number of frames delivered since StartStreaming
+  unsigned long long GetNumberOfReplayedFrames() const {return mReplayedFrames;}
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  /// Reads the next frame of the recording into mPendingFrame
+  bool ReadNextFrame();
+
+  /// Reads the next frame of a tracking log into mPendingFrame
+  bool ReadNextLogFrame();
+
+  /// Parses one line; returns false for comments and malformed lines
+  bool ParseLine(const std::string& line, uint64_t& timestamp, TrackingMarker& marker, bool& hasMarker) const;
+
+  bool Rewind();
+
+  std::string         mFileName;
+  std::ifstream       mFile;
+  TrackingLogReader   mLog;
+  double              mSpeed;
+  bool                mLoop;
+  std::set<uint32_t>  mGeometries;
+
+  // frame read from the file, waiting for its time to be delivered
+  TrackingFrame       mPendingFrame;
+  bool                mHasPendingFrame;
+
+  // first line of the next frame (already read while looking for the end of the pending one)
+  std::string         mLookAheadLine;
+
+  // playback clock
+  Clock::time_point   mStartTime;
+  uint64_t            mFirstTimestamp;
+  bool                mClockStarted;
+
+  unsigned long long  mReplayedFrames;
+};
+
+#endif // REPLAYTRACKINGSOURCE_H
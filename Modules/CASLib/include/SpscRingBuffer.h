@@ -0,0 +1,142 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef SPSCRINGBUFFER_H
+#define SPSCRINGBUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/*  Fixed-capacity, lock-free ring buffer for one producer thread and one consumer thread.
+    The producer never blocks: when the consumer falls behind the oldest records are overwritten
+    (and accounted as dropped). Every slot is protected by a sequence number, so the consumer can
+    either read the newest record or drain the records in order.
+    T must be a plain value type (trivially copyable).*/
+template <typename T, std::size_t Capacity>
+class SpscRingBuffer
+{
+  static_assert(Capacity > 0, "SpscRingBuffer capacity must be positive");
+
+public:
+  SpscRingBuffer() : mHead(0), mTail(0), mDropped(0)
+  {
+    for (std::size_t i=0; i<Capacity; i++)
+      mSlots[i].sequence.store(0, std::memory_order_relaxed);
+  }
+
+  SpscRingBuffer(const SpscRingBuffer&) = delete;
+  SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+  static constexpr std::size_t GetCapacity(){return Capacity;}
+
+  // ** producer side ** //
+
+  void Push(const T& value)
+  {
+    const uint64_t index = mHead.load(std::memory_order_relaxed);
+    Slot& slot = mSlots[index % Capacity];
+
+    // odd sequence: slot is being written
+    slot.sequence.store(2*index+1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.value = value;
+    slot.sequence.store(2*index+2, std::memory_order_release);
+
+    mHead.store(index+1, std::memory_order_release);
+  }
+
+  // ** consumer side ** //
+
+  /// Total number of records pushed so far (index of the next record to be written)
+  uint64_t GetNumberOfPushedRecords() const {return mHead.load(std::memory_order_acquire);}
+
+  /// Copy the newest record. Returns false if nothing was pushed yet.
+  bool ReadLatest(T& out, uint64_t* index = nullptr) const
+  {
+    for (;;)
+    {
+      const uint64_t head = mHead.load(std::memory_order_acquire);
+      if (head == 0)
+        return false;
+
+      // retry if the producer overwrote the slot while it was copied
+      if (ReadSlot(head-1,out))
+      {
+        if (index != nullptr)
+          *index = head-1;
+        return true;
+      }
+    }
+  }
+
+  /// Copy the oldest unread record and advance. Returns false if there is nothing new.
+  bool Pop(T& out)
+  {
+    for (;;)
+    {
+      const uint64_t head = mHead.load(std::memory_order_acquire);
+      if (mTail >= head)
+        return false;
+
+      // consumer fell behind: skip the overwritten records
+      if (head - mTail > Capacity)
+      {
+        mDropped += head - mTail - Capacity;
+        mTail = head - Capacity;
+      }
+
+      if (ReadSlot(mTail,out))
+      {
+        ++mTail;
+        return true;
+      }
+    }
+  }
+
+  /// Mark every record pushed so far as read
+  void Clear()
+  {
+    mTail = mHead.load(std::memory_order_acquire);
+  }
+
+  /// Number of records overwritten before Pop could read them
+  uint64_t GetNumberOfDroppedRecords() const {return mDropped;}
+
+private:
+  bool ReadSlot(uint64_t index, T& out) const
+  {
+    const Slot& slot = mSlots[index % Capacity];
+    const uint64_t expected = 2*index+2;
+
+    if (slot.sequence.load(std::memory_order_acquire) != expected)
+      return false;
+
+    out = slot.value;
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return slot.sequence.load(std::memory_order_relaxed) == expected;
+  }
+
+  struct Slot
+  {
+    std::atomic<uint64_t> sequence;
+    T                     value;
+  };
+
+  Slot                    mSlots[Capacity];
+
+  // written by the producer only
+  std::atomic<uint64_t>   mHead;
+
+  // used by the consumer only
+  uint64_t                mTail;
+  uint64_t                mDropped;
+};
+
+#endif // SPSCRINGBUFFER_H
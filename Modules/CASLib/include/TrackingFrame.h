@@ -0,0 +1,59 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef TRACKINGFRAME_H
+#define TRACKINGFRAME_H
+
+#include <cstdint>
+
+/*  Device independent description of one tracking frame.
+    Plain value type with fixed capacities, so frames can be copied and queued without allocations.*/
+
+static const uint32_t TRACKING_MAX_MARKERS = 16;
+static const uint32_t TRACKING_MAX_FIDUCIALS = 64;
+static const uint32_t TRACKING_MAX_MARKER_FIDUCIALS = 6;
+static const uint32_t TRACKING_INVALID_ID = 0xFFFFFFFF;
+
+struct TrackingMarker
+{
+  uint32_t  geometryId;
+
+  /// marker pose in camera coordinates
+  double    rotation[3][3];
+  double    translationMM[3];
+
+  double    registrationErrorMM;
+
+  /// index in TrackingFrame::fiducials of each geometry fiducial (TRACKING_INVALID_ID if not matched)
+  uint32_t  fiducialCorresp[TRACKING_MAX_MARKER_FIDUCIALS];
+};
+
+struct TrackingFiducial
+{
+  double    positionMM[3];
+  double    probability;
+};
+
+struct TrackingFrame
+{
+  /// device timestamp in us
+  uint64_t          timestamp;
+
+  uint32_t          markersCount;
+  TrackingMarker    markers[TRACKING_MAX_MARKERS];
+
+  /// true if the device had more markers than the frame could hold
+  bool              markersOverflow;
+
+  /// raw 3D fiducials, only meaningful if fiducialsValid
+  bool              fiducialsValid;
+  uint32_t          fiducialsCount;
+  TrackingFiducial  fiducials[TRACKING_MAX_FIDUCIALS];
+};
+
+#endif // TRACKINGFRAME_H
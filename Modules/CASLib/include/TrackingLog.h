@@ -0,0 +1,146 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef TRACKINGLOG_H
+#define TRACKINGLOG_H
+
+#include <string>
+#include <vector>
+
+#include <QFile>
+
+#include <CASLibExports.h>
+
+#include "TrackingFrame.h"
+
+/*  Binary tracking session log (*.navlog).
+
+    File layout:
+      header (64 bytes)  magic "NAVCASTL", version, key frame interval, start time (ms since epoch)
+      records            [type (1 byte)][payload size (varint)][payload]
+      index              one entry per key frame: frame number, timestamp, file offset
+      trailer (40 bytes) index offset, number of frames, number of index entries, last timestamp,
+                         magic "NAVCASIX"
+
+    Payloads are delta encoded against the previous frame (markers are matched by geometry id,
+    fiducials by index) with zigzag varints. Key frames are encoded against an empty frame, so
+    decoding can start at any of them. Values are quantized: 1 um for positions, 1e-7 for rotation
+    elements and 1e-4 for registration errors and probabilities.
+    A log that was not closed (crash) has no trailer; the reader rebuilds the index by scanning.*/
+
+/// Quantized values of the previously encoded/decoded frame
+struct TrackingLogState
+{
+  void Reset(){markersCount = 0; fiducialsCount = 0; timestamp = 0;}
+
+  uint64_t  timestamp;
+  uint32_t  markersCount;
+  uint32_t  geometryId[TRACKING_MAX_MARKERS];
+  int64_t   marker[TRACKING_MAX_MARKERS][13];
+  uint32_t  fiducialsCount;
+  int64_t   fiducial[TRACKING_MAX_FIDUCIALS][4];
+};
+
+struct TrackingLogIndexEntry
+{
+  uint64_t  frameNumber;
+  uint64_t  timestamp;
+  uint64_t  offset;
+};
+
+/*  Appends frames to a memory-mapped log. The mapping grows in chunks.*/
+class CASLib_EXPORT TrackingLogWriter
+{
+public:
+  TrackingLogWriter();
+  ~TrackingLogWriter();
+
+  bool Open(const std::string& fileName, uint32_t keyFrameInterval = 128);
+  bool Write(const TrackingFrame& frame);
+
+  /// Writes the index and the trailer and trims the file
+  bool Close();
+
+  bool IsOpen() const {return mMap != nullptr;}
+  uint64_t GetNumberOfFrames() const {return mNumberOfFrames;}
+  uint64_t GetSize() const {return mOffset;}
+
+private:
+  /// Makes sure that bytes can be appended at mOffset
+  bool Reserve(uint64_t bytes);
+  void Append(const void* data, uint64_t bytes);
+
+  QFile                               mFile;
+  uchar*                              mMap;
+  uint64_t                            mMapSize;
+  uint64_t                            mOffset;
+
+  uint32_t                            mKeyFrameInterval;
+  uint64_t                            mNumberOfFrames;
+  TrackingLogState                    mState;
+  std::vector<uint8_t>                mPayload;
+  std::vector<TrackingLogIndexEntry>  mIndex;
+};
+
+/*  Random access reader: the index is loaded on Open, so any frame can be reached by decoding
+    at most one key frame interval.*/
+class CASLib_EXPORT TrackingLogReader
+{
+public:
+  TrackingLogReader();
+  ~TrackingLogReader();
+
+  bool Open(const std::string& fileName);
+  void Close();
+  bool IsOpen() const {return mData != nullptr;}
+
+  /// Checks the file magic without opening the log
+  static bool IsTrackingLog(const std::string& fileName);
+
+  uint64_t GetNumberOfFrames() const {return mNumberOfFrames;}
+  uint64_t GetFirstTimestamp() const {return mFirstTimestamp;}
+  uint64_t GetLastTimestamp() const {return mLastTimestamp;}
+
+  /// Recording start, in ms since epoch
+  uint64_t GetStartTime() const {return mStartTime;}
+
+  /// Number of the frame returned by the next ReadNext
+  uint64_t Tell() const {return mNextFrame;}
+
+  bool Seek(uint64_t frameNumber);
+
+  /// Moves to the first frame with a timestamp greater or equal than the given one
+  bool SeekToTimestamp(uint64_t timestamp);
+
+  bool ReadNext(TrackingFrame& frame);
+
+private:
+  /// Scans the records of a log without trailer
+  bool BuildIndex();
+
+  /// Decodes the record at mPosition and advances
+  bool DecodeNext(TrackingFrame& frame, bool* keyFrame = nullptr);
+
+  QFile                               mFile;
+  const uchar*                        mData;
+  uint64_t                            mRecordsEnd;
+
+  uint64_t                            mStartTime;
+  uint64_t                            mNumberOfFrames;
+  uint64_t                            mFirstTimestamp;
+  uint64_t                            mLastTimestamp;
+  std::vector<TrackingLogIndexEntry>  mIndex;
+
+  // decoding position
+  uint64_t                            mPosition;
+  uint64_t                            mNextFrame;
+  TrackingLogState                    mState;
+  TrackingFrame                       mScratch;
+};
+
+#endif // TRACKINGLOG_H
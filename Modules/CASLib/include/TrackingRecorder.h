@@ -0,0 +1,59 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef TRACKINGRECORDER_H
+#define TRACKINGRECORDER_H
+
+#include <atomic>
+#include <string>
+
+#include <QThread>
+
+#include <CASLibExports.h>
+
+#include "SpscRingBuffer.h"
+#include "TrackingLog.h"
+
+/*  Records tracking frames to a tracking log (see TrackingLog.h).
+    The acquisition thread only copies each frame into a lock-free queue; encoding and writing
+    happen in the recorder thread. If the recorder falls behind, the oldest queued frames are
+    dropped (and counted) instead of delaying the acquisition.*/
+class CASLib_EXPORT TrackingRecorder : public QThread
+{
+public:
+  TrackingRecorder();
+  ~TrackingRecorder();
+
+  bool Start(const std::string& fileName);
+  void Stop();
+  bool IsRecording() const {return mRecording;}
+
+  /// Called by the acquisition thread for every frame, never blocks
+  inline void Push(const TrackingFrame& frame){if (mRecording) mQueue.Push(frame);}
+
+  const std::string& GetFileName() const {return mFileName;}
+  uint64_t GetNumberOfRecordedFrames() const {return mRecordedFrames;}
+  uint64_t GetNumberOfDroppedFrames() const {return mDroppedFrames;}
+
+protected:
+  void run() override;
+
+private:
+  typedef SpscRingBuffer<TrackingFrame,256> FrameQueue;
+
+  FrameQueue              mQueue;
+  TrackingLogWriter       mWriter;
+  TrackingFrame           mFrame;
+  std::string             mFileName;
+
+  std::atomic<bool>       mRecording;
+  std::atomic<uint64_t>   mRecordedFrames;
+  std::atomic<uint64_t>   mDroppedFrames;
+};
+
+#endif // TRACKINGRECORDER_H
@@ -0,0 +1,47 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef TRACKINGSNAPSHOT_H
+#define TRACKINGSNAPSHOT_H
+
+#include <cstdint>
+
+#include "PoseRecord.h"
+#include "SpscRingBuffer.h"
+#include "TrackingFrame.h"
+
+/*  Everything the GUI needs from one published frame: the markers in view and the poses of the
+    tracked tools. Written once by the acquisition thread and never modified afterwards.*/
+struct TrackingSnapshot
+{
+  /// device timestamp in us
+  uint64_t    timestamp;
+
+  /// host time (LatencyMonitor::Now) when the snapshot was published
+  uint64_t    publishTime;
+
+  /// geometry ids of every marker detected in the frame (tracked or not), in frame order
+  uint32_t    markersCount;
+  uint32_t    markers[TRACKING_MAX_MARKERS];
+
+  /// geometry of the only marker in view if it is not a probe, 0 otherwise
+  uint32_t    singleMarker;
+
+  /// probe (temporal probe with raw data) and reference marker in view
+  bool        validProbe;
+  bool        validTemporalProbe;
+
+  /// poses of the tracked tools relative to the reference marker (none without reference)
+  uint32_t    posesCount;
+  uint32_t    poseSlot[TRACKING_MAX_MARKERS];
+  PoseRecord  poses[TRACKING_MAX_MARKERS];
+};
+
+typedef SpscRingBuffer<TrackingSnapshot,8> TrackingSnapshotBuffer;
+
+#endif // TRACKINGSNAPSHOT_H
@@ -0,0 +1,78 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef TRACKINGSOURCE_H
+#define TRACKINGSOURCE_H
+
+#include <atomic>
+#include <string>
+
+#include <CASLibExports.h>
+
+#include "TrackingFrame.h"
+
+/*  Abstract provider of tracking frames used by navAPI.
+    Detect/Open/AddGeometry/Close are called from the camera connection thread, while
+    StartStreaming, WaitForFrame and StopStreaming are called from the navAPI acquisition thread.*/
+class CASLib_EXPORT TrackingSource
+{
+public:
+  enum FrameStatus{NewFrame, Timeout, DeviceError, EndOfStream, FatalError};
+
+  virtual ~TrackingSource(){}
+
+  /// Human readable name, for logs
+  virtual std::string GetName() const = 0;
+
+  /// Checks whether the source is available (without keeping it open)
+  virtual bool Detect() = 0;
+
+  virtual bool Open() = 0;
+  virtual bool Close() = 0;
+  virtual bool IsOpen() const = 0;
+
+  /// Registers a marker geometry to be tracked
+  virtual bool AddGeometry(uint32_t geometryId, const std::string& geometryFile) = 0;
+
+  /// Prepares the frame acquisition (acquisition thread)
+  virtual bool StartStreaming() = 0;
+  virtual void StopStreaming() = 0;
+
+  /*  Blocks until a new frame is available or the timeout (ms) expires.
+      On NewFrame the frame is overwritten.*/
+  virtual FrameStatus WaitForFrame(TrackingFrame& frame, unsigned int timeout) = 0;
+
+  /*  Frame counters, updated by the acquisition thread and readable from any thread.
+      Sources that cannot detect an event leave its counter at 0.*/
+  inline uint64_t GetNumberOfFrames() const {return mNumberOfFrames;}
+
+  /// device frames that were never delivered (e.g. the host did not fetch them in time)
+  inline uint64_t GetNumberOfSkippedFrames() const {return mNumberOfSkippedFrames;}
+
+  /// frames that lost markers or fiducials because the frame buffer was too small
+  inline uint64_t GetNumberOfOverflows() const {return mNumberOfOverflows;}
+
+  /// frames the device could not reprocess (delivered with their original processing)
+  inline uint64_t GetNumberOfReprocessFailures() const {return mNumberOfReprocessFailures;}
+
+  void ResetStatistics()
+  {
+    mNumberOfFrames = 0;
+    mNumberOfSkippedFrames = 0;
+    mNumberOfOverflows = 0;
+    mNumberOfReprocessFailures = 0;
+  }
+
+protected:
+  std::atomic<uint64_t>   mNumberOfFrames{0};
+  std::atomic<uint64_t>   mNumberOfSkippedFrames{0};
+  std::atomic<uint64_t>   mNumberOfOverflows{0};
+  std::atomic<uint64_t>   mNumberOfReprocessFailures{0};
+};
+
+#endif // TRACKINGSOURCE_H
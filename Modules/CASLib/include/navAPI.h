@@ -9,17 +9,20 @@ navCAS navigation system
 #ifndef NAVAPI_H
 #define NAVAPI_H
 
-#include <QThread>
-#include <QTimer>
+#include <atomic>
+#include <memory>
 
-#include <vtkMatrix4x4.h>
+#include <QThread>
 
 #include <mitkPoint.h>
 
-#include <ftkInterface.h>
-
 #include <CASLibExports.h>
 
+#include "RelativePoseKernel.h"
+#include "TrackingSnapshot.h"
+#include "TrackingSource.h"
+#include "TrackingRecorder.h"
+
 class CASLib_EXPORT navAPI : public QThread
 {
     Q_OBJECT
@@ -31,55 +34,154 @@ public:
 
     static std::string GetGeometryFileName(MarkerId);
 
+    /*  Frames are read from a tracking source: an Atracsys camera by default, or a recorded session
+        when the NAVCAS_REPLAY_FILE environment variable is set (NAVCAS_REPLAY_SPEED sets its speed).
+        navAPI takes ownership of the source. Must not be called while navigating.*/
+    void SetTrackingSource(TrackingSource* source);
+    inline TrackingSource* GetTrackingSource(){return mSource.get();}
+
     bool DetectCamera();
     bool InitializeCamera();
-    bool SetModeToStandard();
     bool CloseCamera();
+    /// Loads the geometry and assigns it a tool slot. Must not be called while navigating.
     bool AddGeometry(const MarkerId geom);
     void StopNavigation();
 
-    inline void SetSamplingPeriod(int sp){mSamplingPeriod = sp;}
+    /// Upper bound for the published frame rate in Hz, 0 publishes every camera frame
+    void SetMaximumFrameRate(double hz);
+    double GetMaximumFrameRate() const;
+
+    /// Minimum period between published frames in ms (0 for the native camera rate)
+    inline void SetSamplingPeriod(int sp){SetMaximumFrameRate(sp > 0 ? 1000.0/sp : 0.0);}
+
+    /// Time in ms the acquisition loop blocks waiting for a new frame before checking for stop requests
+    inline void SetFrameTimeout(unsigned int ms){mFrameTimeout = ms;}
 
     /*  Refrence marker only depends on the geometry of the marker.
         Every dissociated volume should be assigned a differente geometry
         Probe must not be used as reference marker.*/
     void SetReferenceMarker(const MarkerId geom){mReferenceMarkerType = geom;}
 
-    void run();
+    /*  Acquisition loop: blocks on the next device frame and publishes it as soon as it arrives.
+        Frames arriving faster than the maximum frame rate are dropped.*/
+    void run() override;
+
+    /// Starts the acquisition thread (hides QThread::start to reset the stop request first)
+    void start();
+
+    /// True while the source reports device errors instead of frames (e.g. camera unplugged)
+    inline bool HasDeviceError() const {return mDeviceError;}
+
+    /*  Records every frame delivered by the source (before frame rate limiting) to a tracking log.
+        Recording can be started and stopped while navigating.*/
+    bool StartRecording(const std::string& fileName){return mRecorder.Start(fileName);}
+    void StopRecording(){mRecorder.Stop();}
+    inline bool IsRecording() const {return mRecorder.IsRecording();}
+    inline const TrackingRecorder& GetRecorder() const {return mRecorder;}
+
+    /// Maximum number of tools (geometries) tracked at once
+    static const unsigned int MAX_TOOLS = TRACKING_MAX_MARKERS;
+
+    /*  Every added geometry gets a tool slot, in the order AddGeometry is called.
+        Slots are kept while the application runs (adding a geometry twice reuses its slot).*/
+    inline unsigned int GetNumberOfTools() const {return mNumberOfTools;}
+    inline uint32_t GetToolGeometry(unsigned int slot) const {return mToolGeometry[slot];}
+
+    /// Slot of the geometry, -1 if it was never added
+    int GetToolSlot(uint32_t geometryId) const;
+
+    /*  One snapshot per published frame (markers in view and relative poses of the tools), written
+        by the acquisition thread. A single consumer (the GUI thread) pops them at render time.
+        The visibility signals below are only emitted when the visibility changes.*/
+    inline TrackingSnapshotBuffer& GetSnapshotBuffer(){return mSnapshots;}
+
+    /*  Frames with raw 3D fiducials, published at the full camera rate (before frame rate limiting)
+        for calibration and geometry creation, only while a raw capture is enabled. The buffer is
+        preallocated: a single consumer copies the frames out with ReadLatest/Pop, nothing is
+        allocated per frame. Clear the buffer when enabling the capture to skip older frames.*/
+    typedef SpscRingBuffer<TrackingFrame,16> RawFrameBuffer;
+    inline RawFrameBuffer& GetRawFrameBuffer(){return mRawFrames;}
+    inline void SetRawCaptureEnabled(bool enabled){mRawCapture = enabled;}
+    inline bool IsRawCaptureEnabled() const {return mRawCapture;}
+
+    /*  Raw fiducials matched to the marker of the geometry, indexed as the geometry fiducials:
+        valid[i] is false if fiducial i was not matched. Returns the number of matched fiducials,
+        0 if the marker is not in the frame.*/
+    static unsigned int GetMarkerFiducials(const TrackingFrame& frame, uint32_t geometryId,
+                                           mitk::Point3D fiducials[TRACKING_MAX_MARKER_FIDUCIALS],
+                                           bool valid[TRACKING_MAX_MARKER_FIDUCIALS]);
 
 signals:
     void MarkerPosition(unsigned int,std::vector<mitk::Point3D>);
-    void FiducialsRawData(std::vector<mitk::Point3D>);
     void SingleMarkerInView(navAPI::MarkerId);
     void MultipleMarkersInView(std::vector<navAPI::MarkerId>);  // must leave the namespace for correct qt conection
     void ValidProbeInView();
     void ValidTemporalProbeInView();
     void InvalidProbeInView();
     void MultipleOrNullMarkersInView();
-    void MarkerRelativePosition(unsigned int,vtkMatrix4x4*);
 
-protected slots:
+protected:
+    /*  Process the frame stored in mFrame: publish its snapshot and emit the visibility signals
+        that changed since the previous frame.*/
     void GetLastFrame();
 
-protected:
+    /// Emits the visibility signals whose state differs from mSnapshot
+    void ReportVisibility();
 
-    /*  Compute relative positions of m marker in mMarker vector*/
-    void GetRelativePositions(unsigned int m);
+    /*  Compute the poses of every visible tool relative to the reference marker into mSnapshot.
+        Linear in the number of visible tools.*/
+    void GetRelativePositions(const TrackingMarker* reference);
 
 private:
-    QTimer*                 mTimer;
-    ftkLibrary              mLib;
-    uint64                  mSn;
-    ftkFrameQuery*          mFrame;
-    MarkerId                mReferenceMarkerType=None;
-
-    /*  mMarker[0] = Reference marker
-        mMarker[1] = Moving marker
-        mMarker[2] = Probe*/
-    std::vector<ftkMarker*> mMarker;
-
-    /// sampling perior in ms
-    int                   mSamplingPeriod;
+    std::unique_ptr<TrackingSource> mSource;
+
+    /// last frame delivered by the source
+    TrackingFrame           mFrame;
+    std::atomic<MarkerId>   mReferenceMarkerType{None};
+
+    // geometry id -> tool slot, direct lookup for small ids (-1 = not tracked)
+    static const unsigned int GEOMETRY_LOOKUP_SIZE = 256;
+    int8_t                  mGeometryToSlot[GEOMETRY_LOOKUP_SIZE];
+
+    uint32_t                mToolGeometry[MAX_TOOLS];
+    unsigned int            mNumberOfTools;
+
+    /// tools of the current frame: slot and marker, in frame order
+    unsigned int            mVisibleTools;
+    unsigned int            mVisibleSlot[MAX_TOOLS];
+    const TrackingMarker*   mVisibleMarker[MAX_TOOLS];
+
+    /// visible tools (reference excluded) batched for ComputeRelativePoses
+    PoseBatch<MAX_TOOLS>    mToolPoses;
+    PoseBatch<MAX_TOOLS>    mRelativeToolPoses;
+    unsigned int            mBatchSlot[MAX_TOOLS];
+    const TrackingMarker*   mBatchMarker[MAX_TOOLS];
+
+    /// snapshot of the current frame and published snapshots
+    TrackingSnapshot        mSnapshot;
+    TrackingSnapshotBuffer  mSnapshots;
+
+    // visibility last reported through the signals (unknown until the first frame of a session)
+    bool                    mVisibilityKnown;
+    uint32_t                mReportedSingleMarker;
+    bool                    mReportedValidProbe;
+    bool                    mReportedValidTemporalProbe;
+    uint32_t                mReportedMarkersCount;
+    uint32_t                mReportedMarkers[TRACKING_MAX_MARKERS];
+
+    RawFrameBuffer          mRawFrames;
+    std::atomic<bool>       mRawCapture{false};
+
+    /// minimum period between published frames in us (0 = native camera rate)
+    std::atomic<long long>  mMinimumFramePeriod;
+
+    /// blocking timeout of TrackingSource::WaitForFrame in ms
+    unsigned int            mFrameTimeout;
+
+    std::atomic<bool>       mStopRequested;
+    std::atomic<bool>       mDeviceError;
+
+    TrackingRecorder        mRecorder;
 };
 
 
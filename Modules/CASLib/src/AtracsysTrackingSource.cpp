@@ -0,0 +1,375 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#define _WIN32_WINNT 0x0A00
+
+#ifdef FORCED_DEVICE_DLL_PATH
+#include <Windows.h>
+#endif
+
+#include <iostream>
+#include <algorithm>
+
+#include "helpers.hpp"
+#include "geometryHelper.hpp"
+
+#include "AtracsysTrackingSource.h"
+
+using namespace std;
+static const unsigned ENABLE_ONBOARD_PROCESSING_OPTION = 6000;
+static const unsigned SENDING_IMAGES_OPTION = 6003;
+
+// Depending on the OS being used, this condition might change
+const bool isNotFromConsole = isLaunchedFromExplorer();
+
+AtracsysTrackingSource::AtracsysTrackingSource()
+{
+  mLib = 0;
+  mSn = 0uLL;
+  mFrame = 0;
+
+  mGeometries = 0;
+  mGeometryFiducials = 0;
+  mMarkerCapacity = 1;
+  mFiducialCapacity = FIDUCIAL_MARGIN;
+  mHasLastCounter = false;
+  mLastCounter = 0;
+}
+
+AtracsysTrackingSource::~AtracsysTrackingSource()
+{
+  StopStreaming();
+  Close();
+}
+
+bool AtracsysTrackingSource::SetModeToStandard()
+{
+  cout << "Disabling sending images" << std::endl;
+  if (ftkSetInt32( mLib, mSn, SENDING_IMAGES_OPTION, 0) != ftkError::FTK_OK)
+  {
+    error("Cannot disable images sending on the SpryTrack.", !isNotFromConsole);
+    return false;
+  }
+
+  if (!ConfigureFrame())
+    return false;
+
+  cout.setf( ios::fixed, ios::floatfield );
+  cout.precision( 2u );
+
+  return true;
+}
+
+bool AtracsysTrackingSource::ConfigureFrame()
+{
+  if ( mFrame == 0 )
+    mFrame = ftkCreateFrame();
+
+  if ( mFrame == 0 )
+  {
+    cerr << "Cannot create frame instance" << std::endl;
+    checkError( mLib, !isNotFromConsole  );
+    return false;
+  }
+
+  // no images, only 3D fiducials and markers
+  ftkError err( ftkSetFrameOptions( false, 0, 0, 0,
+                                    mFiducialCapacity, mMarkerCapacity,
+                                    mFrame ) );
+
+  if ( err != ftkError::FTK_OK )
+  {
+    ftkDeleteFrame( mFrame );
+    mFrame = 0;
+    cerr << "Cannot initialise frame" << std::endl;
+    checkError( mLib, !isNotFromConsole );
+    return false;
+  }
+
+  return true;
+}
+
+bool AtracsysTrackingSource::Detect()
+{
+  // Defines where to find Atracsys SDK dlls when FORCED_DEVICE_DLL_PATH is set.
+#ifdef FORCED_DEVICE_DLL_PATH
+  SetDllDirectory( (LPCTSTR) FORCED_DEVICE_DLL_PATH );
+#endif
+
+  // Initialize driver
+  mLib = ftkInit();
+
+  if (!mLib)
+  {
+    error( "Cannot initialize driver" , !isNotFromConsole );
+    return false;
+  }
+
+  DeviceData device;
+  device.SerialNumber = 0uLL;
+
+  ftkError err( ftkError::FTK_OK );
+  err = ftkEnumerateDevices( mLib, deviceEnumerator, &device );
+
+  if ( (err > ftkError::FTK_OK) || ( device.SerialNumber == 0uLL ))
+  {
+    return false;
+  }
+
+  // camera was detected and has to be closed
+  Close();
+  return true;
+}
+
+bool AtracsysTrackingSource::Open()
+{
+    // -----------------------------------------------------------------------
+    // Defines where to find Atracsys SDK dlls when FORCED_DEVICE_DLL_PATH is
+    // set.
+#ifdef FORCED_DEVICE_DLL_PATH
+		SetDllDirectory( (LPCTSTR) FORCED_DEVICE_DLL_PATH );
+#endif
+
+  // ----------------------------------------------------------------------
+  // Initialize driver
+  mLib = ftkInit();
+
+  // frame capacities are sized from the geometries added to this session
+  mGeometries = 0;
+  mGeometryFiducials = 0;
+  mMarkerCapacity = 1;
+  mFiducialCapacity = FIDUCIAL_MARGIN;
+
+  if ( ! mLib )
+  {
+    error( "Cannot initialize driver" , !isNotFromConsole );
+    return false;
+  }
+
+  // ----------------------------------------------------------------------
+  // Retrieve the device
+
+  DeviceData device( retrieveLastDevice( mLib, true, false, !isNotFromConsole ) );
+  mSn = device.SerialNumber;
+
+  if (mSn == 0uLL)
+    return false;
+
+  // ------------------------------------------------------------------------
+  // When using a spryTrack, onboard processing of the images is preferred.
+  // Sending of the images is disabled so that the sample operates on a USB2
+  // connection
+  if (ftkDeviceType::DEV_SPRYTRACK_180 == device.Type)
+  {
+    cout << "Enable onboard processing" << std::endl;
+    if ( ftkSetInt32( mLib, mSn, ENABLE_ONBOARD_PROCESSING_OPTION, 1 ) != ftkError::FTK_OK )
+    {
+      error( "Cannot process data directly on the SpryTrack.", !isNotFromConsole );
+    }
+
+    cout << "Disable images sending" << std::endl;
+    if (ftkSetInt32( mLib, mSn, SENDING_IMAGES_OPTION, 0) != ftkError::FTK_OK)
+		{
+			error("Cannot disable images sending on the SpryTrack.", !isNotFromConsole);
+		}
+
+  }
+  return true;
+}
+
+bool AtracsysTrackingSource::Close()
+{
+  if (!mLib)
+    return false;
+
+  if ( ftkError::FTK_OK != ftkClose( &mLib ) )
+  {
+    checkError( mLib, !isNotFromConsole  );
+    return false;
+  }
+
+  mLib = 0;
+  mSn = 0uLL;
+  return true;
+}
+
+bool AtracsysTrackingSource::AddGeometry(uint32_t /*geometryId*/, const std::string& geomFile)
+{
+  ftkGeometry geom;
+
+  switch ( loadGeometry( mLib, mSn, geomFile, geom ) )
+  {
+  case 1:
+    cout << "Loaded from installation directory." << std::endl;
+
+  case 0:
+    if (ftkError::FTK_OK != ftkSetGeometry( mLib, mSn, &geom ) )
+    {
+      checkError( mLib, !isNotFromConsole  );
+    }
+
+    // room for every geometry in view at once
+    mGeometries++;
+    mGeometryFiducials += geom.pointsCount;
+    mMarkerCapacity = std::max<uint32_t>(mMarkerCapacity, std::min<uint32_t>(mGeometries, TRACKING_MAX_MARKERS));
+    mFiducialCapacity = std::max<uint32_t>(mFiducialCapacity, std::min<uint32_t>(mGeometryFiducials + FIDUCIAL_MARGIN, TRACKING_MAX_FIDUCIALS));
+    break;
+
+  default:
+
+    cerr << "Error, cannot load geometry file '"
+         << geomFile << "'." << std::endl;
+    if (ftkError::FTK_OK != ftkClose( &mLib ) )
+    {
+      checkError( mLib, !isNotFromConsole  );
+    }
+    mLib = 0;
+    mSn = 0uLL;
+    return false;
+  }
+  return true;
+}
+
+bool AtracsysTrackingSource::StartStreaming()
+{
+  mHasLastCounter = false;
+
+  if (!ConfigureFrame())
+    return false;
+
+  cout << "Frame capacity: " << mMarkerCapacity << " markers, " << mFiducialCapacity << " fiducials" << std::endl;
+  return true;
+}
+
+void AtracsysTrackingSource::StopStreaming()
+{
+  if (mFrame == 0)
+    return;
+
+  ftkDeleteFrame( mFrame );
+  mFrame = 0;
+}
+
+TrackingSource::FrameStatus AtracsysTrackingSource::WaitForFrame(TrackingFrame& frame, unsigned int timeout)
+{
+  // the frame could not be resized
+  if ( mFrame == 0 )
+    return FatalError;
+
+  // block until the next frame is available (or the timeout expires)
+  ftkError err = ftkGetLastFrame( mLib, mSn, mFrame, timeout );
+  if ( err > ftkError::FTK_OK )
+    return DeviceError;
+
+  if ( err != ftkError::FTK_OK )
+    return Timeout;
+
+  // counted instead of logged, this happens at frame rate
+  if (ftkReprocessFrame(mLib, mSn, mFrame) != ftkError::FTK_OK)
+    mNumberOfReprocessFailures++;
+
+  switch ( mFrame->markersStat )
+  {
+  case ftkQueryStatus::QS_WAR_SKIPPED:
+    StopStreaming();
+    cerr << "marker fields in the frame are not set correctly" << std::endl;
+    checkError( mLib, !isNotFromConsole  );
+    return FatalError;
+
+  case ftkQueryStatus::QS_ERR_INVALID_RESERVED_SIZE:
+    StopStreaming();
+    cerr << "frame -> markersVersionSize is invalid" << std::endl;
+    checkError( mLib, !isNotFromConsole  );
+    return FatalError;
+
+  case ftkQueryStatus::QS_ERR_OVERFLOW:
+    // handled below, the frame grows for the next ones
+    break;
+
+  default:
+    StopStreaming();
+    cerr << "invalid status" << std::endl;
+    checkError( mLib, !isNotFromConsole  );
+    return FatalError;
+
+  case ftkQueryStatus::QS_OK:
+    break;
+  }
+
+  CopyFrame(frame);
+  mNumberOfFrames++;
+
+  // device frames missed since the last delivered one
+  if (mFrame->imageHeaderStat == ftkQueryStatus::QS_OK)
+  {
+    const uint32 counter = mFrame->imageHeader->counter;
+
+    // modular difference, correct across the counter wrap; a counter going backwards (device reset) is not a loss
+    const uint32_t step = static_cast<uint32_t>(counter - mLastCounter);
+    if (mHasLastCounter && (step > 1) && (step < 0x80000000u))
+      mNumberOfSkippedFrames += step - 1;
+    mLastCounter = counter;
+    mHasLastCounter = true;
+  }
+
+  const bool markersOverflow = (mFrame->markersStat == ftkQueryStatus::QS_ERR_OVERFLOW);
+  const bool fiducialsOverflow = (mFrame->threeDFiducialsStat == ftkQueryStatus::QS_ERR_OVERFLOW);
+  if (markersOverflow || fiducialsOverflow)
+  {
+    mNumberOfOverflows++;
+
+    // this frame already lost data, grow the capacities for the next ones
+    const uint32_t markers = markersOverflow ? std::min<uint32_t>(2*mMarkerCapacity, TRACKING_MAX_MARKERS) : mMarkerCapacity.load();
+    const uint32_t fiducials = fiducialsOverflow ? std::min<uint32_t>(2*mFiducialCapacity, TRACKING_MAX_FIDUCIALS) : mFiducialCapacity.load();
+    if ((markers != mMarkerCapacity) || (fiducials != mFiducialCapacity))
+    {
+      mMarkerCapacity = markers;
+      mFiducialCapacity = fiducials;
+      cout << "Frame capacity increased to " << markers << " markers, " << fiducials << " fiducials" << std::endl;
+      ConfigureFrame();
+    }
+  }
+
+  return NewFrame;
+}
+
+void AtracsysTrackingSource::CopyFrame(TrackingFrame& frame) const
+{
+  frame.timestamp = (mFrame->imageHeaderStat == ftkQueryStatus::QS_OK) ? mFrame->imageHeader->timestampUS : 0uLL;
+  frame.markersOverflow = (mFrame->markersStat == ftkQueryStatus::QS_ERR_OVERFLOW);
+
+  frame.markersCount = std::min<uint32_t>(mFrame->markersCount, TRACKING_MAX_MARKERS);
+  for (uint32_t m=0; m<frame.markersCount; m++)
+  {
+    const ftkMarker& source = mFrame->markers[m];
+    TrackingMarker& marker = frame.markers[m];
+
+    marker.geometryId = source.geometryId;
+    marker.registrationErrorMM = source.registrationErrorMM;
+    for (unsigned int i=0; i<3; i++)
+    {
+      for (unsigned int j=0; j<3; j++)
+        marker.rotation[i][j] = source.rotation[i][j];
+      marker.translationMM[i] = source.translationMM[i];
+    }
+
+    for (uint32_t f=0; f<TRACKING_MAX_MARKER_FIDUCIALS; f++)
+      marker.fiducialCorresp[f] = (f < FTK_MAX_FIDUCIALS) ? source.fiducialCorresp[f] : TRACKING_INVALID_ID;
+  }
+
+  frame.fiducialsValid = (mFrame->threeDFiducialsStat == ftkQueryStatus::QS_OK);
+  frame.fiducialsCount = frame.fiducialsValid ? std::min<uint32_t>(mFrame->threeDFiducialsCount, TRACKING_MAX_FIDUCIALS) : 0;
+  for (uint32_t f=0; f<frame.fiducialsCount; f++)
+  {
+    const ftk3DFiducial& source = mFrame->threeDFiducials[f];
+    frame.fiducials[f].positionMM[0] = source.positionMM.x;
+    frame.fiducials[f].positionMM[1] = source.positionMM.y;
+    frame.fiducials[f].positionMM[2] = source.positionMM.z;
+    frame.fiducials[f].probability = source.probability;
+  }
+}
@@ -0,0 +1,187 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <iostream>
+#include <chrono>
+
+#include "CameraConnectionManager.h"
+
+using namespace std;
+
+CameraConnectionManager::CameraConnectionManager(navAPI* api):
+  mAPI(api),
+  mState(Disconnected),
+  mRetryPeriod(1000),
+  mDeviceLostTimeout(2000),
+  mConnectionRequested(false),
+  mRequest(NoRequest)
+{
+}
+
+CameraConnectionManager::~CameraConnectionManager()
+{
+  // the only blocking call: the camera is closed before navAPI is destroyed
+  if (isRunning())
+  {
+    PostRequest(QuitRequest,std::vector<navAPI::MarkerId>());
+    wait();
+  }
+}
+
+const char* CameraConnectionManager::GetStateName(State state)
+{
+  switch (state)
+  {
+  case Disconnected:      return "Disconnected";
+  case Detecting:         return "Detecting camera";
+  case Connecting:        return "Connecting camera";
+  case Configuring:       return "Loading geometries";
+  case Streaming:         return "Streaming";
+  case WaitingForCamera:  return "Waiting for camera";
+  default:                return "Unknown";
+  }
+}
+
+void CameraConnectionManager::Connect(const std::vector<navAPI::MarkerId>& geometries)
+{
+  PostRequest(ConnectRequest,geometries);
+
+  // the thread is started on the first request and then waits for the next ones
+  if (!isRunning())
+    start();
+}
+
+void CameraConnectionManager::Disconnect()
+{
+  PostRequest(DisconnectRequest,std::vector<navAPI::MarkerId>());
+}
+
+void CameraConnectionManager::PostRequest(Request request, const std::vector<navAPI::MarkerId>& geometries)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mRequest == QuitRequest)
+      return;
+
+    mRequest = request;
+    mRequestedGeometries = geometries;
+    mConnectionRequested = (request == ConnectRequest);
+  }
+  mWakeUp.notify_all();
+}
+
+bool CameraConnectionManager::Sleep(unsigned int ms)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  mWakeUp.wait_for(lock, std::chrono::milliseconds(ms), [this]{return mRequest != NoRequest;});
+  return mRequest == NoRequest;
+}
+
+void CameraConnectionManager::SetState(State state)
+{
+  if (mState == state)
+    return;
+
+  mState = state;
+
+  // retries are not logged, they happen every second while the camera is unplugged
+  if ((state != Detecting) && (state != WaitingForCamera))
+    cout << "Camera connection: " << GetStateName(state) << std::endl;
+  emit StateChanged(state);
+}
+
+void CameraConnectionManager::run()
+{
+  for (;;)
+  {
+    Request request;
+    std::vector<navAPI::MarkerId> geometries;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mWakeUp.wait(lock, [this]{return mRequest != NoRequest;});
+      request = mRequest;
+      geometries.swap(mRequestedGeometries);
+      if (request != QuitRequest)
+        mRequest = NoRequest;
+    }
+
+    // a disconnection has nothing left to do: every connection closes the camera when it ends
+    if (request == ConnectRequest)
+      RunConnection(geometries);
+    else if (request == QuitRequest)
+      break;
+  }
+}
+
+void CameraConnectionManager::RunConnection(const std::vector<navAPI::MarkerId>& geometries)
+{
+  bool connected = true;
+  while (connected)
+  {
+    SetState(Detecting);
+    bool ready = mAPI->DetectCamera();
+
+    if (ready)
+    {
+      SetState(Connecting);
+      ready = mAPI->InitializeCamera();
+    }
+
+    if (!ready)
+    {
+      // release the driver before the next attempt
+      mAPI->CloseCamera();
+      SetState(WaitingForCamera);
+      connected = Sleep(mRetryPeriod);
+      continue;
+    }
+
+    SetState(Configuring);
+    for (navAPI::MarkerId geometry : geometries)
+      if (!mAPI->AddGeometry(geometry))
+        cerr << "Cannot load geometry " << geometry << std::endl;
+
+    mAPI->start();
+    SetState(Streaming);
+
+    // supervise the acquisition thread until another request arrives
+    unsigned int deviceErrorTime = 0;
+    bool deviceLost = false;
+    while (Sleep(SUPERVISION_PERIOD))
+    {
+      // end of a recorded session or unrecoverable error: nothing to reconnect
+      if (!mAPI->isRunning())
+      {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mRequest == NoRequest)
+          mConnectionRequested = false;
+        break;
+      }
+
+      deviceErrorTime = mAPI->HasDeviceError() ? deviceErrorTime + SUPERVISION_PERIOD : 0;
+      if (deviceErrorTime >= mDeviceLostTimeout)
+      {
+        deviceLost = true;
+        break;
+      }
+    }
+
+    if (!deviceLost)
+      break;
+
+    cerr << "Camera connection lost, reconnecting" << std::endl;
+    mAPI->CloseCamera();
+    SetState(WaitingForCamera);
+    connected = Sleep(mRetryPeriod);
+  }
+
+  if (mAPI->CloseCamera())
+    cout << "Camera closed succesfully" << std::endl;
+
+  SetState(Disconnected);
+}
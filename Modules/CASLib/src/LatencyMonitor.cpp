@@ -0,0 +1,173 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#include "LatencyMonitor.h"
+
+using namespace std;
+
+LatencyMonitor::LatencyMonitor(std::size_t window) :
+  mWindowSize(std::max<std::size_t>(window,1))
+{
+  for (Window& stage : mStages)
+    stage.samples.resize(mWindowSize);
+  mScratch.reserve(mWindowSize);
+  Reset();
+}
+
+uint64_t LatencyMonitor::Now()
+{
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+const char* LatencyMonitor::GetStageName(Stage stage)
+{
+  switch (stage)
+  {
+  case CaptureToPublish:      return "Capture -> publish";
+  case PublishToDelivery:     return "Publish -> delivery";
+  case DeliveryToSceneUpdate: return "Delivery -> scene update";
+  case SceneUpdateToRender:   return "Scene update -> render";
+  case PublishToRender:       return "Publish -> render";
+  default:                    return "Unknown";
+  }
+}
+
+void LatencyMonitor::Reset()
+{
+  for (Window& stage : mStages)
+  {
+    stage.next = 0;
+    stage.count = 0;
+  }
+}
+
+void LatencyMonitor::AddSample(Stage stage, double us)
+{
+  Window& window = mStages[stage];
+  window.samples[window.next] = us;
+  window.next = (window.next + 1) % mWindowSize;
+  window.count = std::min(window.count + 1, mWindowSize);
+}
+
+void LatencyMonitor::AddCaptureSample(uint64_t deviceTimestamp, uint64_t publishTime)
+{
+  // no device timestamp
+  if (deviceTimestamp == 0)
+    return;
+
+  // clock offset plus latency, the offset is removed in GetStatistics
+  AddSample(CaptureToPublish, static_cast<double>(static_cast<int64_t>(publishTime - deviceTimestamp)));
+}
+
+LatencyMonitor::Statistics LatencyMonitor::GetStatistics(Stage stage) const
+{
+  const Window& window = mStages[stage];
+
+  Statistics statistics = {window.count, 0.0, 0.0, 0.0, 0.0};
+  if (window.count == 0)
+    return statistics;
+
+  mScratch.assign(window.samples.begin(), window.samples.begin() + window.count);
+
+  if (stage == CaptureToPublish)
+  {
+    const double offset = *std::min_element(mScratch.begin(),mScratch.end());
+    for (double& sample : mScratch)
+      sample -= offset;
+  }
+
+  // the percentiles are taken in increasing order, so every nth_element only partitions the upper part
+  const double percentiles[3] = {0.50, 0.95, 0.99};
+  double* results[3] = {&statistics.p50, &statistics.p95, &statistics.p99};
+  std::vector<double>::iterator begin = mScratch.begin();
+  for (unsigned int i=0; i<3; i++)
+  {
+    std::vector<double>::iterator nth = mScratch.begin() + static_cast<std::ptrdiff_t>(std::ceil(percentiles[i]*window.count) - 1);
+    std::nth_element(begin, nth, mScratch.end());
+    *results[i] = *nth;
+    begin = nth;
+  }
+  statistics.maximum = *std::max_element(begin,mScratch.end());
+
+  return statistics;
+}
+
+std::string LatencyMonitor::ToText() const
+{
+  std::ostringstream text;
+  text.setf(ios::fixed, ios::floatfield);
+  text.precision(1);
+
+  text << "stage: p50 / p95 / p99 ms";
+  for (unsigned int s=0; s<NumberOfStages; s++)
+  {
+    const Statistics statistics = GetStatistics(static_cast<Stage>(s));
+    text << "\n" << GetStageName(static_cast<Stage>(s)) << ": ";
+    if (statistics.count == 0)
+      text << "-";
+    else
+      text << statistics.p50/1000.0 << " / " << statistics.p95/1000.0 << " / " << statistics.p99/1000.0;
+  }
+  return text.str();
+}
+
+std::string LatencyMonitor::ToJSON() const
+{
+  std::ostringstream json;
+  json << "{\n  \"unit\": \"us\",\n  \"window\": " << mWindowSize << ",\n  \"stages\": [";
+  for (unsigned int s=0; s<NumberOfStages; s++)
+  {
+    const Statistics statistics = GetStatistics(static_cast<Stage>(s));
+    json << ((s == 0) ? "\n" : ",\n")
+         << "    {\"stage\": \"" << GetStageName(static_cast<Stage>(s)) << "\", \"count\": " << statistics.count
+         << ", \"p50\": " << statistics.p50 << ", \"p95\": " << statistics.p95
+         << ", \"p99\": " << statistics.p99 << ", \"max\": " << statistics.maximum << "}";
+  }
+  json << "\n  ]\n}\n";
+  return json.str();
+}
+
+bool LatencyMonitor::ExportCSV(const std::string& fileName) const
+{
+  std::ofstream file(fileName);
+  if (!file.is_open())
+  {
+    cerr << "Cannot write latency statistics to " << fileName << std::endl;
+    return false;
+  }
+
+  file << "stage;count;p50_us;p95_us;p99_us;max_us" << std::endl;
+  for (unsigned int s=0; s<NumberOfStages; s++)
+  {
+    const Statistics statistics = GetStatistics(static_cast<Stage>(s));
+    file << GetStageName(static_cast<Stage>(s)) << ";" << statistics.count << ";" << statistics.p50 << ";"
+         << statistics.p95 << ";" << statistics.p99 << ";" << statistics.maximum << std::endl;
+  }
+  return file.good();
+}
+
+bool LatencyMonitor::ExportJSON(const std::string& fileName) const
+{
+  std::ofstream file(fileName);
+  if (!file.is_open())
+  {
+    cerr << "Cannot write latency statistics to " << fileName << std::endl;
+    return false;
+  }
+
+  file << ToJSON();
+  return file.good();
+}
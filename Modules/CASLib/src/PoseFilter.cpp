@@ -0,0 +1,237 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <cmath>
+
+#include "PoseFilter.h"
+
+const double PoseFilter::MAXIMUM_GAP = 0.5;
+
+static const double PI = 3.14159265358979323846;
+
+// ** quaternions ** //
+
+/// Rotation from a to b, in the frame of a: log(a^-1 * b)
+static inline void Difference(const Quaternion& a, const Quaternion& b, double v[3])
+{
+  (a.Conjugate()*b).GetRotationVector(v);
+}
+
+/// q = q * exp(v)
+static inline void Rotate(Quaternion& q, const double v[3])
+{
+  q = (q*Quaternion::FromRotationVector(v)).Normalized();
+}
+
+// ** one euro ** //
+
+static inline double Alpha(double cutoff, double dt)
+{
+  const double tau = 1.0 / (2.0*PI*cutoff);
+  return 1.0 / (1.0 + tau/dt);
+}
+
+static inline double Norm(const double v[3])
+{
+  return std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+}
+
+// ** kalman (constant velocity, one axis) ** //
+
+/*  Prediction of the covariance of (value, velocity) for a white noise acceleration*/
+static void PredictCovariance(double P[2][2], double dt, double acceleration)
+{
+  const double q = acceleration*acceleration;
+  const double p00 = P[0][0] + dt*(P[1][0] + P[0][1]) + dt*dt*P[1][1] + q*dt*dt*dt/3.0;
+  const double p01 = P[0][1] + dt*P[1][1] + q*dt*dt/2.0;
+  const double p11 = P[1][1] + q*dt;
+  P[0][0] = p00;
+  P[0][1] = P[1][0] = p01;
+  P[1][1] = p11;
+}
+
+/*  Measurement update with the innovation (measured - predicted value).
+    Returns the corrections of value and velocity.*/
+static void Correct(double P[2][2], double innovation, double noise, double& valueCorrection, double& velocityCorrection)
+{
+  const double s = P[0][0] + noise*noise;
+  const double k0 = P[0][0] / s;
+  const double k1 = P[1][0] / s;
+
+  valueCorrection = k0*innovation;
+  velocityCorrection = k1*innovation;
+
+  const double p00 = (1.0-k0)*P[0][0];
+  const double p01 = (1.0-k0)*P[0][1];
+  const double p11 = P[1][1] - k1*P[0][1];
+  P[0][0] = p00;
+  P[0][1] = P[1][0] = p01;
+  P[1][1] = p11;
+}
+
+// ** filter ** //
+
+PoseFilter::PoseFilter() :
+  mType(NoFilter),
+  mMinCutoff(1.0),
+  mBeta(0.05),
+  mRotationBeta(0.5),
+  mDerivativeCutoff(1.0),
+  mPositionNoise(0.1),
+  mOrientationNoise(0.002),
+  mAcceleration(100.0),
+  mAngularAcceleration(2.0),
+  mPredictionHorizon(0.0),
+  mInitialized(false),
+  mLastTime(0.0)
+{
+}
+
+void PoseFilter::SetType(FilterType type)
+{
+  if (type != mType)
+    Reset();
+  mType = type;
+}
+
+void PoseFilter::SetOneEuroParameters(double minCutoff, double beta, double rotationBeta, double derivativeCutoff)
+{
+  mMinCutoff = minCutoff;
+  mBeta = beta;
+  mRotationBeta = rotationBeta;
+  mDerivativeCutoff = derivativeCutoff;
+}
+
+void PoseFilter::SetKalmanParameters(double positionNoise, double orientationNoise, double acceleration, double angularAcceleration)
+{
+  mPositionNoise = positionNoise;
+  mOrientationNoise = orientationNoise;
+  mAcceleration = acceleration;
+  mAngularAcceleration = angularAcceleration;
+}
+
+void PoseFilter::Update(const double pose[3][4], double time, double filtered[3][4])
+{
+  if (mType == NoFilter)
+  {
+    for (unsigned int i=0; i<3; i++)
+      for (unsigned int j=0; j<4; j++)
+        filtered[i][j] = pose[i][j];
+    return;
+  }
+
+  const double position[3] = {pose[0][3], pose[1][3], pose[2][3]};
+  const Quaternion orientation = Quaternion::FromMatrix(pose).Normalized();
+
+  const double dt = time - mLastTime;
+  if (!mInitialized || (dt < 0.0) || (dt > MAXIMUM_GAP))
+  {
+    for (unsigned int i=0; i<3; i++)
+    {
+      mPosition[i] = position[i];
+      mVelocity[i] = 0.0;
+      mAngularVelocity[i] = 0.0;
+
+      mTranslationCovariance[i][0][0] = mPositionNoise*mPositionNoise;
+      mRotationCovariance[i][0][0] = mOrientationNoise*mOrientationNoise;
+      mTranslationCovariance[i][0][1] = mTranslationCovariance[i][1][0] = 0.0;
+      mRotationCovariance[i][0][1] = mRotationCovariance[i][1][0] = 0.0;
+
+      // velocity unknown: large variance
+      mTranslationCovariance[i][1][1] = 1e6;
+      mRotationCovariance[i][1][1] = 1e2;
+    }
+    mOrientation = orientation;
+
+    mInitialized = true;
+  }
+  else if (dt > 0.0)
+  {
+    if (mType == OneEuro)
+      UpdateOneEuro(position,orientation,dt);
+    else
+      UpdateKalman(position,orientation,dt);
+  }
+  mLastTime = time;
+
+  // extrapolate to the display time
+  Quaternion predictedOrientation = mOrientation;
+  double predictedPosition[3] = {mPosition[0], mPosition[1], mPosition[2]};
+  if (mPredictionHorizon > 0.0)
+  {
+    const double rotation[3] = {mAngularVelocity[0]*mPredictionHorizon, mAngularVelocity[1]*mPredictionHorizon, mAngularVelocity[2]*mPredictionHorizon};
+    Rotate(predictedOrientation,rotation);
+    for (unsigned int i=0; i<3; i++)
+      predictedPosition[i] += mVelocity[i]*mPredictionHorizon;
+  }
+
+  predictedOrientation.GetMatrix(filtered);
+  for (unsigned int i=0; i<3; i++)
+    filtered[i][3] = predictedPosition[i];
+}
+
+void PoseFilter::UpdateOneEuro(const double position[3], const Quaternion& orientation, double dt)
+{
+  const double derivativeAlpha = Alpha(mDerivativeCutoff,dt);
+
+  // translation: the cutoff grows with the filtered speed
+  double step[3];
+  for (unsigned int i=0; i<3; i++)
+  {
+    step[i] = position[i] - mPosition[i];
+    mVelocity[i] += derivativeAlpha*(step[i]/dt - mVelocity[i]);
+  }
+
+  const double alpha = Alpha(mMinCutoff + mBeta*Norm(mVelocity), dt);
+  for (unsigned int i=0; i<3; i++)
+    mPosition[i] += alpha*step[i];
+
+  // rotation: same filter on the rotation from the filtered to the measured orientation
+  double rotation[3];
+  Difference(mOrientation,orientation,rotation);
+  for (unsigned int i=0; i<3; i++)
+    mAngularVelocity[i] += derivativeAlpha*(rotation[i]/dt - mAngularVelocity[i]);
+
+  const double rotationAlpha = Alpha(mMinCutoff + mRotationBeta*Norm(mAngularVelocity), dt);
+  for (unsigned int i=0; i<3; i++)
+    rotation[i] *= rotationAlpha;
+  Rotate(mOrientation,rotation);
+}
+
+void PoseFilter::UpdateKalman(const double position[3], const Quaternion& orientation, double dt)
+{
+  double valueCorrection, velocityCorrection;
+
+  // translation
+  for (unsigned int i=0; i<3; i++)
+  {
+    mPosition[i] += mVelocity[i]*dt;
+    PredictCovariance(mTranslationCovariance[i],dt,mAcceleration);
+
+    Correct(mTranslationCovariance[i], position[i]-mPosition[i], mPositionNoise, valueCorrection, velocityCorrection);
+    mPosition[i] += valueCorrection;
+    mVelocity[i] += velocityCorrection;
+  }
+
+  // rotation: predict the orientation, then filter the error angle around it
+  const double predicted[3] = {mAngularVelocity[0]*dt, mAngularVelocity[1]*dt, mAngularVelocity[2]*dt};
+  Rotate(mOrientation,predicted);
+
+  double innovation[3];
+  Difference(mOrientation,orientation,innovation);
+
+  double correction[3];
+  for (unsigned int i=0; i<3; i++)
+  {
+    PredictCovariance(mRotationCovariance[i],dt,mAngularAcceleration);
+
+    Correct(mRotationCovariance[i], innovation[i], mOrientationNoise, correction[i], velocityCorrection);
+    mAngularVelocity[i] += velocityCorrection;
+  }
+  Rotate(mOrientation,correction);
+}
@@ -0,0 +1,305 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <iostream>
+#include <cstdlib>
+#include <thread>
+
+#include "ReplayTrackingSource.h"
+
+using namespace std;
+
+ReplayTrackingSource::ReplayTrackingSource() :
+  mSpeed(1.0),
+  mLoop(false),
+  mHasPendingFrame(false),
+  mFirstTimestamp(0),
+  mClockStarted(false),
+  mReplayedFrames(0)
+{
+}
+
+ReplayTrackingSource::~ReplayTrackingSource()
+{
+  Close();
+}
+
+bool ReplayTrackingSource::Detect()
+{
+  ifstream file(mFileName);
+  return file.good();
+}
+
+bool ReplayTrackingSource::Open()
+{
+  Close();
+
+  if (TrackingLogReader::IsTrackingLog(mFileName))
+  {
+    if (!mLog.Open(mFileName))
+      return false;
+  }
+  else
+    mFile.open(mFileName);
+
+  if (!IsOpen())
+  {
+    cerr << "Cannot open tracking recording '" << mFileName << "'" << std::endl;
+    return false;
+  }
+
+  cout << "Replaying tracking recording '" << mFileName << "' at speed " << mSpeed << std::endl;
+  mGeometries.clear();
+  return true;
+}
+
+bool ReplayTrackingSource::Close()
+{
+  if (!IsOpen())
+    return false;
+
+  mFile.close();
+  mLog.Close();
+  mHasPendingFrame = false;
+  mLookAheadLine.clear();
+  return true;
+}
+
+bool ReplayTrackingSource::AddGeometry(uint32_t geometryId, const std::string&)
+{
+  if (!IsOpen())
+    return false;
+
+  mGeometries.insert(geometryId);
+  return true;
+}
+
+bool ReplayTrackingSource::StartStreaming()
+{
+  mReplayedFrames = 0;
+  mClockStarted = false;
+  return IsOpen();
+}
+
+void ReplayTrackingSource::StopStreaming()
+{
+}
+
+bool ReplayTrackingSource::Rewind()
+{
+  if (mLog.IsOpen())
+  {
+    mHasPendingFrame = false;
+    mClockStarted = false;
+    return mLog.Seek(0);
+  }
+
+  mFile.clear();
+  mFile.seekg(0);
+  mLookAheadLine.clear();
+  mHasPendingFrame = false;
+  mClockStarted = false;
+  return mFile.good();
+}
+
+bool ReplayTrackingSource::SeekToTimestamp(uint64_t timestamp)
+{
+  if (!mLog.IsOpen() || !mLog.SeekToTimestamp(timestamp))
+    return false;
+
+  // restart the playback clock at the new position
+  mHasPendingFrame = false;
+  mClockStarted = false;
+  return true;
+}
+
+TrackingSource::FrameStatus ReplayTrackingSource::WaitForFrame(TrackingFrame& frame, unsigned int timeout)
+{
+  if (!mHasPendingFrame && !ReadNextFrame())
+  {
+    if (!mLoop || !Rewind() || !ReadNextFrame())
+      return EndOfStream;
+  }
+
+  // keep the recorded timing (scaled by the speed)
+  if (mSpeed > 0.0)
+  {
+    const Clock::time_point now = Clock::now();
+    if (!mClockStarted)
+    {
+      mStartTime = now;
+      mFirstTimestamp = mPendingFrame.timestamp;
+      mClockStarted = true;
+    }
+
+    const uint64_t elapsed = (mPendingFrame.timestamp > mFirstTimestamp) ? mPendingFrame.timestamp - mFirstTimestamp : 0;
+    const Clock::time_point due = mStartTime + std::chrono::microseconds(static_cast<long long>(elapsed / mSpeed));
+
+    if (due > now)
+    {
+      // do not block longer than the timeout, so the caller can stop the acquisition
+      if (due - now > std::chrono::milliseconds(timeout))
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(timeout));
+        return Timeout;
+      }
+      std::this_thread::sleep_until(due);
+    }
+  }
+
+  frame = mPendingFrame;
+  mHasPendingFrame = false;
+  mReplayedFrames++;
+  mNumberOfFrames++;
+  return NewFrame;
+}
+
+bool ReplayTrackingSource::ReadNextLogFrame()
+{
+  TrackingFrame& frame = mPendingFrame;
+  if (!mLog.ReadNext(frame))
+    return false;
+
+  // keep the markers of the added geometries
+  if (!mGeometries.empty())
+  {
+    uint32_t kept = 0;
+    for (uint32_t m=0; m<frame.markersCount; m++)
+      if (mGeometries.count(frame.markers[m].geometryId) != 0)
+        frame.markers[kept++] = frame.markers[m];
+    frame.markersCount = kept;
+  }
+
+  mHasPendingFrame = true;
+  return true;
+}
+
+bool ReplayTrackingSource::ReadNextFrame()
+{
+  if (mLog.IsOpen())
+    return ReadNextLogFrame();
+
+  TrackingFrame& frame = mPendingFrame;
+  frame.markersCount = 0;
+  frame.markersOverflow = false;
+  frame.fiducialsValid = false;
+  frame.fiducialsCount = 0;
+
+  bool started = false;
+  uint64_t frameTimestamp = 0;
+  std::string line;
+
+  for (;;)
+  {
+    if (!mLookAheadLine.empty())
+    {
+      line.swap(mLookAheadLine);
+      mLookAheadLine.clear();
+    }
+    else if (!std::getline(mFile,line))
+      break;
+
+    uint64_t timestamp;
+    TrackingMarker marker;
+    bool hasMarker;
+    if (!ParseLine(line,timestamp,marker,hasMarker))
+      continue;
+
+    // first line of the next frame
+    if (started && (timestamp != frameTimestamp))
+    {
+      mLookAheadLine = line;
+      break;
+    }
+
+    started = true;
+    frameTimestamp = timestamp;
+
+    if (!hasMarker || (!mGeometries.empty() && (mGeometries.count(marker.geometryId) == 0)))
+      continue;
+
+    if (frame.markersCount < TRACKING_MAX_MARKERS)
+      frame.markers[frame.markersCount++] = marker;
+    else
+      frame.markersOverflow = true;
+  }
+
+  if (!started)
+    return false;
+
+  frame.timestamp = frameTimestamp;
+  mHasPendingFrame = true;
+  return true;
+}
+
+static const char* SkipSpaces(const char* p)
+{
+  while ((*p == ' ') || (*p == '\t') || (*p == '\r'))
+    ++p;
+  return p;
+}
+
+bool ReplayTrackingSource::ParseLine(const std::string& line, uint64_t& timestamp, TrackingMarker& marker, bool& hasMarker) const
+{
+  const char* p = SkipSpaces(line.c_str());
+  if ((*p == '#') || (*p == '\0'))
+    return false;
+
+  char* end;
+  timestamp = std::strtoull(p,&end,10);
+  if (end == p)
+    return false;
+
+  // frame without markers
+  p = SkipSpaces(end);
+  if ((*p == ';') && (*SkipSpaces(p+1) == '\0'))
+    p = SkipSpaces(p+1);
+  if (*p == '\0')
+  {
+    hasMarker = false;
+    return true;
+  }
+
+  if (*p != ';')
+    return false;
+
+  const char* idStart = p+1;
+  marker.geometryId = static_cast<uint32_t>(std::strtoul(idStart,&end,10));
+  if (end == idStart)
+    return false;
+  p = end;
+
+  // rotation (row major), translation and registration error
+  double values[13];
+  for (unsigned int i=0; i<13; i++)
+  {
+    p = SkipSpaces(p);
+    if (*p != ';')
+      return false;
+
+    const char* valueStart = p+1;
+    values[i] = std::strtod(valueStart,&end);
+    if (end == valueStart)
+      return false;
+    p = end;
+  }
+
+  for (unsigned int i=0; i<3; i++)
+  {
+    for (unsigned int j=0; j<3; j++)
+      marker.rotation[i][j] = values[3*i+j];
+    marker.translationMM[i] = values[9+i];
+  }
+  marker.registrationErrorMM = values[12];
+
+  for (uint32_t f=0; f<TRACKING_MAX_MARKER_FIDUCIALS; f++)
+    marker.fiducialCorresp[f] = TRACKING_INVALID_ID;
+
+  hasMarker = true;
+  return true;
+}
@@ -0,0 +1,671 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <QDateTime>
+
+#include "TrackingLog.h"
+
+using namespace std;
+
+static const char LOG_MAGIC[8] = {'N','A','V','C','A','S','T','L'};
+static const char INDEX_MAGIC[8] = {'N','A','V','C','A','S','I','X'};
+static const uint32_t LOG_VERSION = 1;
+
+static const uint64_t HEADER_SIZE = 64;
+static const uint64_t INDEX_ENTRY_SIZE = 24;
+static const uint64_t TRAILER_SIZE = 40;
+
+// the mapping grows in chunks, so remapping is rare
+static const uint64_t MAP_CHUNK_SIZE = 16*1024*1024;
+
+// record types (unused mapped space reads as 0)
+static const uint8_t RECORD_END = 0;
+static const uint8_t RECORD_KEY_FRAME = 1;
+static const uint8_t RECORD_DELTA_FRAME = 2;
+
+// quantization
+static const double ROTATION_SCALE = 1e7;
+static const double POSITION_SCALE = 1e3;     // um
+static const double ERROR_SCALE = 1e4;
+
+// ** little endian fixed size fields ** //
+
+static void PutU32(uchar* p, uint32_t v)
+{
+  for (unsigned int i=0; i<4; i++)
+    p[i] = static_cast<uchar>(v >> (8*i));
+}
+
+static void PutU64(uchar* p, uint64_t v)
+{
+  for (unsigned int i=0; i<8; i++)
+    p[i] = static_cast<uchar>(v >> (8*i));
+}
+
+static uint32_t GetU32(const uchar* p)
+{
+  uint32_t v = 0;
+  for (unsigned int i=0; i<4; i++)
+    v |= static_cast<uint32_t>(p[i]) << (8*i);
+  return v;
+}
+
+static uint64_t GetU64(const uchar* p)
+{
+  uint64_t v = 0;
+  for (unsigned int i=0; i<8; i++)
+    v |= static_cast<uint64_t>(p[i]) << (8*i);
+  return v;
+}
+
+// ** variable length fields ** //
+
+static void PutVarint(std::vector<uint8_t>& out, uint64_t v)
+{
+  while (v >= 0x80)
+  {
+    out.push_back(static_cast<uint8_t>(v | 0x80));
+    v >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(v));
+}
+
+static void PutSigned(std::vector<uint8_t>& out, int64_t v)
+{
+  PutVarint(out, (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63));
+}
+
+static bool GetVarint(const uchar*& p, const uchar* end, uint64_t& v)
+{
+  v = 0;
+  for (unsigned int shift=0; (shift < 64) && (p < end); shift += 7)
+  {
+    const uchar byte = *p++;
+    v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0)
+      return true;
+  }
+  return false;
+}
+
+static bool GetSigned(const uchar*& p, const uchar* end, int64_t& v)
+{
+  uint64_t u;
+  if (!GetVarint(p,end,u))
+    return false;
+  v = static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+  return true;
+}
+
+static inline int64_t Quantize(double value, double scale)
+{
+  return static_cast<int64_t>(std::llround(value*scale));
+}
+
+static void QuantizeMarker(const TrackingMarker& marker, int64_t q[13])
+{
+  for (unsigned int i=0; i<3; i++)
+  {
+    for (unsigned int j=0; j<3; j++)
+      q[3*i+j] = Quantize(marker.rotation[i][j], ROTATION_SCALE);
+    q[9+i] = Quantize(marker.translationMM[i], POSITION_SCALE);
+  }
+  q[12] = Quantize(marker.registrationErrorMM, ERROR_SCALE);
+}
+
+static void DequantizeMarker(const int64_t q[13], TrackingMarker& marker)
+{
+  for (unsigned int i=0; i<3; i++)
+  {
+    for (unsigned int j=0; j<3; j++)
+      marker.rotation[i][j] = q[3*i+j] / ROTATION_SCALE;
+    marker.translationMM[i] = q[9+i] / POSITION_SCALE;
+  }
+  marker.registrationErrorMM = q[12] / ERROR_SCALE;
+}
+
+/// Marker of the previous frame with the same geometry, or -1
+static int FindPreviousMarker(const TrackingLogState& state, uint32_t geometryId)
+{
+  for (uint32_t m=0; m<state.markersCount; m++)
+    if (state.geometryId[m] == geometryId)
+      return static_cast<int>(m);
+  return -1;
+}
+
+static void EncodeFrame(const TrackingFrame& frame, TrackingLogState& state, TrackingLogState& next, std::vector<uint8_t>& out)
+{
+  static const int64_t zeros[13] = {0};
+
+  PutSigned(out, static_cast<int64_t>(frame.timestamp - state.timestamp));
+  PutVarint(out, (frame.markersOverflow ? 1u : 0u) | (frame.fiducialsValid ? 2u : 0u));
+
+  next.timestamp = frame.timestamp;
+  next.markersCount = std::min<uint32_t>(frame.markersCount, TRACKING_MAX_MARKERS);
+  PutVarint(out, next.markersCount);
+
+  for (uint32_t m=0; m<next.markersCount; m++)
+  {
+    const TrackingMarker& marker = frame.markers[m];
+    const int previous = FindPreviousMarker(state, marker.geometryId);
+    const int64_t* reference = (previous >= 0) ? state.marker[previous] : zeros;
+
+    next.geometryId[m] = marker.geometryId;
+    QuantizeMarker(marker, next.marker[m]);
+
+    PutVarint(out, marker.geometryId);
+    for (unsigned int i=0; i<13; i++)
+      PutSigned(out, next.marker[m][i] - reference[i]);
+
+    // invalid ids are stored as 0
+    for (uint32_t f=0; f<TRACKING_MAX_MARKER_FIDUCIALS; f++)
+      PutVarint(out, static_cast<uint32_t>(marker.fiducialCorresp[f] + 1u));
+  }
+
+  next.fiducialsCount = std::min<uint32_t>(frame.fiducialsCount, TRACKING_MAX_FIDUCIALS);
+  PutVarint(out, next.fiducialsCount);
+
+  for (uint32_t f=0; f<next.fiducialsCount; f++)
+  {
+    const TrackingFiducial& fiducial = frame.fiducials[f];
+    int64_t* q = next.fiducial[f];
+    for (unsigned int i=0; i<3; i++)
+      q[i] = Quantize(fiducial.positionMM[i], POSITION_SCALE);
+    q[3] = Quantize(fiducial.probability, ERROR_SCALE);
+
+    for (unsigned int i=0; i<4; i++)
+      PutSigned(out, q[i] - ((f < state.fiducialsCount) ? state.fiducial[f][i] : 0));
+  }
+
+  state = next;
+}
+
+static bool DecodeFrame(const uchar* p, const uchar* end, TrackingLogState& state, TrackingLogState& next, TrackingFrame& frame)
+{
+  static const int64_t zeros[13] = {0};
+
+  int64_t delta;
+  uint64_t value;
+
+  if (!GetSigned(p,end,delta))
+    return false;
+  next.timestamp = state.timestamp + static_cast<uint64_t>(delta);
+
+  if (!GetVarint(p,end,value))
+    return false;
+  frame.markersOverflow = (value & 1u) != 0;
+  frame.fiducialsValid = (value & 2u) != 0;
+
+  if (!GetVarint(p,end,value) || (value > TRACKING_MAX_MARKERS))
+    return false;
+  next.markersCount = static_cast<uint32_t>(value);
+
+  for (uint32_t m=0; m<next.markersCount; m++)
+  {
+    TrackingMarker& marker = frame.markers[m];
+    if (!GetVarint(p,end,value))
+      return false;
+    marker.geometryId = static_cast<uint32_t>(value);
+
+    const int previous = FindPreviousMarker(state, marker.geometryId);
+    const int64_t* reference = (previous >= 0) ? state.marker[previous] : zeros;
+
+    next.geometryId[m] = marker.geometryId;
+    for (unsigned int i=0; i<13; i++)
+    {
+      if (!GetSigned(p,end,delta))
+        return false;
+      next.marker[m][i] = reference[i] + delta;
+    }
+    DequantizeMarker(next.marker[m], marker);
+
+    for (uint32_t f=0; f<TRACKING_MAX_MARKER_FIDUCIALS; f++)
+    {
+      if (!GetVarint(p,end,value))
+        return false;
+      marker.fiducialCorresp[f] = static_cast<uint32_t>(value) - 1u;
+    }
+  }
+
+  if (!GetVarint(p,end,value) || (value > TRACKING_MAX_FIDUCIALS))
+    return false;
+  next.fiducialsCount = static_cast<uint32_t>(value);
+
+  for (uint32_t f=0; f<next.fiducialsCount; f++)
+  {
+    int64_t* q = next.fiducial[f];
+    for (unsigned int i=0; i<4; i++)
+    {
+      if (!GetSigned(p,end,delta))
+        return false;
+      q[i] = ((f < state.fiducialsCount) ? state.fiducial[f][i] : 0) + delta;
+    }
+
+    TrackingFiducial& fiducial = frame.fiducials[f];
+    for (unsigned int i=0; i<3; i++)
+      fiducial.positionMM[i] = q[i] / POSITION_SCALE;
+    fiducial.probability = q[3] / ERROR_SCALE;
+  }
+
+  frame.timestamp = next.timestamp;
+  frame.markersCount = next.markersCount;
+  frame.fiducialsCount = next.fiducialsCount;
+  state = next;
+  return true;
+}
+
+// ** writer ** //
+
+TrackingLogWriter::TrackingLogWriter() :
+  mMap(nullptr),
+  mMapSize(0),
+  mOffset(0),
+  mKeyFrameInterval(128),
+  mNumberOfFrames(0)
+{
+  mState.Reset();
+}
+
+TrackingLogWriter::~TrackingLogWriter()
+{
+  Close();
+}
+
+bool TrackingLogWriter::Open(const std::string& fileName, uint32_t keyFrameInterval)
+{
+  Close();
+
+  mFile.setFileName(QString::fromStdString(fileName));
+  if (!mFile.open(QIODevice::ReadWrite | QIODevice::Truncate))
+  {
+    cerr << "Cannot create tracking log '" << fileName << "'" << std::endl;
+    return false;
+  }
+
+  mMapSize = 0;
+  mOffset = 0;
+  if (!Reserve(HEADER_SIZE))
+  {
+    mFile.close();
+    return false;
+  }
+
+  uchar header[HEADER_SIZE] = {0};
+  memcpy(header, LOG_MAGIC, 8);
+  PutU32(header+8, LOG_VERSION);
+  PutU32(header+12, std::max(keyFrameInterval,1u));
+  PutU64(header+16, static_cast<uint64_t>(QDateTime::currentMSecsSinceEpoch()));
+  Append(header, HEADER_SIZE);
+
+  mKeyFrameInterval = std::max(keyFrameInterval,1u);
+  mNumberOfFrames = 0;
+  mState.Reset();
+  mIndex.clear();
+  mPayload.reserve(8*1024);
+  return true;
+}
+
+bool TrackingLogWriter::Reserve(uint64_t bytes)
+{
+  const uint64_t required = mOffset + bytes;
+  if (required <= mMapSize)
+    return true;
+
+  const uint64_t size = ((required + MAP_CHUNK_SIZE - 1) / MAP_CHUNK_SIZE) * MAP_CHUNK_SIZE;
+
+  if (mMap != nullptr)
+    mFile.unmap(mMap);
+  mMap = nullptr;
+
+  if (!mFile.resize(static_cast<qint64>(size)))
+  {
+    cerr << "Cannot grow tracking log '" << mFile.fileName().toStdString() << "'" << std::endl;
+    return false;
+  }
+
+  mMap = mFile.map(0, static_cast<qint64>(size));
+  if (mMap == nullptr)
+  {
+    cerr << "Cannot map tracking log '" << mFile.fileName().toStdString() << "'" << std::endl;
+    return false;
+  }
+
+  mMapSize = size;
+  return true;
+}
+
+void TrackingLogWriter::Append(const void* data, uint64_t bytes)
+{
+  memcpy(mMap + mOffset, data, bytes);
+  mOffset += bytes;
+}
+
+bool TrackingLogWriter::Write(const TrackingFrame& frame)
+{
+  if (!IsOpen())
+    return false;
+
+  const bool keyFrame = (mNumberOfFrames % mKeyFrameInterval) == 0;
+  if (keyFrame)
+    mState.Reset();
+
+  mPayload.clear();
+  TrackingLogState next;
+  EncodeFrame(frame, mState, next, mPayload);
+
+  // type + size (varint) + payload
+  if (!Reserve(1 + 10 + mPayload.size()))
+    return false;
+
+  if (keyFrame)
+    mIndex.push_back({mNumberOfFrames, frame.timestamp, mOffset});
+
+  std::vector<uint8_t>::size_type payloadSize = mPayload.size();
+  mPayload.push_back(keyFrame ? RECORD_KEY_FRAME : RECORD_DELTA_FRAME);
+  PutVarint(mPayload, payloadSize);
+  Append(mPayload.data() + payloadSize, mPayload.size() - payloadSize);
+  Append(mPayload.data(), payloadSize);
+
+  mNumberOfFrames++;
+  return true;
+}
+
+bool TrackingLogWriter::Close()
+{
+  if (!IsOpen())
+  {
+    if (mFile.isOpen())
+      mFile.close();
+    return false;
+  }
+
+  bool ok = Reserve(mIndex.size()*INDEX_ENTRY_SIZE + TRAILER_SIZE);
+  if (ok)
+  {
+    const uint64_t indexOffset = mOffset;
+    uchar entry[INDEX_ENTRY_SIZE];
+    for (const TrackingLogIndexEntry& e : mIndex)
+    {
+      PutU64(entry, e.frameNumber);
+      PutU64(entry+8, e.timestamp);
+      PutU64(entry+16, e.offset);
+      Append(entry, INDEX_ENTRY_SIZE);
+    }
+
+    uchar trailer[TRAILER_SIZE];
+    PutU64(trailer, indexOffset);
+    PutU64(trailer+8, mNumberOfFrames);
+    PutU64(trailer+16, mIndex.size());
+    PutU64(trailer+24, mState.timestamp);
+    memcpy(trailer+32, INDEX_MAGIC, 8);
+    Append(trailer, TRAILER_SIZE);
+  }
+
+  if (mMap != nullptr)
+    mFile.unmap(mMap);
+  mMap = nullptr;
+  mMapSize = 0;
+
+  // drop the unused part of the last chunk
+  ok = mFile.resize(static_cast<qint64>(mOffset)) && ok;
+  mFile.close();
+  return ok;
+}
+
+// ** reader ** //
+
+TrackingLogReader::TrackingLogReader() :
+  mData(nullptr),
+  mRecordsEnd(0),
+  mStartTime(0),
+  mNumberOfFrames(0),
+  mFirstTimestamp(0),
+  mLastTimestamp(0),
+  mPosition(0),
+  mNextFrame(0)
+{
+  mState.Reset();
+}
+
+TrackingLogReader::~TrackingLogReader()
+{
+  Close();
+}
+
+bool TrackingLogReader::IsTrackingLog(const std::string& fileName)
+{
+  QFile file(QString::fromStdString(fileName));
+  if (!file.open(QIODevice::ReadOnly))
+    return false;
+
+  char magic[8];
+  return (file.read(magic,8) == 8) && (memcmp(magic, LOG_MAGIC, 8) == 0);
+}
+
+bool TrackingLogReader::Open(const std::string& fileName)
+{
+  Close();
+
+  mFile.setFileName(QString::fromStdString(fileName));
+  if (!mFile.open(QIODevice::ReadOnly))
+  {
+    cerr << "Cannot open tracking log '" << fileName << "'" << std::endl;
+    return false;
+  }
+
+  const uint64_t size = static_cast<uint64_t>(mFile.size());
+  if (size >= HEADER_SIZE)
+    mData = mFile.map(0, static_cast<qint64>(size));
+
+  if ((mData == nullptr) || (memcmp(mData, LOG_MAGIC, 8) != 0) || (GetU32(mData+8) != LOG_VERSION))
+  {
+    cerr << "'" << fileName << "' is not a valid tracking log" << std::endl;
+    Close();
+    return false;
+  }
+
+  mStartTime = GetU64(mData+16);
+
+  // closed log: read the index
+  const uchar* trailer = mData + size - TRAILER_SIZE;
+  bool indexed = (size >= HEADER_SIZE + TRAILER_SIZE) && (memcmp(trailer+32, INDEX_MAGIC, 8) == 0);
+  if (indexed)
+  {
+    const uint64_t indexOffset = GetU64(trailer);
+    const uint64_t indexCount = GetU64(trailer+16);
+    indexed = (indexOffset >= HEADER_SIZE) && (indexCount <= (size - TRAILER_SIZE - indexOffset) / INDEX_ENTRY_SIZE);
+
+    if (indexed)
+    {
+      mRecordsEnd = indexOffset;
+      mNumberOfFrames = GetU64(trailer+8);
+      mLastTimestamp = GetU64(trailer+24);
+
+      mIndex.resize(indexCount);
+      for (uint64_t i=0; i<indexCount; i++)
+      {
+        const uchar* entry = mData + indexOffset + i*INDEX_ENTRY_SIZE;
+        mIndex[i].frameNumber = GetU64(entry);
+        mIndex[i].timestamp = GetU64(entry+8);
+        mIndex[i].offset = GetU64(entry+16);
+      }
+    }
+  }
+
+  // log of an interrupted session
+  if (!indexed)
+  {
+    cout << "Tracking log '" << fileName << "' was not closed, rebuilding its index" << std::endl;
+    mRecordsEnd = size;
+    if (!BuildIndex())
+    {
+      Close();
+      return false;
+    }
+  }
+
+  mFirstTimestamp = mIndex.empty() ? 0 : mIndex.front().timestamp;
+  return Seek(0);
+}
+
+void TrackingLogReader::Close()
+{
+  if (mData != nullptr)
+    mFile.unmap(const_cast<uchar*>(mData));
+  mData = nullptr;
+
+  if (mFile.isOpen())
+    mFile.close();
+
+  mIndex.clear();
+  mRecordsEnd = 0;
+  mNumberOfFrames = 0;
+  mFirstTimestamp = 0;
+  mLastTimestamp = 0;
+  mPosition = 0;
+  mNextFrame = 0;
+}
+
+bool TrackingLogReader::BuildIndex()
+{
+  mIndex.clear();
+  mNumberOfFrames = 0;
+  mLastTimestamp = 0;
+  mPosition = HEADER_SIZE;
+  mState.Reset();
+
+  for (;;)
+  {
+    const uint64_t offset = mPosition;
+    bool keyFrame;
+    if (!DecodeNext(mScratch,&keyFrame))
+    {
+      // the rest of the file is unused (or was not completely written)
+      mRecordsEnd = offset;
+      break;
+    }
+
+    if (keyFrame)
+      mIndex.push_back({mNumberOfFrames, mScratch.timestamp, offset});
+    else if (mIndex.empty())
+      return false;
+
+    mLastTimestamp = mScratch.timestamp;
+    mNumberOfFrames++;
+  }
+
+  return true;
+}
+
+bool TrackingLogReader::DecodeNext(TrackingFrame& frame, bool* keyFrame)
+{
+  if (mPosition >= mRecordsEnd)
+    return false;
+
+  const uchar* p = mData + mPosition;
+  const uchar* end = mData + mRecordsEnd;
+
+  const uint8_t type = *p++;
+  if ((type != RECORD_KEY_FRAME) && (type != RECORD_DELTA_FRAME))
+    return false;
+
+  uint64_t payloadSize;
+  if (!GetVarint(p,end,payloadSize) || (payloadSize > static_cast<uint64_t>(end - p)))
+    return false;
+
+  if (type == RECORD_KEY_FRAME)
+    mState.Reset();
+
+  TrackingLogState next;
+  if (!DecodeFrame(p, p + payloadSize, mState, next, frame))
+    return false;
+
+  if (keyFrame != nullptr)
+    *keyFrame = (type == RECORD_KEY_FRAME);
+
+  mPosition = static_cast<uint64_t>(p + payloadSize - mData);
+  return true;
+}
+
+bool TrackingLogReader::ReadNext(TrackingFrame& frame)
+{
+  if (!IsOpen() || (mNextFrame >= mNumberOfFrames))
+    return false;
+
+  if (!DecodeNext(frame))
+    return false;
+
+  mNextFrame++;
+  return true;
+}
+
+bool TrackingLogReader::Seek(uint64_t frameNumber)
+{
+  if (!IsOpen() || (frameNumber > mNumberOfFrames))
+    return false;
+
+  mState.Reset();
+  if (mIndex.empty())
+  {
+    mPosition = HEADER_SIZE;
+    mNextFrame = 0;
+    return true;
+  }
+
+  // last key frame before the requested one
+  std::vector<TrackingLogIndexEntry>::const_iterator key = std::upper_bound(mIndex.begin(), mIndex.end(), frameNumber,
+      [](uint64_t n, const TrackingLogIndexEntry& e){return n < e.frameNumber;});
+  if (key != mIndex.begin())
+    --key;
+
+  mPosition = key->offset;
+  mNextFrame = key->frameNumber;
+
+  while (mNextFrame < frameNumber)
+    if (!ReadNext(mScratch))
+      return false;
+
+  return true;
+}
+
+bool TrackingLogReader::SeekToTimestamp(uint64_t timestamp)
+{
+  if (!IsOpen())
+    return false;
+
+  std::vector<TrackingLogIndexEntry>::const_iterator key = std::upper_bound(mIndex.begin(), mIndex.end(), timestamp,
+      [](uint64_t t, const TrackingLogIndexEntry& e){return t < e.timestamp;});
+  if (key != mIndex.begin())
+    --key;
+
+  if (!Seek((key != mIndex.end()) ? key->frameNumber : 0))
+    return false;
+
+  // decode until the requested time, then step back one frame
+  for (;;)
+  {
+    const uint64_t position = mPosition;
+    const TrackingLogState state = mState;
+
+    if (!ReadNext(mScratch))
+      return true;    // past the end
+
+    if (mScratch.timestamp >= timestamp)
+    {
+      mPosition = position;
+      mState = state;
+      mNextFrame--;
+      return true;
+    }
+  }
+}
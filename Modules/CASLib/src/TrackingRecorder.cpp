@@ -0,0 +1,85 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <iostream>
+
+#include "TrackingRecorder.h"
+
+using namespace std;
+
+TrackingRecorder::TrackingRecorder() :
+  mRecording(false),
+  mRecordedFrames(0),
+  mDroppedFrames(0)
+{
+}
+
+TrackingRecorder::~TrackingRecorder()
+{
+  Stop();
+}
+
+bool TrackingRecorder::Start(const std::string& fileName)
+{
+  Stop();
+
+  if (!mWriter.Open(fileName))
+    return false;
+
+  mFileName = fileName;
+  mRecordedFrames = 0;
+  mDroppedFrames = 0;
+
+  // discard frames queued by a previous recording
+  mQueue.Clear();
+
+  mRecording = true;
+  QThread::start(QThread::LowPriority);
+
+  cout << "Recording tracking session to '" << fileName << "'" << std::endl;
+  return true;
+}
+
+void TrackingRecorder::Stop()
+{
+  if (!mRecording && !isRunning())
+    return;
+
+  // the thread writes the queued frames before finishing
+  mRecording = false;
+  wait();
+
+  mWriter.Close();
+  cout << "Tracking session recorded: " << mRecordedFrames << " frames, " << mDroppedFrames << " dropped" << std::endl;
+}
+
+void TrackingRecorder::run()
+{
+  const uint64_t initiallyDropped = mQueue.GetNumberOfDroppedRecords();
+  uint64_t writeErrors = 0;
+
+  for (;;)
+  {
+    // read the flag before draining, so frames pushed before Stop are not lost
+    const bool recording = mRecording;
+
+    while (mQueue.Pop(mFrame))
+    {
+      if (mWriter.Write(mFrame))
+        mRecordedFrames++;
+      else
+        writeErrors++;
+    }
+    mDroppedFrames = mQueue.GetNumberOfDroppedRecords() - initiallyDropped + writeErrors;
+
+    if (!recording)
+      break;
+
+    msleep(2);
+  }
+}
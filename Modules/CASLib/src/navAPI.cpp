@@ -6,189 +6,106 @@ navCAS navigation system
 
 ===================================================================*/
 
-#define _WIN32_WINNT 0x0A00
-
-#ifdef FORCED_DEVICE_DLL_PATH
-#include <Windows.h>
-#endif
-
 #include <iostream>
 #include <iomanip>
+#include <chrono>
+#include <cstdlib>
+#include <algorithm>
 
-#include <QTimer>
-
-#include <vtkSmartPointer.h>
-#include <vtkMatrix4x4.h>
-#include <vtkMath.h>
-
-#include "helpers.hpp"
-#include "geometryHelper.hpp"
+#include <QMetaType>
 
 #include "navAPI.h"
+#include "AtracsysTrackingSource.h"
+#include "ReplayTrackingSource.h"
+#include "LatencyMonitor.h"
 
 using namespace std;
-static const unsigned ENABLE_ONBOARD_PROCESSING_OPTION = 6000;
-static const unsigned SENDING_IMAGES_OPTION = 6003;
-
-// Depending on the OS being used, this condition might change
-const bool isNotFromConsole = isLaunchedFromExplorer();
 
 navAPI::navAPI()
 {
   // Set '.' as decimal separator
   setlocale(LC_ALL,"C");
 
-  mLib = 0;
-  mSn = 0uLL;
-  mFrame = 0;
+  for (unsigned int i=0; i<GEOMETRY_LOOKUP_SIZE; i++)
+    mGeometryToSlot[i] = -1;
+  mNumberOfTools = 0;
+  mVisibleTools = 0;
+  mVisibilityKnown = false;
+  mReportedMarkersCount = 0;
+
+  mMinimumFramePeriod = 0;  // native camera rate
+  mFrameTimeout = 100;
+  mStopRequested = false;
+  mDeviceError = false;
+
+  // signals are emitted from the acquisition thread, so their arguments travel through queued connections
+  qRegisterMetaType<navAPI::MarkerId>("navAPI::MarkerId");
+  qRegisterMetaType<std::vector<navAPI::MarkerId>>("std::vector<navAPI::MarkerId>");
+  qRegisterMetaType<std::vector<mitk::Point3D>>("std::vector<mitk::Point3D>");
+
+  // replay a recorded session instead of using the camera
+  const char* replayFile = std::getenv("NAVCAS_REPLAY_FILE");
+  if ((replayFile != nullptr) && (replayFile[0] != '\0'))
+  {
+    ReplayTrackingSource* replay = new ReplayTrackingSource;
+    replay->SetFileName(replayFile);
 
-  mMarker.push_back(nullptr);
-  mMarker.push_back(nullptr);
-  mMarker.push_back(nullptr);
+    const char* replaySpeed = std::getenv("NAVCAS_REPLAY_SPEED");
+    if (replaySpeed != nullptr)
+      replay->SetSpeed(std::atof(replaySpeed));
 
-  mSamplingPeriod=100;  //200ms = 5Hz
+    mSource.reset(replay);
+  }
+  else
+    mSource.reset(new AtracsysTrackingSource);
+
+  cout << "Tracking source: " << mSource->GetName() << std::endl;
 }
 
 navAPI::~navAPI()
 {
+  StopNavigation();
+  StopRecording();
+
   cout << "navAPI destructor." << std::endl;
-  cout << "mLib: " << mLib << std::endl;
-  cout << "mSn: " << mSn << std::endl;
-  cout << "mFrame: " << mFrame << std::endl;
 }
 
-bool navAPI::SetModeToStandard()
+void navAPI::SetTrackingSource(TrackingSource* source)
 {
-  cout << "Disabling sending images" << std::endl;
-  if (ftkSetInt32( mLib, mSn, SENDING_IMAGES_OPTION, 0) != ftkError::FTK_OK)
-  {
-    error("Cannot disable images sending on the SpryTrack.", !isNotFromConsole);
-    return false;
-  }
-
-  mFrame = ftkCreateFrame();
-
-  if ( mFrame == 0 )
-  {
-    cerr << "Cannot create frame instance" << std::endl;
-    checkError( mLib, !isNotFromConsole  );
-  }
-
-  // retrieve left and rigth images
-  ftkError err( ftkSetFrameOptions( false, 0, 0, 0,
-                                    16u, 4u,
-                                    mFrame ) );
-
-  if ( err != ftkError::FTK_OK )
-  {
-    ftkDeleteFrame( mFrame );
-    cerr << "Cannot initialise frame" << std::endl;
-    checkError( mLib, !isNotFromConsole );
-  }
-
-  cout.setf( ios::fixed, ios::floatfield );
-  cout.precision( 2u );
-
-  return true;
+  StopNavigation();
+  mSource.reset(source);
 }
 
 bool navAPI::DetectCamera()
 {
-  // Defines where to find Atracsys SDK dlls when FORCED_DEVICE_DLL_PATH is set.
-#ifdef FORCED_DEVICE_DLL_PATH
-  SetDllDirectory( (LPCTSTR) FORCED_DEVICE_DLL_PATH );
-#endif
-
-  // Initialize driver
-  mLib = ftkInit();
-
-  if (!mLib)
-  {
-    error( "Cannot initialize driver" , !isNotFromConsole );
-    return false;
-  }
-
-  DeviceData device;
-  device.SerialNumber = 0uLL;
-
-  ftkError err( ftkError::FTK_OK );
-  err = ftkEnumerateDevices( mLib, deviceEnumerator, &device );
-
-  if ( (err > ftkError::FTK_OK) || ( device.SerialNumber == 0uLL ))
-  {
-    return false;
-  }
-
-  // camera was detected and has to be closed
-  CloseCamera();
-  return true;
+  return mSource->Detect();
 }
 
 bool navAPI::InitializeCamera()
 {
-    // -----------------------------------------------------------------------
-    // Defines where to find Atracsys SDK dlls when FORCED_DEVICE_DLL_PATH is
-    // set.
-#ifdef FORCED_DEVICE_DLL_PATH
-		SetDllDirectory( (LPCTSTR) FORCED_DEVICE_DLL_PATH );
-#endif
-
-  // ----------------------------------------------------------------------
-  // Initialize driver
-  mLib = ftkInit();
-
-  if ( ! mLib )
-  {
-    error( "Cannot initialize driver" , !isNotFromConsole );
-    return false;
-  }
-
-  // ----------------------------------------------------------------------
-  // Retrieve the device
-
-  DeviceData device( retrieveLastDevice( mLib, true, false, !isNotFromConsole ) );
-  mSn = device.SerialNumber;
-
-  if (mSn == 0uLL)
-    return false;
-
-  // ------------------------------------------------------------------------
-  // When using a spryTrack, onboard processing of the images is preferred.
-  // Sending of the images is disabled so that the sample operates on a USB2
-  // connection
-  if (ftkDeviceType::DEV_SPRYTRACK_180 == device.Type)
-  {
-    cout << "Enable onboard processing" << std::endl;
-    if ( ftkSetInt32( mLib, mSn, ENABLE_ONBOARD_PROCESSING_OPTION, 1 ) != ftkError::FTK_OK )
-    {
-      error( "Cannot process data directly on the SpryTrack.", !isNotFromConsole );
-    }
+  return mSource->Open();
+}
 
-    cout << "Disable images sending" << std::endl;
-    if (ftkSetInt32( mLib, mSn, SENDING_IMAGES_OPTION, 0) != ftkError::FTK_OK)
-		{
-			error("Cannot disable images sending on the SpryTrack.", !isNotFromConsole);
-		}
+void navAPI::SetMaximumFrameRate(double hz)
+{
+  mMinimumFramePeriod = (hz > 0.0) ? static_cast<long long>(1e6 / hz) : 0;
+}
 
-  }
-  return true;
+double navAPI::GetMaximumFrameRate() const
+{
+  const long long period = mMinimumFramePeriod;
+  return (period > 0) ? 1e6 / period : 0.0;
 }
 
 bool navAPI::CloseCamera()
 {
   cout << "Closing camera" << std::endl;
-  if (!mLib)
-    return false;
 
-  if ( ftkError::FTK_OK != ftkClose( &mLib ) )
-  {
-    checkError( mLib, !isNotFromConsole  );
-    return false;
-  }
+  // the acquisition loop must not use the source while it is being closed
+  if (isRunning())
+    StopNavigation();
 
-  mLib = 0;
-  mSn = 0uLL;
-  return true;
+  return mSource->Close();
 }
 
 
@@ -232,286 +149,318 @@ std::string navAPI::GetGeometryFileName(MarkerId type)
 
 bool navAPI::AddGeometry(const MarkerId type)
 {
-  string geomFile = GetGeometryFileName(type);
+  if (!mSource->AddGeometry(type,GetGeometryFileName(type)))
+    return false;
 
-  ftkGeometry geom;
+  // already tracked
+  if (GetToolSlot(type) >= 0)
+    return true;
 
-  switch ( loadGeometry( mLib, mSn, geomFile, geom ) )
+  if (mNumberOfTools == MAX_TOOLS)
   {
-  case 1:
-    cout << "Loaded from installation directory." << std::endl;
-
-  case 0:
-    if (ftkError::FTK_OK != ftkSetGeometry( mLib, mSn, &geom ) )
-    {
-      checkError( mLib, !isNotFromConsole  );
-    }
-    break;
-
-  default:
-
-    cerr << "Error, cannot load geometry file '"
-         << geomFile << "'." << std::endl;
-    if (ftkError::FTK_OK != ftkClose( &mLib ) )
-    {
-      checkError( mLib, !isNotFromConsole  );
-    }
+    cerr << "Error: cannot track more than " << MAX_TOOLS << " tools" << std::endl;
     return false;
   }
+
+  mToolGeometry[mNumberOfTools] = type;
+  if (static_cast<unsigned int>(type) < GEOMETRY_LOOKUP_SIZE)
+    mGeometryToSlot[type] = static_cast<int8_t>(mNumberOfTools);
+  mNumberOfTools++;
+
   return true;
 }
 
+int navAPI::GetToolSlot(uint32_t geometryId) const
+{
+  if (geometryId < GEOMETRY_LOOKUP_SIZE)
+    return mGeometryToSlot[geometryId];
+
+  for (unsigned int slot=0; slot<mNumberOfTools; slot++)
+    if (mToolGeometry[slot] == geometryId)
+      return static_cast<int>(slot);
+
+  return -1;
+}
+
 
 void navAPI::run()
 {
   cout << "Starting threaded navigation" << std::endl;
 
-  mFrame = ftkCreateFrame();
-
-  if ( mFrame == 0 )
+  if (!mSource->StartStreaming())
   {
-    cerr << "Cannot create frame instance" << std::endl;
-    checkError( mLib, !isNotFromConsole  );
+    cerr << "Cannot start streaming from " << mSource->GetName() << std::endl;
+    return;
   }
 
-  ftkError err( ftkSetFrameOptions( false, 0, 0, 0,
-                                      13u, 4u, mFrame ) );
+  cout.setf( std::ios::fixed, std::ios::floatfield );
+  cout << "Acquisition loop started, maximum frame rate: ";
+  if (GetMaximumFrameRate() > 0.0)
+    cout << GetMaximumFrameRate() << " Hz" << std::endl;
+  else
+    cout << "native" << std::endl;
+
+  using Clock = std::chrono::steady_clock;
+  Clock::time_point lastPublished;
+  bool firstFrame = true;
+  bool streaming = true;
 
-  if ( err != ftkError::FTK_OK )
+  while (streaming && !mStopRequested)
   {
-    ftkDeleteFrame( mFrame );
-    cerr << "Cannot initialise frame" << std::endl;
-    checkError( mLib, !isNotFromConsole  );
-  }
+    // block until the next frame is available (or the timeout expires)
+    switch (mSource->WaitForFrame(mFrame,mFrameTimeout))
+    {
+    case TrackingSource::NewFrame:
+      break;
 
-  cout.setf( std::ios::fixed, std::ios::floatfield );
+    case TrackingSource::Timeout:
+      continue;
+
+    case TrackingSource::DeviceError:
+      // report once per error burst and avoid spinning on a disconnected device
+      if (!mDeviceError)
+        cerr << "Cannot get last frame from " << mSource->GetName() << std::endl;
+      mDeviceError = true;
+      msleep(mFrameTimeout);
+      continue;
 
-  // Start real time system
-  mTimer = new QTimer(this);
-  mTimer->setInterval(mSamplingPeriod); // default sampling rate is 5 Hz
-  mTimer->moveToThread(this);
-  connect(mTimer,SIGNAL(timeout()),this,SLOT(GetLastFrame()));
-  mTimer->start();
-  cout << "Timer started, period of " << mTimer->interval() << " ms" << std::endl;
+    case TrackingSource::EndOfStream:
+      cout << "End of tracking stream" << std::endl;
+      streaming = false;
+      continue;
+
+    case TrackingSource::FatalError:
+    default:
+      streaming = false;
+      continue;
+    }
+    mDeviceError = false;
+
+    // every frame is recorded, regardless of the published frame rate
+    mRecorder.Push(mFrame);
+
+    // raw frames are only copied while a consumer captures them
+    if (mRawCapture && mFrame.fiducialsValid)
+      mRawFrames.Push(mFrame);
+
+    // drop frames arriving faster than the maximum frame rate
+    const Clock::time_point now = Clock::now();
+    const long long minimumPeriod = mMinimumFramePeriod;
+    if (!firstFrame && (minimumPeriod > 0) &&
+        (std::chrono::duration_cast<std::chrono::microseconds>(now - lastPublished).count() < minimumPeriod))
+      continue;
 
-  // Execute the thread
-  exec();
+    firstFrame = false;
+    lastPublished = now;
+
+    GetLastFrame();
+  }
+
+  mSource->StopStreaming();
+
+  cout << "Acquisition loop finished" << std::endl;
 }
 
-void navAPI::StopNavigation()
+void navAPI::start()
 {
-  quit();
-  cout << "Thread quitted!" << std::endl;
+  mStopRequested = false;
+  mDeviceError = false;
 
+  // the first frame reports the complete visibility
+  mVisibilityKnown = false;
+  QThread::start();
+}
 
-  if (!mFrame)
-    return;
-
-  mTimer->stop();
-  ftkDeleteFrame( mFrame );
-  mFrame = 0;
-  delete mTimer;
+void navAPI::StopNavigation()
+{
+  mStopRequested = true;
 
-  this->exit();
+  // the loop checks the stop flag at least once per frame timeout
+  if (isRunning())
+    wait();
 
   cout << "Navigation stopped " << std::endl;
 }
 
-void navAPI::GetRelativePositions(unsigned int m)
+void navAPI::GetRelativePositions(const TrackingMarker* reference)
 {
-  floatXX translation[ 3u ];
-  floatXX rotation[ 3u ][ 3u ];
-
-  for ( unsigned i = 0; i < 3u; i++ )
+  // gather the tools (all but the reference) in structure-of-arrays form
+  unsigned int n = 0;
+  for (unsigned int v=0; v<mVisibleTools; v++)
   {
-    floatXX tmp = 0.;
-    for (unsigned int k = 0u; k < 3u; ++k )
-    {
-      // Since the rotation is a matrix from SO(3) the inverse
-      // is the transposed matrix.
-      // Therefore R^-1 * t = R^T * t
-      tmp += mMarker[0]->rotation[ k ][ i ] *
-             ( mMarker[m]->translationMM[ k ] -
-               mMarker[0]->translationMM[ k ] );
-    }
-    translation[i] = tmp;
-  }
+    const TrackingMarker* marker = mVisibleMarker[v];
+    if (marker == reference)
+      continue;
 
-  for ( unsigned int i = 0u; i < 3u; ++i )
-  {
-    for ( unsigned int j = 0u; j < 3u; ++j )
-    {
-      floatXX tmp = 0.;
-      for ( unsigned int k = 0u; k < 3u; ++k )
-      {
-        // Since the rotation is a matrix from SO(3) the inverse
-        // is the transposed matrix.
-        // Therefore R^-1 * R' = R^T * R'
-        tmp += mMarker[0]->rotation[ k ][ i ] *
-               mMarker[m]->rotation[ k ][ j ];
-      }
-      rotation[ i ][ j ] = tmp;
-    }
+    for (unsigned int k=0; k<9; k++)
+      mToolPoses.rotation[k][n] = marker->rotation[k/3][k%3];
+    for (unsigned int k=0; k<3; k++)
+      mToolPoses.translation[k][n] = marker->translationMM[k];
+    mBatchSlot[n] = mVisibleSlot[v];
+    mBatchMarker[n] = marker;
+    n++;
   }
+  mToolPoses.count = n;
+
+  // all relative poses in one pass
+  ComputeRelativePoses(reference->rotation, reference->translationMM, mToolPoses, mRelativeToolPoses);
+  const uint64_t publishTime = LatencyMonitor::Now();
 
-  // Compose transformation matrix
-  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  for (unsigned int i=0; i<3; i++)
+  for (unsigned int b=0; b<n; b++)
   {
-    for (unsigned int j=0; j<3; j++)
+    PoseRecord& record = mSnapshot.poses[b];
+    record.markerId = mBatchMarker[b]->geometryId;
+    record.quality = mBatchMarker[b]->registrationErrorMM;
+    record.timestamp = mFrame.timestamp;
+    record.publishTime = publishTime;
+
+    for (unsigned int i=0; i<3; i++)
     {
-      matrix->SetElement(i,j,rotation[i][j]);
+      for (unsigned int j=0; j<3; j++)
+        record.pose[i][j] = mRelativeToolPoses.rotation[3*i+j][b];
+      record.pose[i][3] = mRelativeToolPoses.translation[i][b];
     }
-    matrix->SetElement(i,3,translation[i]);
-  }
-  matrix->SetElement(3,0,0.0);
-  matrix->SetElement(3,1,0.0);
-  matrix->SetElement(3,2,0.0);
-  matrix->SetElement(3,3,1.0);
 
-  emit MarkerRelativePosition(m,matrix);
+    mSnapshot.poseSlot[b] = mBatchSlot[b];
+  }
+  mSnapshot.posesCount = n;
 }
 
 void navAPI::GetLastFrame()
 {
-  if ( ftkGetLastFrame( mLib, mSn, mFrame, 0  ) != ftkError::FTK_OK )
-      // block until next frame is available //
-  {
-    cout << std::endl << "." << std::endl;
-    return;
-  }
+  // Tools have to be re-detected in every frame: single pass over the detected markers
+  const MarkerId referenceType = mReferenceMarkerType;
+  const TrackingMarker* reference = nullptr;
+  const TrackingMarker* probe = nullptr;
+  mVisibleTools = 0;
 
-  if (ftkReprocessFrame(mLib, mSn, mFrame) != ftkError::FTK_OK)
-    cout << std::endl << "Could not reprocess" << std::endl;
+  mSnapshot.timestamp = mFrame.timestamp;
+  mSnapshot.markersCount = mFrame.markersCount;
+  mSnapshot.posesCount = 0;
 
-  switch ( mFrame->markersStat )
+  for ( uint32_t m = 0; m < mFrame.markersCount; m++ )
   {
-  case ftkQueryStatus::QS_WAR_SKIPPED:
-    ftkDeleteFrame( mFrame );
-    cerr << "marker fields in the frame are not set correctly" << std::endl;
-    checkError( mLib, !isNotFromConsole  );
-    return;
+    const TrackingMarker& marker = mFrame.markers[m];
+    mSnapshot.markers[m] = marker.geometryId;
 
-  case ftkQueryStatus::QS_ERR_INVALID_RESERVED_SIZE:
-    ftkDeleteFrame( mFrame );
-    cerr << "frame -> markersVersionSize is invalid" << std::endl;
-    checkError( mLib, !isNotFromConsole  );
-    return;
+    const int slot = GetToolSlot(marker.geometryId);
 
-  case ftkQueryStatus::QS_ERR_OVERFLOW:
-      //ftkDeleteFrame( mFrame );
-      cerr << "frame -> data is missing because buffer size is too small" << std::endl;
-      //checkError( mLib, !isNotFromConsole  );
-    break;
+    // geometry not added
+    if (slot < 0)
+      continue;
 
-  default:
-    ftkDeleteFrame( mFrame );
-    cerr << "invalid status" << std::endl;
-    checkError( mLib, !isNotFromConsole  );
-    return;
+    mVisibleSlot[mVisibleTools] = static_cast<unsigned int>(slot);
+    mVisibleMarker[mVisibleTools] = &marker;
+    mVisibleTools++;
 
-  case ftkQueryStatus::QS_OK:
-    break;
+    if ((marker.geometryId == static_cast<uint32_t>(referenceType)) && (referenceType != None))
+      reference = &marker;
+    else if ((marker.geometryId == Probe) || (marker.geometryId == TemporalProbe))
+      probe = &marker;
   }
 
+  // If a single marker (not probe) is in the view
+  mSnapshot.singleMarker = None;
+  if ((mFrame.markersCount == 1) &&
+      (mFrame.markers[0].geometryId != Probe) &&
+      (mFrame.markers[0].geometryId != TemporalProbe))
+    mSnapshot.singleMarker = mFrame.markers[0].geometryId;
 
-  // No markers detected
-  if ( mFrame->markersCount == 0u )
-  {
-    emit MultipleOrNullMarkersInView();
-    std::vector<MarkerId> empty;
-    emit MultipleMarkersInView(empty);
-    return;
-  }
+  // Relative positions
+  if (reference != nullptr)
+    GetRelativePositions(reference);
 
-  if ( mFrame->markersStat == ftkQueryStatus::QS_ERR_OVERFLOW )
-  {
-    cerr << "WARNING: marker overflow. Please increase cstMarkersCount" << std::endl;
-  }
+  // Valid probe and reference marker
+  mSnapshot.validProbe = (probe != nullptr) && (probe->geometryId == Probe) && (reference != nullptr);
 
+  // Valid temporal probe and reference marker (calibration), the raw fiducials are read from the raw frame buffer
+  mSnapshot.validTemporalProbe = (probe != nullptr) && (probe->geometryId == TemporalProbe) && (reference != nullptr) &&
+                                 mFrame.fiducialsValid;
 
-  // Reference marker, second marker and probe have to be re-detected in every frame
-  mMarker[0] = 0;
-  mMarker[1] = 0;
-  mMarker[2] = 0;
+  // publish without allocating: the GUI reads the newest snapshot at render time
+  mSnapshot.publishTime = LatencyMonitor::Now();
+  mSnapshots.Push(mSnapshot);
 
-  // Set reference marker, second marker and probe
-  for ( size_t m = 0; m < mFrame->markersCount; m++ )
-  {
-    MarkerId type = static_cast<MarkerId>(mFrame->markers[ m ].geometryId);
+  ReportVisibility();
+}
 
-    if ((type == mReferenceMarkerType) && (type != None) )
-    {
-      mMarker[0] = &(mFrame->markers[m]);
-    }
-    else if ((type == SmallTracker) || (type == MediumTracker) || (type == BigTracker))
-    {
-      mMarker[1] = &(mFrame->markers[m]);
-    }
-    else if ((type == Probe) || (type == TemporalProbe))
-    {
-      mMarker[2] = &(mFrame->markers[m]);
-    }
-  }
+void navAPI::ReportVisibility()
+{
+  const bool known = mVisibilityKnown;
+  mVisibilityKnown = true;
 
-  // If a single marker (not probe) is in the view
-  if ((mFrame->markersCount == 1) &&
-      (mFrame->markers[0].geometryId != Probe) &&
-      (mFrame->markers[0].geometryId != TemporalProbe))
+  if (!known || (mSnapshot.singleMarker != mReportedSingleMarker))
   {
-    MarkerId type = static_cast<MarkerId>(mFrame->markers[0].geometryId);
-    emit SingleMarkerInView(type);
+    mReportedSingleMarker = mSnapshot.singleMarker;
+    if (mSnapshot.singleMarker != None)
+      emit SingleMarkerInView(static_cast<MarkerId>(mSnapshot.singleMarker));
+    else
+      emit MultipleOrNullMarkersInView();
   }
-  else
-    emit MultipleOrNullMarkersInView();
 
-  // Send relative positions
-  for ( unsigned int m = 1; m < mMarker.size(); m++ )
+  if (!known || (mSnapshot.validProbe != mReportedValidProbe))
   {
-    if ((mMarker[m] != 0) && (mMarker[0] != 0))
-      GetRelativePositions(m);
+    mReportedValidProbe = mSnapshot.validProbe;
+    if (mSnapshot.validProbe)
+      emit ValidProbeInView();
+    else
+      emit InvalidProbeInView();
   }
 
-  // Valid probe and reference marker
-  if ((mMarker[2] != 0) && (mMarker[2]->geometryId == Probe) && (mMarker[0] != 0))
-    emit ValidProbeInView();
-  else
-    emit InvalidProbeInView();
+  if (mSnapshot.validTemporalProbe && (!known || !mReportedValidTemporalProbe))
+    emit ValidTemporalProbeInView();
+  mReportedValidTemporalProbe = mSnapshot.validTemporalProbe;
 
-  // Send list of markers in view
-  std::vector<MarkerId> markerList;
-  for ( unsigned int m = 0; m < mFrame->markersCount; m++ )
-  {
-    if (mFrame->markers[m].geometryId == Probe)
-      continue;
+  // list of markers in view (probe excluded), sorted so that a reordering is not a change
+  uint32_t markers[TRACKING_MAX_MARKERS];
+  uint32_t count = 0;
+  for (uint32_t m=0; m<mSnapshot.markersCount; m++)
+    if (mSnapshot.markers[m] != Probe)
+      markers[count++] = mSnapshot.markers[m];
+  std::sort(markers, markers+count);
 
-    // could use lookup table
-    MarkerId type = static_cast<MarkerId>(mFrame->markers[m].geometryId);
-    markerList.push_back(type);
-  }
+  if (known && (count == mReportedMarkersCount) && std::equal(markers, markers+count, mReportedMarkers))
+    return;
+
+  mReportedMarkersCount = count;
+  std::copy(markers, markers+count, mReportedMarkers);
+
+  std::vector<MarkerId> markerList;
+  for (uint32_t m=0; m<count; m++)
+    markerList.push_back(static_cast<MarkerId>(markers[m]));
   emit MultipleMarkersInView(markerList);
+}
 
-  // Valid temporal probe and reference marker (calibration)
-  if ((mMarker[2] != 0) && (mMarker[2]->geometryId == TemporalProbe) && (mMarker[0] != 0))
-  {
-    // check the existance of raw data
-    if ( mFrame->threeDFiducialsStat != ftkQueryStatus::QS_OK )
-    {
-      //cout << "No raw data available" << std::endl;
-      return;
-    }
+unsigned int navAPI::GetMarkerFiducials(const TrackingFrame& frame, uint32_t geometryId,
+                                        mitk::Point3D fiducials[TRACKING_MAX_MARKER_FIDUCIALS],
+                                        bool valid[TRACKING_MAX_MARKER_FIDUCIALS])
+{
+  for (unsigned int i=0; i<TRACKING_MAX_MARKER_FIDUCIALS; i++)
+    valid[i] = false;
 
-    emit ValidTemporalProbeInView();
+  if (!frame.fiducialsValid)
+    return 0;
 
-    // get the probes fiducials
-    uint32* fiducialCorrespondence = mMarker[2]->fiducialCorresp;
+  for (uint32_t m=0; m<frame.markersCount; m++)
+  {
+    const TrackingMarker& marker = frame.markers[m];
+    if (marker.geometryId != geometryId)
+      continue;
 
-    for (unsigned int i=0; i<FTK_MAX_FIDUCIALS; i++)
+    unsigned int count = 0;
+    for (unsigned int i=0; i<TRACKING_MAX_MARKER_FIDUCIALS; i++)
     {
-      uint32 m = fiducialCorrespondence[i];
-
-      if (m == INVALID_ID)
+      const uint32_t f = marker.fiducialCorresp[i];
+      if ((f == TRACKING_INVALID_ID) || (f >= frame.fiducialsCount))
         continue;
+
+      for (unsigned int k=0; k<3; k++)
+        fiducials[i][k] = frame.fiducials[f].positionMM[k];
+      valid[i] = true;
+      count++;
     }
+    return count;
   }
+
+  return 0;
 }
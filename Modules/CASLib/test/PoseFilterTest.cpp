@@ -0,0 +1,141 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <algorithm>
+#include <cmath>
+// Module includes
+#include "PoseFilter.h"
+
+class PoseFilterTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(PoseFilterTestSuite);
+  MITK_TEST(ConstantPoseIsStationary);
+  MITK_TEST(StepLagIsBounded);
+  MITK_TEST(ResetTakesNextPose);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  static constexpr double PERIOD = 1.0/250.0;   // s, camera rate
+
+  double mPose[3][4];
+
+  static double MaximumDifference(const double a[3][4], const double b[3][4])
+  {
+    double difference = 0.0;
+    for (unsigned int i=0; i<3; i++)
+      for (unsigned int j=0; j<4; j++)
+        difference = std::max(difference,std::abs(a[i][j]-b[i][j]));
+    return difference;
+  }
+
+public:
+  void setUp() override
+  {
+    // rotated and far from the camera origin
+    const double rotation[3] = {0.4, -0.2, 1.1};
+    const double translation[3] = {-35.0, 120.0, -1500.0};
+    RigidTransform::FromQuaternion(Quaternion::FromRotationVector(rotation),translation).GetMatrix(mPose);
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void ConstantPoseIsStationary()
+  {
+    for (PoseFilter::FilterType type : {PoseFilter::OneEuro, PoseFilter::Kalman})
+    {
+      PoseFilter filter;
+      filter.SetType(type);
+      filter.SetPredictionHorizon(30.0);
+
+      double filtered[3][4];
+      double maximum = 0.0;
+      for (unsigned int k=0; k<500; k++)
+      {
+        filter.Update(mPose,k*PERIOD,filtered);
+        maximum = std::max(maximum,MaximumDifference(mPose,filtered));
+      }
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("A still tool does not move, even predicted", 0.0, maximum, 1e-9);
+    }
+  }
+
+  void StepLagIsBounded()
+  {
+    for (PoseFilter::FilterType type : {PoseFilter::OneEuro, PoseFilter::Kalman})
+    {
+      PoseFilter filter;
+      filter.SetType(type);
+
+      double filtered[3][4];
+      unsigned int k = 0;
+      for (; k<50; k++)
+        filter.Update(mPose,k*PERIOD,filtered);
+
+      // 10 mm step along x
+      double step[3][4];
+      for (unsigned int i=0; i<3; i++)
+        for (unsigned int j=0; j<4; j++)
+          step[i][j] = mPose[i][j];
+      step[0][3] += 10.0;
+
+      const unsigned int start = k;
+      for (; k<start+5; k++)
+        filter.Update(step,k*PERIOD,filtered);
+      CPPUNIT_ASSERT_MESSAGE("Half of the step within 20 ms", filtered[0][3] - mPose[0][3] > 5.0);
+
+      for (; k<start+25; k++)
+        filter.Update(step,k*PERIOD,filtered);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Step reached within 100 ms", step[0][3], filtered[0][3], 0.1);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Other axes unchanged", step[1][3], filtered[1][3], 1e-6);
+    }
+  }
+
+  void ResetTakesNextPose()
+  {
+    PoseFilter filter;
+    filter.SetType(PoseFilter::OneEuro);
+
+    double filtered[3][4];
+    double moved[3][4];
+    const double rotation[3] = {-0.3, 0.6, 0.2};
+    const double translation[3] = {80.0, -10.0, -1400.0};
+    RigidTransform::FromQuaternion(Quaternion::FromRotationVector(rotation),translation).GetMatrix(moved);
+
+    unsigned int k = 0;
+    for (; k<50; k++)
+      filter.Update(mPose,k*PERIOD,filtered);
+
+    // filtered: lags behind
+    filter.Update(moved,k*PERIOD,filtered);
+    CPPUNIT_ASSERT_MESSAGE("Filtered", MaximumDifference(moved,filtered) > 1.0);
+
+    // reset: the next pose is taken as is
+    filter.Reset();
+    filter.Update(moved,(++k)*PERIOD,filtered);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Reset", 0.0, MaximumDifference(moved,filtered), 1e-9);
+
+    // as after a gap or a time going backwards
+    filter.Update(mPose,(++k)*PERIOD + 2.0*PoseFilter::MAXIMUM_GAP,filtered);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Gap", 0.0, MaximumDifference(mPose,filtered), 1e-9);
+    filter.Update(moved,0.0,filtered);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Time backwards", 0.0, MaximumDifference(moved,filtered), 1e-9);
+
+    // changing the type resets too
+    filter.Update(mPose,PERIOD,filtered);
+    filter.SetType(PoseFilter::Kalman);
+    filter.Update(moved,2.0*PERIOD,filtered);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Type changed", 0.0, MaximumDifference(moved,filtered), 1e-9);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(PoseFilter)
@@ -0,0 +1,155 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <cstring>
+#include <vector>
+// Module includes
+#include "navAPI.h"
+#include "TrackingSource.h"
+
+/// delivers a fixed list of frames, then ends the stream
+class FrameListSource : public TrackingSource
+{
+public:
+  explicit FrameListSource(const std::vector<TrackingFrame>& frames) : mFrames(frames), mNext(0) {}
+
+  std::string GetName() const override {return "Frame list";}
+  bool Detect() override {return true;}
+  bool Open() override {return true;}
+  bool Close() override {return true;}
+  bool IsOpen() const override {return true;}
+  bool AddGeometry(uint32_t, const std::string&) override {return true;}
+  bool StartStreaming() override {mNext = 0; return true;}
+  void StopStreaming() override {}
+
+  FrameStatus WaitForFrame(TrackingFrame& frame, unsigned int) override
+  {
+    if (mNext == mFrames.size())
+      return EndOfStream;
+    frame = mFrames[mNext++];
+    return NewFrame;
+  }
+
+private:
+  std::vector<TrackingFrame>  mFrames;
+  std::size_t                 mNext;
+};
+
+class RawFramesTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(RawFramesTestSuite);
+  MITK_TEST(OnlyCapturedFramesArePushed);
+  MITK_TEST(FiducialsInGeometryOrder);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  static const unsigned int N = 40;
+
+  std::vector<TrackingFrame> mFrames;
+
+  // a probe whose fiducials are listed in reverse order in the frame
+  static TrackingFrame CreateFrame(unsigned int i)
+  {
+    TrackingFrame frame;
+    std::memset(&frame,0,sizeof(frame));
+    frame.timestamp = 1000000 + 4000*i;
+    frame.markersCount = 1;
+    frame.fiducialsValid = true;
+    frame.fiducialsCount = 4;
+
+    TrackingMarker& marker = frame.markers[0];
+    marker.geometryId = navAPI::Probe;
+    for (unsigned int r=0; r<3; r++)
+      marker.rotation[r][r] = 1.0;
+    for (unsigned int f=0; f<TRACKING_MAX_MARKER_FIDUCIALS; f++)
+      marker.fiducialCorresp[f] = (f < 4) ? 3-f : TRACKING_INVALID_ID;
+
+    for (unsigned int f=0; f<4; f++)
+      for (unsigned int k=0; k<3; k++)
+        frame.fiducials[f].positionMM[k] = 10.0*f + k + 0.001*i;
+    return frame;
+  }
+
+  void Stream(navAPI& api)
+  {
+    api.SetTrackingSource(new FrameListSource(mFrames));
+    api.start();
+    api.wait();
+  }
+
+public:
+  void setUp() override
+  {
+    mFrames.clear();
+    for (unsigned int i=0; i<N; i++)
+      mFrames.push_back(CreateFrame(i));
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void OnlyCapturedFramesArePushed()
+  {
+    navAPI api;
+    Stream(api);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("No capture, no copies", uint64_t(0), api.GetRawFrameBuffer().GetNumberOfPushedRecords());
+
+    api.SetRawCaptureEnabled(true);
+    Stream(api);
+    navAPI::RawFrameBuffer& buffer = api.GetRawFrameBuffer();
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Every frame while capturing", uint64_t(N), buffer.GetNumberOfPushedRecords());
+
+    // the consumer fell behind: only the newest frames are kept, in order
+    TrackingFrame frame;
+    uint64_t expected = N - navAPI::RawFrameBuffer::GetCapacity();
+    while (buffer.Pop(frame))
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("In order", mFrames[expected].timestamp, frame.timestamp);
+      expected++;
+    }
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Drained", uint64_t(N), expected);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Dropped", uint64_t(N - navAPI::RawFrameBuffer::GetCapacity()), buffer.GetNumberOfDroppedRecords());
+
+    // frames without raw fiducials are not published
+    for (TrackingFrame& f : mFrames)
+      f.fiducialsValid = false;
+    Stream(api);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Invalid fiducials", uint64_t(N), buffer.GetNumberOfPushedRecords());
+  }
+
+  void FiducialsInGeometryOrder()
+  {
+    TrackingFrame frame = CreateFrame(0);
+    frame.markers[0].fiducialCorresp[1] = TRACKING_INVALID_ID;
+
+    mitk::Point3D fiducials[TRACKING_MAX_MARKER_FIDUCIALS];
+    bool valid[TRACKING_MAX_MARKER_FIDUCIALS];
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Matched fiducials", 3u, navAPI::GetMarkerFiducials(frame,navAPI::Probe,fiducials,valid));
+
+    // an unmatched fiducial keeps its index
+    for (unsigned int i=0; i<TRACKING_MAX_MARKER_FIDUCIALS; i++)
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Valid", (i < 4) && (i != 1), valid[i]);
+      if (valid[i])
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Geometry order", 10.0*(3-i) + 2.0, fiducials[i][2], 0.0);
+    }
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Marker not in frame", 0u, navAPI::GetMarkerFiducials(frame,navAPI::SmallTracker,fiducials,valid));
+    CPPUNIT_ASSERT_MESSAGE("Nothing valid", !valid[0] && !valid[2]);
+
+    frame.fiducialsValid = false;
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("No raw fiducials", 0u, navAPI::GetMarkerFiducials(frame,navAPI::Probe,fiducials,valid));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(RawFrames)
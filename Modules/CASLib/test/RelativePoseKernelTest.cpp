@@ -0,0 +1,173 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <chrono>
+#include <cmath>
+#include <random>
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+// Module includes
+#include "RelativePoseKernel.h"
+#include "TrackingFrame.h"
+
+class RelativePoseKernelTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(RelativePoseKernelTestSuite);
+  MITK_TEST(MatchesScalarCode);
+  MITK_TEST(Benchmark);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  static const unsigned int MAX_TOOLS = TRACKING_MAX_MARKERS;
+
+  TrackingMarker mReference;
+  TrackingMarker mTools[MAX_TOOLS];
+  PoseBatch<MAX_TOOLS> mBatch;
+  PoseBatch<MAX_TOOLS> mRelative;
+
+  // random rotation (unit quaternion) and translation in the camera working volume
+  static void RandomPose(std::mt19937& rng, TrackingMarker& marker)
+  {
+    std::normal_distribution<double> normal;
+    std::uniform_real_distribution<double> position(-500.0,500.0);
+
+    double q[4] = {normal(rng),normal(rng),normal(rng),normal(rng)};
+    const double norm = std::sqrt(q[0]*q[0]+q[1]*q[1]+q[2]*q[2]+q[3]*q[3]);
+    for (double& v : q)
+      v /= norm;
+
+    const double w=q[0], x=q[1], y=q[2], z=q[3];
+    const double r[3][3] = {{1-2*(y*y+z*z), 2*(x*y-w*z),   2*(x*z+w*y)},
+                            {2*(x*y+w*z),   1-2*(x*x+z*z), 2*(y*z-w*x)},
+                            {2*(x*z-w*y),   2*(y*z+w*x),   1-2*(x*x+y*y)}};
+    for (unsigned int i=0; i<3; i++)
+    {
+      for (unsigned int j=0; j<3; j++)
+        marker.rotation[i][j] = r[i][j];
+      marker.translationMM[i] = position(rng);
+    }
+  }
+
+  // relative pose as computed per marker before the batched kernel, copied to a vtkMatrix4x4
+  static void ScalarRelativePose(const TrackingMarker& reference, const TrackingMarker& marker, vtkMatrix4x4* matrix)
+  {
+    double pose[3][4];
+    for (unsigned int i=0; i<3; i++)
+    {
+      double tmp = 0.;
+      for (unsigned int k=0; k<3; k++)
+        tmp += reference.rotation[k][i] * (marker.translationMM[k] - reference.translationMM[k]);
+      pose[i][3] = tmp;
+    }
+
+    for (unsigned int i=0; i<3; i++)
+    {
+      for (unsigned int j=0; j<3; j++)
+      {
+        double tmp = 0.;
+        for (unsigned int k=0; k<3; k++)
+          tmp += reference.rotation[k][i] * marker.rotation[k][j];
+        pose[i][j] = tmp;
+      }
+    }
+
+    for (unsigned int i=0; i<3; i++)
+      for (unsigned int j=0; j<4; j++)
+        matrix->SetElement(i,j,pose[i][j]);
+  }
+
+  void FillBatch(unsigned int n)
+  {
+    mBatch.count = n;
+    for (unsigned int t=0; t<n; t++)
+    {
+      for (unsigned int k=0; k<9; k++)
+        mBatch.rotation[k][t] = mTools[t].rotation[k/3][k%3];
+      for (unsigned int k=0; k<3; k++)
+        mBatch.translation[k][t] = mTools[t].translationMM[k];
+    }
+  }
+
+public:
+  void setUp() override
+  {
+    std::mt19937 rng(2021);
+    RandomPose(rng,mReference);
+    for (unsigned int t=0; t<MAX_TOOLS; t++)
+      RandomPose(rng,mTools[t]);
+  }
+
+  void tearDown() override
+  {
+  }
+
+  void MatchesScalarCode()
+  {
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+
+    for (unsigned int n=0; n<=MAX_TOOLS; n++)
+    {
+      FillBatch(n);
+      ComputeRelativePoses(mReference.rotation, mReference.translationMM, mBatch, mRelative);
+      CPPUNIT_ASSERT_MESSAGE("Wrong number of relative poses", mRelative.count == n);
+
+      for (unsigned int t=0; t<n; t++)
+      {
+        ScalarRelativePose(mReference,mTools[t],matrix);
+        for (unsigned int i=0; i<3; i++)
+        {
+          for (unsigned int j=0; j<3; j++)
+            CPPUNIT_ASSERT_MESSAGE("Relative rotation differs", std::abs(mRelative.rotation[3*i+j][t] - matrix->GetElement(i,j)) < 1e-12);
+          CPPUNIT_ASSERT_MESSAGE("Relative translation differs", std::abs(mRelative.translation[i][t] - matrix->GetElement(i,3)) < 1e-9);
+        }
+      }
+    }
+  }
+
+  // informative only: timings depend on the machine and build type
+  void Benchmark()
+  {
+    typedef std::chrono::steady_clock Clock;
+    const unsigned int frames = 100000;
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+
+    for (unsigned int n : {1u, 4u, MAX_TOOLS})
+    {
+      double checksum = 0.0;
+
+      Clock::time_point start = Clock::now();
+      for (unsigned int f=0; f<frames; f++)
+      {
+        for (unsigned int t=0; t<n; t++)
+          ScalarRelativePose(mReference,mTools[t],matrix);
+        checksum += matrix->GetElement(0,3);
+      }
+      const double scalar = std::chrono::duration<double,std::nano>(Clock::now() - start).count() / frames;
+
+      start = Clock::now();
+      for (unsigned int f=0; f<frames; f++)
+      {
+        FillBatch(n);
+        ComputeRelativePoses(mReference.rotation, mReference.translationMM, mBatch, mRelative);
+        checksum += mRelative.translation[0][n-1];
+      }
+      const double batched = std::chrono::duration<double,std::nano>(Clock::now() - start).count() / frames;
+
+      MITK_INFO << n << " tools: scalar " << scalar << " ns/frame, batched (gather included) " << batched
+                << " ns/frame (checksum " << checksum << ")";
+      CPPUNIT_ASSERT_MESSAGE("Invalid relative poses", std::isfinite(checksum));
+    }
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(RelativePoseKernel)
@@ -0,0 +1,191 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <chrono>
+#include <vector>
+// qt include
+#include <QDir>
+#include <QFile>
+// Module includes
+#include "ReplayTrackingSource.h"
+#include "TrackingRecorder.h"
+
+class ReplayTrackingSourceTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(ReplayTrackingSourceTestSuite);
+  MITK_TEST(OriginalRate);
+  MITK_TEST(AcceleratedRate);
+  MITK_TEST(AsFastAsPossible);
+  MITK_TEST(GeometryFilter);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  typedef std::chrono::steady_clock Clock;
+
+  // 20 frames, 20 ms apart: the session lasts 380 ms
+  static const unsigned int N = 20;
+  static const uint64_t PERIOD = 20000;
+
+  std::vector<TrackingFrame> mFrames;
+  std::string mFileName;
+
+  // a reference, and a probe in every other frame
+  void CreateFrames()
+  {
+    mFrames.resize(N);
+    for (unsigned int i=0; i<N; i++)
+    {
+      TrackingFrame& frame = mFrames[i];
+      frame.timestamp = 3000000 + PERIOD*i;
+      frame.markersOverflow = false;
+      frame.fiducialsValid = false;
+      frame.fiducialsCount = 0;
+      frame.markersCount = (i%2 == 0) ? 2 : 1;
+
+      for (unsigned int m=0; m<frame.markersCount; m++)
+      {
+        TrackingMarker& marker = frame.markers[m];
+        marker.geometryId = (m == 0) ? 2 : 123;
+        for (unsigned int r=0; r<3; r++)
+        {
+          for (unsigned int c=0; c<3; c++)
+            marker.rotation[r][c] = (r == c) ? 1.0 : 0.0;
+          marker.translationMM[r] = 100.0*m + 0.5*i + r;
+        }
+        marker.registrationErrorMM = 0.1;
+        for (unsigned int f=0; f<TRACKING_MAX_MARKER_FIDUCIALS; f++)
+          marker.fiducialCorresp[f] = TRACKING_INVALID_ID;
+      }
+    }
+  }
+
+  // records the session as navAPI does, from the acquisition side
+  bool Record()
+  {
+    TrackingRecorder recorder;
+    if (!recorder.Start(mFileName))
+      return false;
+
+    for (const TrackingFrame& frame : mFrames)
+      recorder.Push(frame);
+    recorder.Stop();
+
+    return (recorder.GetNumberOfRecordedFrames() == N) && (recorder.GetNumberOfDroppedFrames() == 0);
+  }
+
+  /*  Replays the whole recording, checking the frames arrive in the recorded order.
+      Returns the duration of the replay in ms.*/
+  double Replay(double speed)
+  {
+    ReplayTrackingSource source;
+    source.SetFileName(mFileName);
+    source.SetSpeed(speed);
+    CPPUNIT_ASSERT_MESSAGE("Recording not detected", source.Detect());
+    CPPUNIT_ASSERT_MESSAGE("Recording could not be opened", source.Open() && source.StartStreaming());
+
+    TrackingFrame frame;
+    const Clock::time_point start = Clock::now();
+    for (unsigned int i=0; i<N; i++)
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Frame missing", TrackingSource::NewFrame, source.WaitForFrame(frame,1000));
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Frame order", mFrames[i].timestamp, frame.timestamp);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Markers", mFrames[i].markersCount, frame.markersCount);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Pose", mFrames[i].markers[0].translationMM[0], frame.markers[0].translationMM[0], 1e-3);
+    }
+    const double duration = std::chrono::duration<double,std::milli>(Clock::now() - start).count();
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("End of the recording", TrackingSource::EndOfStream, source.WaitForFrame(frame,1000));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Replayed frames", static_cast<unsigned long long>(N), source.GetNumberOfReplayedFrames());
+    return duration;
+  }
+
+public:
+  void setUp() override
+  {
+    mFileName = QDir::temp().filePath("ReplayTrackingSourceTest.navlog").toStdString();
+    CreateFrames();
+    CPPUNIT_ASSERT_MESSAGE("Session could not be recorded", Record());
+  }
+
+  void tearDown() override
+  {
+    QFile::remove(QString::fromStdString(mFileName));
+    mFrames.clear();
+  }
+
+  void OriginalRate()
+  {
+    // frames are never delivered before their time, the upper bound leaves room for a loaded machine
+    const double session = (N-1)*PERIOD*1e-3;
+    const double duration = Replay(1.0);
+    CPPUNIT_ASSERT_MESSAGE("Replayed too fast", duration >= session - 1.0);
+    CPPUNIT_ASSERT_MESSAGE("Replayed too slow", duration < 2.0*session);
+
+    // a frame that is not due yet is not delivered before the timeout
+    ReplayTrackingSource source;
+    source.SetFileName(mFileName);
+    CPPUNIT_ASSERT_MESSAGE("Recording could not be opened", source.Open() && source.StartStreaming());
+    TrackingFrame frame;
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("First frame", TrackingSource::NewFrame, source.WaitForFrame(frame,1000));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Next frame not due", TrackingSource::Timeout, source.WaitForFrame(frame,1));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Next frame", TrackingSource::NewFrame, source.WaitForFrame(frame,1000));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Frame after the timeout", mFrames[1].timestamp, frame.timestamp);
+  }
+
+  void AcceleratedRate()
+  {
+    const double session = (N-1)*PERIOD*1e-3;
+    const double duration = Replay(4.0);
+    CPPUNIT_ASSERT_MESSAGE("Replayed too fast", duration >= session/4.0 - 1.0);
+    CPPUNIT_ASSERT_MESSAGE("Not accelerated", duration < session/2.0);
+  }
+
+  void AsFastAsPossible()
+  {
+    const double session = (N-1)*PERIOD*1e-3;
+    CPPUNIT_ASSERT_MESSAGE("Timing kept", Replay(0.0) < session/4.0);
+
+    // a looped replay starts again from the first frame
+    ReplayTrackingSource source;
+    source.SetFileName(mFileName);
+    source.SetSpeed(0.0);
+    source.SetLoop(true);
+    CPPUNIT_ASSERT_MESSAGE("Recording could not be opened", source.Open() && source.StartStreaming());
+    TrackingFrame frame;
+    for (unsigned int i=0; i<N+1; i++)
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Looped frame", TrackingSource::NewFrame, source.WaitForFrame(frame,1000));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Loop restart", mFrames[0].timestamp, frame.timestamp);
+  }
+
+  void GeometryFilter()
+  {
+    // only the markers of the added geometries are replayed
+    ReplayTrackingSource source;
+    source.SetFileName(mFileName);
+    source.SetSpeed(0.0);
+    CPPUNIT_ASSERT_MESSAGE("Recording could not be opened", source.Open());
+    CPPUNIT_ASSERT_MESSAGE("Geometry not added", source.AddGeometry(123,""));
+    CPPUNIT_ASSERT_MESSAGE("Streaming not started", source.StartStreaming());
+
+    TrackingFrame frame;
+    for (unsigned int i=0; i<N; i++)
+    {
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Frame missing", TrackingSource::NewFrame, source.WaitForFrame(frame,1000));
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Frames without the geometry are kept", mFrames[i].timestamp, frame.timestamp);
+      CPPUNIT_ASSERT_EQUAL_MESSAGE("Filtered markers", (i%2 == 0) ? 1u : 0u, frame.markersCount);
+      if (frame.markersCount == 1)
+        CPPUNIT_ASSERT_EQUAL_MESSAGE("Probe kept", 123u, frame.markers[0].geometryId);
+    }
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(ReplayTrackingSource)
@@ -0,0 +1,184 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <cmath>
+#include <vector>
+// qt include
+#include <QDir>
+#include <QFile>
+// Module includes
+#include "TrackingLog.h"
+
+class TrackingLogTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(TrackingLogTestSuite);
+  MITK_TEST(RoundTrip);
+  MITK_TEST(Seek);
+  MITK_TEST(InterruptedLog);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  std::vector<TrackingFrame> mFrames;
+  std::string mFileName;
+
+  // frames of a 60 Hz session: a reference and a probe moving in and out of view
+  void CreateFrames(unsigned int n)
+  {
+    mFrames.resize(n);
+    for (unsigned int i=0; i<n; i++)
+    {
+      TrackingFrame& frame = mFrames[i];
+      frame.timestamp = 5000000 + 16667*i;
+      frame.markersOverflow = false;
+      frame.fiducialsValid = true;
+      frame.markersCount = (i%10 < 7) ? 2 : 1;
+
+      for (unsigned int m=0; m<frame.markersCount; m++)
+      {
+        TrackingMarker& marker = frame.markers[m];
+        marker.geometryId = (m == 0) ? 4 : 123;
+
+        const double angle = 0.01*i*(m+1);
+        double rotation[3][3] = {{std::cos(angle),-std::sin(angle),0.0},{std::sin(angle),std::cos(angle),0.0},{0.0,0.0,1.0}};
+        for (unsigned int r=0; r<3; r++)
+        {
+          for (unsigned int c=0; c<3; c++)
+            marker.rotation[r][c] = rotation[r][c];
+          marker.translationMM[r] = 100.0*(m+1) + 0.05*i + 10.0*r;
+        }
+        marker.registrationErrorMM = 0.08;
+
+        for (unsigned int f=0; f<TRACKING_MAX_MARKER_FIDUCIALS; f++)
+          marker.fiducialCorresp[f] = (f < 4) ? 4*m+f : TRACKING_INVALID_ID;
+      }
+
+      frame.fiducialsCount = 4*frame.markersCount;
+      for (unsigned int f=0; f<frame.fiducialsCount; f++)
+      {
+        for (unsigned int c=0; c<3; c++)
+          frame.fiducials[f].positionMM[c] = 50.0*f + 0.05*i + c;
+        frame.fiducials[f].probability = 1.0;
+      }
+    }
+  }
+
+  bool WriteLog(uint32_t keyFrameInterval)
+  {
+    TrackingLogWriter writer;
+    if (!writer.Open(mFileName,keyFrameInterval))
+      return false;
+
+    for (const TrackingFrame& frame : mFrames)
+      if (!writer.Write(frame))
+        return false;
+
+    return writer.Close();
+  }
+
+  // values are stored with 1 um / 1e-7 resolution
+  bool Equal(const TrackingFrame& a, const TrackingFrame& b)
+  {
+    if ((a.timestamp != b.timestamp) || (a.markersCount != b.markersCount) || (a.fiducialsCount != b.fiducialsCount) ||
+        (a.markersOverflow != b.markersOverflow) || (a.fiducialsValid != b.fiducialsValid))
+      return false;
+
+    for (unsigned int m=0; m<a.markersCount; m++)
+    {
+      if (a.markers[m].geometryId != b.markers[m].geometryId)
+        return false;
+      for (unsigned int r=0; r<3; r++)
+      {
+        if (std::abs(a.markers[m].translationMM[r] - b.markers[m].translationMM[r]) > 1e-3)
+          return false;
+        for (unsigned int c=0; c<3; c++)
+          if (std::abs(a.markers[m].rotation[r][c] - b.markers[m].rotation[r][c]) > 1e-7)
+            return false;
+      }
+      for (unsigned int f=0; f<TRACKING_MAX_MARKER_FIDUCIALS; f++)
+        if (a.markers[m].fiducialCorresp[f] != b.markers[m].fiducialCorresp[f])
+          return false;
+    }
+
+    for (unsigned int f=0; f<a.fiducialsCount; f++)
+      for (unsigned int c=0; c<3; c++)
+        if (std::abs(a.fiducials[f].positionMM[c] - b.fiducials[f].positionMM[c]) > 1e-3)
+          return false;
+
+    return true;
+  }
+
+public:
+  void setUp() override
+  {
+    mFileName = QDir::temp().filePath("TrackingLogTest.navlog").toStdString();
+    CreateFrames(1000);
+  }
+
+  void tearDown() override
+  {
+    QFile::remove(QString::fromStdString(mFileName));
+    mFrames.clear();
+  }
+
+  void RoundTrip()
+  {
+    CPPUNIT_ASSERT_MESSAGE("Log could not be written", WriteLog(64));
+    CPPUNIT_ASSERT_MESSAGE("Log magic not detected", TrackingLogReader::IsTrackingLog(mFileName));
+
+    TrackingLogReader reader;
+    CPPUNIT_ASSERT_MESSAGE("Log could not be opened", reader.Open(mFileName));
+    CPPUNIT_ASSERT_MESSAGE("Wrong number of frames", reader.GetNumberOfFrames() == mFrames.size());
+    CPPUNIT_ASSERT_MESSAGE("Wrong last timestamp", reader.GetLastTimestamp() == mFrames.back().timestamp);
+
+    TrackingFrame frame;
+    for (const TrackingFrame& expected : mFrames)
+    {
+      CPPUNIT_ASSERT_MESSAGE("Frame missing", reader.ReadNext(frame));
+      CPPUNIT_ASSERT_MESSAGE("Decoded frame differs", Equal(frame,expected));
+    }
+    CPPUNIT_ASSERT_MESSAGE("Read past the end", !reader.ReadNext(frame));
+  }
+
+  void Seek()
+  {
+    CPPUNIT_ASSERT_MESSAGE("Log could not be written", WriteLog(64));
+
+    TrackingLogReader reader;
+    CPPUNIT_ASSERT_MESSAGE("Log could not be opened", reader.Open(mFileName));
+
+    TrackingFrame frame;
+    CPPUNIT_ASSERT_MESSAGE("Seek failed", reader.Seek(517) && (reader.Tell() == 517));
+    CPPUNIT_ASSERT_MESSAGE("Wrong frame after seek", reader.ReadNext(frame) && Equal(frame,mFrames[517]));
+
+    CPPUNIT_ASSERT_MESSAGE("Seek to timestamp failed", reader.SeekToTimestamp(mFrames[700].timestamp - 1));
+    CPPUNIT_ASSERT_MESSAGE("Wrong frame after seek to timestamp", reader.ReadNext(frame) && Equal(frame,mFrames[700]));
+
+    CPPUNIT_ASSERT_MESSAGE("Seek past the end succeeded", !reader.Seek(mFrames.size()+1));
+  }
+
+  void InterruptedLog()
+  {
+    CPPUNIT_ASSERT_MESSAGE("Log could not be written", WriteLog(64));
+
+    // remove index and trailer, as in a session that was never closed
+    QFile file(QString::fromStdString(mFileName));
+    const qint64 records = file.size() - 40 - 24*static_cast<qint64>((mFrames.size()+63)/64);
+    CPPUNIT_ASSERT_MESSAGE("Log could not be truncated", file.resize(records));
+
+    TrackingLogReader reader;
+    CPPUNIT_ASSERT_MESSAGE("Interrupted log could not be opened", reader.Open(mFileName));
+    CPPUNIT_ASSERT_MESSAGE("Frames lost in interrupted log", reader.GetNumberOfFrames() == mFrames.size());
+    CPPUNIT_ASSERT_MESSAGE("Seek failed in interrupted log", reader.Seek(999) && (reader.Tell() == 999));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(TrackingLog)
@@ -0,0 +1,9 @@
+set(MODULE_TESTS
+  TrackingLogTest.cpp
+  RelativePoseKernelTest.cpp
+  PoseFilterTest.cpp
+  RawFramesTest.cpp
+  ReplayTrackingSourceTest.cpp
+)
+SET(MODULE_CUSTOM_TESTS
+)
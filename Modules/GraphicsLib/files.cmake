@@ -10,6 +10,8 @@ set(CPP_FILES
 	ViewCommands.cpp
 	SurfaceAdaptation.cpp
 	RegistrationErrorVisualization.cpp
+	RenderScheduler.cpp
+	LevelOfDetailSwitcher.cpp
 )
 
 set(RESOURCE_FILES
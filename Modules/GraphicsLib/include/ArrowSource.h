@@ -12,6 +12,7 @@ navCAS navigation system
 #include <mitkDataNode.h>
 
 #include <vtkArrowSource.h>
+#include <vtkMatrix4x4.h>
 #include <vtkPolyData.h>
 #include <vtkSmartPointer.h>
 #include <GraphicsLibExports.h>
@@ -27,8 +28,8 @@ public:
   ArrowSource(double *normal, double *center, double length, double radius=2.5);
   ~ArrowSource() override;
 
-  void SetNormal(double *normal);
-  void SetCenter(double *center);
+  void SetNormal(const double *normal);
+  void SetCenter(const double *center);
 
   // to do
   //void SetRadius(double radius);
@@ -38,6 +39,13 @@ public:
 
   vtkSmartPointer<vtkPolyData> GetOutput();
 
+  /// arrow along +x starting at the origin, not affected by normal and center
+  vtkSmartPointer<vtkPolyData> GetLocalOutput();
+
+  /// rigid transform that moves the local output to the current normal and center (GetOutput
+  /// without regenerating the polydata)
+  void GetPoseMatrix(vtkMatrix4x4* matrix) const;
+
 protected:
 
   vtkSmartPointer<vtkPolyData>      mOutput;
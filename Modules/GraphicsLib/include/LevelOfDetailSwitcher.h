@@ -0,0 +1,105 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef LEVEL_OF_DETAIL_SWITCHER_H
+#define LEVEL_OF_DETAIL_SWITCHER_H
+
+#include <vector>
+
+#include <mitkBaseRenderer.h>
+#include <mitkDataStorage.h>
+
+#include <vtkMatrix4x4.h>
+
+#include <RigidTransform.h>
+
+#include <GraphicsLibExports.h>
+
+/**
+  \class LevelOfDetailSwitcher
+
+  Shows the low resolution child of the surfaces (see SurfaceAdaptation) in one renderer, usually
+  the 3D view, while the tracked tools move, and restores the full resolution once they have been
+  still for the dwell time. Only the properties of the nodes in that renderer are changed (the
+  visibility, and the color and opacity of the child), and restored as they were: the global
+  properties and the other renderers are not touched.
+*/
+class GraphicsLib_EXPORT LevelOfDetailSwitcher
+{
+public:
+  LevelOfDetailSwitcher();
+  ~LevelOfDetailSwitcher();
+
+  void SetDataStorage(mitk::DataStorage::Pointer ds);
+
+  /// renderer where the resolution is switched, the full resolution is restored in the previous one
+  void SetRenderer(mitk::BaseRenderer* renderer);
+  inline mitk::BaseRenderer* GetRenderer() const {return mRenderer;}
+
+  /// switching is enabled by default, disabling it restores the full resolution on the next Update
+  inline void SetEnabled(bool enabled){mEnabled = enabled;}
+
+  /// time without motion before the full resolution is restored, in s (0.5 s by default)
+  inline void SetDwellTime(double s){mDwellTime = s;}
+
+  /// displacement of a tool from its last still pose that counts as motion (1 mm and 1 deg by default)
+  void SetMotionThreshold(double mm, double deg);
+
+  /*  Reports the pose of a tool at time (s, any monotonic clock). Tracking jitter below the
+      motion threshold is ignored. Returns true if the tool moved.*/
+  bool AddPose(unsigned int tool, const vtkMatrix4x4* pose, double time);
+
+  /*  Switches to the resolution required by the last motion. Returns true if the renderer
+      changed and has to be updated.*/
+  bool Update(double time);
+
+  /// restores the full resolution and forgets the tool poses, returns true if the renderer changed
+  bool Restore();
+
+  /// forgets the switched nodes without restoring them (e.g. the renderer was destroyed)
+  void Clear();
+
+  inline bool IsLowResolution() const {return mLowResolution;}
+
+private:
+  /// copy of a property set for the renderer only, nullptr if the node uses its global property
+  typedef mitk::BaseProperty::Pointer RendererProperty;
+
+  struct Switch
+  {
+    mitk::DataNode::Pointer   parent;
+    mitk::DataNode::Pointer   child;
+    RendererProperty          parentVisibility;
+    RendererProperty          childVisibility;
+    RendererProperty          childColor;
+    RendererProperty          childOpacity;
+  };
+
+  bool SwitchToLowResolution();
+
+  RendererProperty GetRendererProperty(mitk::DataNode* node, const char* name) const;
+  void RestoreRendererProperty(mitk::DataNode* node, const char* name, const RendererProperty& property) const;
+
+  mitk::DataStorage::Pointer    mDataStorage;
+  mitk::BaseRenderer*           mRenderer;
+  bool                          mEnabled;
+  double                        mDwellTime;           // s
+  double                        mTranslationThreshold; // mm
+  double                        mRotationThreshold;    // rad
+
+  // last still pose of every tool
+  std::vector<RigidTransform>   mStillPose;
+  std::vector<bool>             mHasPose;
+
+  bool                          mMoving;
+  double                        mLastMotionTime;
+  bool                          mLowResolution;
+  std::vector<Switch>           mSwitches;
+};
+
+#endif // LEVEL_OF_DETAIL_SWITCHER_H
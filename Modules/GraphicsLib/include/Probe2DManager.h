@@ -19,6 +19,7 @@ navCAS navigation system
 
 #include "Probe2D.h"
 
+class RenderScheduler;
 
 class GraphicsLib_EXPORT Probe2DManager : public itk::LightObject
 {
@@ -29,24 +30,41 @@ public:
   Probe2DManager(QmitkRenderWindow* renderWindow);
   virtual ~Probe2DManager();
 
-  void UpdatePosition(mitk::Point2D center, mitk::Vector2D dir);
+  /// moves the overlays (display units), returns false if the change is below the pixel threshold
+  bool UpdatePosition(mitk::Point2D center, mitk::Vector2D dir);
   void ShowControls(bool val);
   void ShowCircle(bool val);
   void HighlightOn(bool val);
   QmitkRenderWindow* GetAssociatedRenderWindow() { return mRenderWindow; }
 
-  inline void SetRenderWindow(QmitkRenderWindow* rw){mRenderWindow = rw;}
+  /// movements of the tip or direction smaller than this (pixels) are not rendered (0.5 by default)
+  inline void SetPixelThreshold(double pixels){mPixelThreshold = pixels;}
+
+  inline void SetRenderWindow(QmitkRenderWindow* rw){mRenderWindow = rw; mHasPosition = false;}
   inline QmitkRenderWindow* GetRenderWindow() const {return mRenderWindow;}
 
+  /// renders are requested through the scheduler while navigating, directly if nullptr (default)
+  inline void SetRenderScheduler(RenderScheduler* scheduler){mRenderScheduler = scheduler;}
+
 protected:
 
 private:
 
   void Update();
+  void RequestRender(mitk::BaseRenderer* renderer);
 
   Probe2D::Pointer                      mRotationOverlay;
   mitk::TextAnnotation2D::Pointer       mTranslationOverlay;
   QmitkRenderWindow*                    mRenderWindow;
+  RenderScheduler*                      mRenderScheduler;
+
+  // last rendered overlay geometry, to skip updates that would not change the screen
+  double                                mPixelThreshold;
+  bool                                  mHasPosition;
+  mitk::Point2D                         mLastCenter;
+  mitk::Vector2D                        mLastDirection;
+  int                                   mLastRadius;
+  bool                                  mCircleVisible;
 };
 
 #endif // PROBE2D_MANAGER_H
@@ -0,0 +1,72 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef RENDER_SCHEDULER_H
+#define RENDER_SCHEDULER_H
+
+#include <vector>
+
+#include <mitkDataNode.h>
+
+#include <vtkRenderWindow.h>
+
+#include <GraphicsLibExports.h>
+
+/**
+  \class RenderScheduler
+
+  Collects the scene changes of one display refresh (moved nodes, crosshair position) and turns
+  them into a single update request per render window on Flush. Only the windows in which a
+  changed node is visible are updated, so unchanged 2D windows are not resliced. Without
+  render windows every change falls back to updating all windows.
+*/
+class GraphicsLib_EXPORT RenderScheduler
+{
+public:
+  RenderScheduler();
+
+  /// windows whose updates are scheduled (e.g. axial, coronal, sagittal, 3D); empty to update all
+  void SetRenderWindows(const std::vector<vtkRenderWindow*>& windows);
+
+  /// the data of the node changed (e.g. its pose)
+  void NodeChanged(const mitk::DataNode* node);
+
+  /// the content of the window changed outside the datastorage (e.g. overlays)
+  void WindowChanged(vtkRenderWindow* window);
+
+  /*  Schedules a crosshair move. Moves smaller than the crosshair tolerance from the last applied
+      position are ignored, as they would reslice every 2D window without a visible change.*/
+  void SetSelectedPosition(const mitk::Point3D& position);
+
+  /// distance in mm below which the crosshair is not moved (0.1 mm by default)
+  inline void SetCrosshairTolerance(double mm){mCrosshairTolerance = mm;}
+
+  /*  Returns true and the position if the crosshair has to be moved in this refresh. The
+      position is then considered applied.*/
+  bool TakeSelectedPosition(mitk::Point3D& position);
+
+  /// requests the updates collected since the last flush, returns the number of updated windows
+  unsigned int Flush();
+
+  /// forgets the pending changes and the last crosshair position
+  void Reset();
+
+private:
+  std::vector<vtkRenderWindow*>         mWindows;
+  std::vector<bool>                     mWindowChanged;
+  std::vector<const mitk::DataNode*>    mChangedNodes;
+  bool                                  mUpdateAll;
+
+  double                                mCrosshairTolerance;
+  bool                                  mHasCrosshair;
+  bool                                  mCrosshairPending;
+  mitk::Point3D                         mCrosshairPosition;
+  mitk::Point3D                         mAppliedCrosshairPosition;
+};
+
+#endif // RENDER_SCHEDULER_H
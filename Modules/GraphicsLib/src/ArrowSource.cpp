@@ -39,13 +39,13 @@ ArrowSource::~ArrowSource()
   cout << "ArrowSource destructor" << std::endl;
 }
 
-void ArrowSource::SetNormal(double* normal)
+void ArrowSource::SetNormal(const double* normal)
 {
   for (unsigned int i=0; i<3; i++)
     mNormal[i] = normal[i];
 }
 
-void ArrowSource::SetCenter(double* center)
+void ArrowSource::SetCenter(const double* center)
 {
   for (unsigned int i=0; i<3; i++)
     mCenter[i] = center[i];
@@ -86,3 +86,33 @@ vtkSmartPointer<vtkPolyData> ArrowSource::GetOutput()
 {
   return mOutput;
 }
+
+vtkSmartPointer<vtkPolyData> ArrowSource::GetLocalOutput()
+{
+  return mOriginalArrow;
+}
+
+void ArrowSource::GetPoseMatrix(vtkMatrix4x4* matrix) const
+{
+  // same rotation as Update: +x onto the normal, around their cross product (Rodrigues)
+  double pn[3] = {1.0, 0.0, 0.0};
+  double axis[3];
+  vtkMath::Cross(pn,mNormal,axis);
+  double angle = atan2(vtkMath::Norm(axis),vtkMath::Dot(pn,mNormal));
+
+  matrix->Identity();
+  if (vtkMath::Normalize(axis) > 0.0)
+  {
+    const double c = cos(angle);
+    const double s = sin(angle);
+    const double t = 1.0 - c;
+    const double x = axis[0], y = axis[1], z = axis[2];
+
+    matrix->SetElement(0,0,t*x*x + c);    matrix->SetElement(0,1,t*x*y - s*z);  matrix->SetElement(0,2,t*x*z + s*y);
+    matrix->SetElement(1,0,t*x*y + s*z);  matrix->SetElement(1,1,t*y*y + c);    matrix->SetElement(1,2,t*y*z - s*x);
+    matrix->SetElement(2,0,t*x*z - s*y);  matrix->SetElement(2,1,t*y*z + s*x);  matrix->SetElement(2,2,t*z*z + c);
+  }
+
+  for (unsigned int i=0; i<3; i++)
+    matrix->SetElement(i,3,mCenter[i]);
+}
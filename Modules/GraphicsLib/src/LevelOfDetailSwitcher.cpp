@@ -0,0 +1,187 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <mitkNodePredicateDataType.h>
+#include <mitkProperties.h>
+
+#include <vtkMath.h>
+
+#include <RigidTransformVtk.h>
+
+#include "LevelOfDetailSwitcher.h"
+#include "SurfaceAdaptation.h"
+
+LevelOfDetailSwitcher::LevelOfDetailSwitcher() :
+  mRenderer(nullptr),
+  mEnabled(true),
+  mDwellTime(0.5),
+  mTranslationThreshold(1.0),
+  mRotationThreshold(vtkMath::RadiansFromDegrees(1.0)),
+  mMoving(false),
+  mLastMotionTime(0.0),
+  mLowResolution(false)
+{
+}
+
+LevelOfDetailSwitcher::~LevelOfDetailSwitcher()
+{
+  Restore();
+}
+
+void LevelOfDetailSwitcher::SetDataStorage(mitk::DataStorage::Pointer ds)
+{
+  Restore();
+  mDataStorage = ds;
+}
+
+void LevelOfDetailSwitcher::SetRenderer(mitk::BaseRenderer* renderer)
+{
+  if (renderer == mRenderer)
+    return;
+
+  Restore();
+  mRenderer = renderer;
+}
+
+void LevelOfDetailSwitcher::SetMotionThreshold(double mm, double deg)
+{
+  mTranslationThreshold = mm;
+  mRotationThreshold = vtkMath::RadiansFromDegrees(deg);
+}
+
+bool LevelOfDetailSwitcher::AddPose(unsigned int tool, const vtkMatrix4x4* pose, double time)
+{
+  if (tool >= mStillPose.size())
+  {
+    mStillPose.resize(tool+1,RigidTransform::Identity());
+    mHasPose.resize(tool+1,false);
+  }
+
+  const RigidTransform current = RigidTransformFromVtk(pose);
+
+  // a tool that appears is not moving yet
+  if (!mHasPose[tool])
+  {
+    mStillPose[tool] = current;
+    mHasPose[tool] = true;
+    return false;
+  }
+
+  // compared with the last still pose, so that a slow drift is eventually detected
+  const RigidTransform displacement = mStillPose[tool].Inverse() * current;
+  if ((displacement.GetTranslationNorm() < mTranslationThreshold) && (displacement.GetRotationAngle() < mRotationThreshold))
+    return false;
+
+  mStillPose[tool] = current;
+  mMoving = true;
+  mLastMotionTime = time;
+  return true;
+}
+
+bool LevelOfDetailSwitcher::Update(double time)
+{
+  if (!mEnabled || (mRenderer == nullptr) || mDataStorage.IsNull())
+    return mLowResolution ? Restore() : false;
+
+  if (mMoving && ((time - mLastMotionTime) >= mDwellTime))
+    mMoving = false;
+
+  if (mMoving && !mLowResolution)
+    return SwitchToLowResolution();
+
+  if (!mMoving && mLowResolution)
+    return Restore();
+
+  return false;
+}
+
+bool LevelOfDetailSwitcher::Restore()
+{
+  mHasPose.assign(mHasPose.size(),false);
+  mMoving = false;
+
+  if (!mLowResolution)
+    return false;
+
+  for (const Switch& s : mSwitches)
+  {
+    RestoreRendererProperty(s.parent,"visible",s.parentVisibility);
+    RestoreRendererProperty(s.child,"visible",s.childVisibility);
+    RestoreRendererProperty(s.child,"color",s.childColor);
+    RestoreRendererProperty(s.child,"opacity",s.childOpacity);
+  }
+
+  const bool changed = !mSwitches.empty();
+  mSwitches.clear();
+  mLowResolution = false;
+  return changed;
+}
+
+void LevelOfDetailSwitcher::Clear()
+{
+  mHasPose.assign(mHasPose.size(),false);
+  mMoving = false;
+  mSwitches.clear();
+  mLowResolution = false;
+}
+
+bool LevelOfDetailSwitcher::SwitchToLowResolution()
+{
+  // queried once per motion, the surfaces shown may have changed since the last one
+  mitk::DataStorage::SetOfObjects::ConstPointer surfaces = mDataStorage->GetSubset(mitk::NodePredicateDataType::New("Surface"));
+  for (auto it = surfaces->Begin(); it != surfaces->End(); ++it)
+  {
+    mitk::DataNode::Pointer parent = it->Value();
+    if ((parent->GetName() == SurfaceAdaptation::name) || !parent->IsVisible(mRenderer))
+      continue;
+
+    // small surfaces share their data with the child, nothing to gain
+    mitk::DataNode::Pointer child = SurfaceAdaptation::GetLowResolutionNode(mDataStorage,parent);
+    if (child.IsNull() || (child->GetData() == parent->GetData()))
+      continue;
+
+    Switch s;
+    s.parent = parent;
+    s.child = child;
+    s.parentVisibility = GetRendererProperty(parent,"visible");
+    s.childVisibility = GetRendererProperty(child,"visible");
+    s.childColor = GetRendererProperty(child,"color");
+    s.childOpacity = GetRendererProperty(child,"opacity");
+    mSwitches.push_back(s);
+
+    // the child looks like its parent in this renderer
+    float color[3];
+    if (parent->GetColor(color,mRenderer))
+      child->SetColor(color,mRenderer);
+    float opacity = 1.0f;
+    if (parent->GetOpacity(opacity,mRenderer))
+      child->SetOpacity(opacity,mRenderer);
+
+    parent->SetVisibility(false,mRenderer);
+    child->SetVisibility(true,mRenderer);
+  }
+
+  mLowResolution = true;
+  return !mSwitches.empty();
+}
+
+LevelOfDetailSwitcher::RendererProperty LevelOfDetailSwitcher::GetRendererProperty(mitk::DataNode* node, const char* name) const
+{
+  // a copy: setting a property of the same type assigns the existing one
+  mitk::BaseProperty* property = node->GetPropertyList(mRenderer)->GetProperty(name);
+  return (property != nullptr) ? property->Clone() : nullptr;
+}
+
+void LevelOfDetailSwitcher::RestoreRendererProperty(mitk::DataNode* node, const char* name, const RendererProperty& property) const
+{
+  // without a renderer property the node follows its global property again
+  if (property.IsNotNull())
+    node->GetPropertyList(mRenderer)->SetProperty(name,property);
+  else
+    node->GetPropertyList(mRenderer)->DeleteProperty(name);
+}
@@ -47,6 +47,10 @@ Probe2D::Probe2D()
 
 void Probe2D::SetRadius(int radius)
 {
+  // the circle is only rebuilt if its size changed
+  if (m_circle->GetRadius() == radius)
+    return;
+
   m_circle->SetRadius(radius);
   m_circle->Update();
 }
@@ -55,6 +59,10 @@ void Probe2D::SetRadius(int radius)
 void Probe2D::SetDirection(mitk::Vector2D dir)
 {
   // display units
+  const double* end = m_line->GetPoint2();
+  if ((end[0] == dir[0]) && (end[1] == dir[1]))
+    return;
+
   m_line->SetPoint2(dir[0],dir[1],0);
 }
 
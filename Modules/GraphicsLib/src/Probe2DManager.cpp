@@ -14,13 +14,20 @@ navCAS navigation system
 #include <QmitkRenderWindow.h>
 
 #include "Probe2DManager.h"
+#include "RenderScheduler.h"
 
 #include <vtkImageCanvasSource2D.h>
 #include "Probe2D.h"
 
 using namespace mitk;
 
-Probe2DManager::Probe2DManager(QmitkRenderWindow* renderWindow) : mRenderWindow(renderWindow)
+Probe2DManager::Probe2DManager(QmitkRenderWindow* renderWindow) :
+  mRenderWindow(renderWindow),
+  mRenderScheduler(nullptr),
+  mPixelThreshold(0.5),
+  mHasPosition(false),
+  mLastRadius(0),
+  mCircleVisible(false)
 {
   if (renderWindow == nullptr)
   {
@@ -57,14 +64,28 @@ Probe2DManager::~Probe2DManager()
   std::cout << "Probe 2D manager destructor" << std::endl;
 }
 
-void Probe2DManager::UpdatePosition(mitk::Point2D center, mitk::Vector2D dir)
+bool Probe2DManager::UpdatePosition(mitk::Point2D center, mitk::Vector2D dir)
 {
   if (mRenderWindow == nullptr)
   {
     cout << "Render window is null in Probe2DManager::UpdatePosition()" << std::endl;
-    return;
+    return false;
   }
 
+  int* windowSize = mRenderWindow->GetVtkRenderWindow()->GetSize();
+  int radius = windowSize[0]<windowSize[1] ? windowSize[0]/8 : windowSize[1]/8;
+
+  // sub-pixel movements are not visible: nothing to rebuild nor render
+  if (mHasPosition && (radius == mLastRadius) &&
+      (center.EuclideanDistanceTo(mLastCenter) < mPixelThreshold) &&
+      ((dir - mLastDirection).GetNorm() < mPixelThreshold))
+    return false;
+
+  mHasPosition = true;
+  mLastCenter = center;
+  mLastDirection = dir;
+  mLastRadius = radius;
+
  // Move all the controls in a coherent way
   mitk::BaseRenderer* renderer = mitk::BaseRenderer::GetInstance(mRenderWindow->GetVtkRenderWindow());
   mitk::Point2D newCenter;
@@ -75,7 +96,6 @@ void Probe2DManager::UpdatePosition(mitk::Point2D center, mitk::Vector2D dir)
   mTranslationOverlay->SetPosition2D(newCenter);
 
 
-  int* windowSize = mRenderWindow->GetVtkRenderWindow()->GetSize();
   int signs[2] = { -1, 1 };
   for (int i = 0; i < 2; i++)
   {
@@ -84,14 +104,13 @@ void Probe2DManager::UpdatePosition(mitk::Point2D center, mitk::Vector2D dir)
   }
 
 
-  //int radius;
-  int radius = windowSize[0]<windowSize[1] ? windowSize[0]/8 : windowSize[1]/8;
   mRotationOverlay->SetPosition2D(center);
   //mRotationOverlay->SetCenter(center);
   mRotationOverlay->SetDirection(dir);
   mRotationOverlay->SetRadius(radius);
 
-  renderer->RequestUpdate();
+  RequestRender(renderer);
+  return true;
 }
 
 void Probe2DManager::ShowControls(bool val)
@@ -102,6 +121,11 @@ void Probe2DManager::ShowControls(bool val)
 
 void Probe2DManager::ShowCircle(bool val)
 {
+  // called for every probe frame
+  if (val == mCircleVisible)
+    return;
+
+  mCircleVisible = val;
   mRotationOverlay->SetVisibility(val);
 
   Update();
@@ -131,4 +155,14 @@ void Probe2DManager::Update()
 
   mitk::BaseRenderer* renderer = mitk::BaseRenderer::GetInstance(mRenderWindow->GetVtkRenderWindow());
   mTranslationOverlay->Update(renderer);
+  RequestRender(renderer);
+}
+
+void Probe2DManager::RequestRender(mitk::BaseRenderer* renderer)
+{
+  // the window is rendered with the rest of the navigation update
+  if (mRenderScheduler != nullptr)
+    mRenderScheduler->WindowChanged(renderer->GetRenderWindow());
+  else
+    renderer->RequestUpdate();
 }
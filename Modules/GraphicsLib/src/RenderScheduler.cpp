@@ -0,0 +1,123 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <algorithm>
+
+#include <mitkBaseRenderer.h>
+#include <mitkRenderingManager.h>
+
+#include "RenderScheduler.h"
+
+RenderScheduler::RenderScheduler() :
+  mUpdateAll(false),
+  mCrosshairTolerance(0.1),
+  mHasCrosshair(false),
+  mCrosshairPending(false)
+{
+  mCrosshairPosition.Fill(0.0);
+  mAppliedCrosshairPosition.Fill(0.0);
+}
+
+void RenderScheduler::SetRenderWindows(const std::vector<vtkRenderWindow*>& windows)
+{
+  mWindows = windows;
+  mWindowChanged.assign(mWindows.size(),false);
+
+  // the new windows have not been drawn with the pending changes
+  mUpdateAll = true;
+}
+
+void RenderScheduler::NodeChanged(const mitk::DataNode* node)
+{
+  if ((node == nullptr) || (std::find(mChangedNodes.begin(),mChangedNodes.end(),node) != mChangedNodes.end()))
+    return;
+
+  mChangedNodes.push_back(node);
+}
+
+void RenderScheduler::WindowChanged(vtkRenderWindow* window)
+{
+  auto it = std::find(mWindows.begin(),mWindows.end(),window);
+  if (it == mWindows.end())
+  {
+    mUpdateAll = true;
+    return;
+  }
+
+  mWindowChanged[it - mWindows.begin()] = true;
+}
+
+void RenderScheduler::SetSelectedPosition(const mitk::Point3D& position)
+{
+  mCrosshairPosition = position;
+  mCrosshairPending = !mHasCrosshair || (position.EuclideanDistanceTo(mAppliedCrosshairPosition) >= mCrosshairTolerance);
+}
+
+bool RenderScheduler::TakeSelectedPosition(mitk::Point3D& position)
+{
+  if (!mCrosshairPending)
+    return false;
+
+  position = mCrosshairPosition;
+  mAppliedCrosshairPosition = mCrosshairPosition;
+  mHasCrosshair = true;
+  mCrosshairPending = false;
+  return true;
+}
+
+unsigned int RenderScheduler::Flush()
+{
+  mitk::RenderingManager* renderingManager = mitk::RenderingManager::GetInstance();
+
+  if (mWindows.empty() || mUpdateAll)
+  {
+    const bool changed = mUpdateAll || !mChangedNodes.empty();
+    mChangedNodes.clear();
+    mWindowChanged.assign(mWindows.size(),false);
+    mUpdateAll = false;
+
+    if (!changed)
+      return 0;
+
+    renderingManager->RequestUpdateAll();
+    return mWindows.empty() ? 1 : mWindows.size();
+  }
+
+  // a changed node is only redrawn by the windows where it is visible
+  for (const mitk::DataNode* node : mChangedNodes)
+  {
+    for (unsigned int w=0; w<mWindows.size(); w++)
+    {
+      if (!mWindowChanged[w] && node->IsVisible(mitk::BaseRenderer::GetInstance(mWindows[w])))
+        mWindowChanged[w] = true;
+    }
+  }
+  mChangedNodes.clear();
+
+  unsigned int updated = 0;
+  for (unsigned int w=0; w<mWindows.size(); w++)
+  {
+    if (!mWindowChanged[w])
+      continue;
+
+    renderingManager->RequestUpdate(mWindows[w]);
+    mWindowChanged[w] = false;
+    updated++;
+  }
+
+  return updated;
+}
+
+void RenderScheduler::Reset()
+{
+  mChangedNodes.clear();
+  mWindowChanged.assign(mWindows.size(),false);
+  mUpdateAll = false;
+  mHasCrosshair = false;
+  mCrosshairPending = false;
+}
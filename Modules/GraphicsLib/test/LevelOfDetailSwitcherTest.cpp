@@ -0,0 +1,143 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// MITK includes
+#include <mitkRenderWindow.h>
+#include <mitkStandaloneDataStorage.h>
+#include <mitkSurface.h>
+#include <QmitkRegisterClasses.h>
+// VTK includes
+#include <vtkSmartPointer.h>
+#include <vtkMatrix4x4.h>
+// Module includes
+#include "LevelOfDetailSwitcher.h"
+#include "SurfaceAdaptation.h"
+
+class LevelOfDetailSwitcherTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(LevelOfDetailSwitcherTestSuite);
+  MITK_TEST(JitterIsNotMotion);
+  MITK_TEST(LowResolutionWhileMoving);
+  MITK_TEST(RestoreFollowsGlobalVisibility);
+  MITK_TEST(RestoreColorAndOpacity);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  LevelOfDetailSwitcher*          mSwitcher;
+  mitk::DataStorage::Pointer      mDs;
+  mitk::RenderWindow::Pointer     mThreeD;
+  mitk::DataNode::Pointer         mParent;
+  mitk::DataNode::Pointer         mChild;
+  vtkSmartPointer<vtkMatrix4x4>   mPose;
+
+public:
+  void setUp() override
+  {
+    // rendering manager factory
+    QmitkRegisterClasses();
+
+    mDs = mitk::StandaloneDataStorage::New().GetPointer();
+    mThreeD = mitk::RenderWindow::New(nullptr,"LevelOfDetailSwitcherTest 3D");
+
+    mParent = mitk::DataNode::New();
+    mParent->SetData(mitk::Surface::New());
+    mParent->SetName("skin");
+    mDs->Add(mParent);
+
+    // as attached by SurfaceAdaptation: hidden helper derived from the surface
+    mChild = mitk::DataNode::New();
+    mChild->SetData(mitk::Surface::New());
+    mChild->SetName(SurfaceAdaptation::name);
+    mChild->SetVisibility(false);
+    mDs->Add(mChild,mParent);
+
+    mSwitcher = new LevelOfDetailSwitcher;
+    mSwitcher->SetDataStorage(mDs);
+    mSwitcher->SetRenderer(mThreeD->GetRenderer());
+    mSwitcher->SetDwellTime(0.5);
+    mSwitcher->SetMotionThreshold(1.0,1.0);
+
+    mPose = vtkSmartPointer<vtkMatrix4x4>::New();
+    mSwitcher->AddPose(0,mPose,0.0);
+  }
+
+  void tearDown() override
+  {
+    delete mSwitcher;
+    mPose = nullptr;
+    mChild = nullptr;
+    mParent = nullptr;
+    mThreeD = nullptr;
+    mDs = nullptr;
+  }
+
+  void JitterIsNotMotion()
+  {
+    mPose->SetElement(0,3,0.2);
+    CPPUNIT_ASSERT_MESSAGE("Jitter is not motion", !mSwitcher->AddPose(0,mPose,0.1));
+    CPPUNIT_ASSERT_MESSAGE("Full resolution while still", !mSwitcher->Update(0.1) && !mSwitcher->IsLowResolution());
+  }
+
+  void LowResolutionWhileMoving()
+  {
+    mitk::BaseRenderer* renderer = mThreeD->GetRenderer();
+
+    mPose->SetElement(0,3,5.0);
+    CPPUNIT_ASSERT_MESSAGE("Motion detected", mSwitcher->AddPose(0,mPose,0.1));
+    CPPUNIT_ASSERT_MESSAGE("Switch requires a render", mSwitcher->Update(0.1));
+    CPPUNIT_ASSERT_MESSAGE("Low resolution shown", !mParent->IsVisible(renderer) && mChild->IsVisible(renderer));
+    CPPUNIT_ASSERT_MESSAGE("Other renderers untouched", mParent->IsVisible(nullptr) && !mChild->IsVisible(nullptr));
+
+    CPPUNIT_ASSERT_MESSAGE("Low resolution during the dwell time", !mSwitcher->Update(0.4) && mSwitcher->IsLowResolution());
+
+    CPPUNIT_ASSERT_MESSAGE("Restore requires a render", mSwitcher->Update(0.7));
+    CPPUNIT_ASSERT_MESSAGE("Full resolution shown", mParent->IsVisible(renderer) && !mChild->IsVisible(renderer));
+  }
+
+  void RestoreFollowsGlobalVisibility()
+  {
+    mPose->SetElement(1,3,5.0);
+    mSwitcher->AddPose(0,mPose,0.1);
+    mSwitcher->Update(0.1);
+    CPPUNIT_ASSERT_MESSAGE("Restored", mSwitcher->Restore());
+
+    // no renderer visibility is left behind
+    mParent->SetVisibility(false);
+    mChild->SetVisibility(true);
+    CPPUNIT_ASSERT_MESSAGE("Parent follows its global visibility", !mParent->IsVisible(mThreeD->GetRenderer()));
+    CPPUNIT_ASSERT_MESSAGE("Child follows its global visibility", mChild->IsVisible(mThreeD->GetRenderer()));
+  }
+
+  void RestoreColorAndOpacity()
+  {
+    mitk::BaseRenderer* renderer = mThreeD->GetRenderer();
+    mParent->SetColor(1.0f,0.5f,0.0f);
+    mParent->SetOpacity(0.6f);
+    mChild->SetOpacity(0.3f,renderer);
+
+    mPose->SetElement(2,3,5.0);
+    mSwitcher->AddPose(0,mPose,0.1);
+    mSwitcher->Update(0.1);
+
+    float color[3];
+    float opacity = 1.0f;
+    CPPUNIT_ASSERT_MESSAGE("Child looks like its parent", mChild->GetColor(color,renderer) && (color[1] == 0.5f));
+    CPPUNIT_ASSERT_MESSAGE("Child opacity of its parent", mChild->GetOpacity(opacity,renderer) && (opacity == 0.6f));
+
+    mSwitcher->Restore();
+
+    // the color was not set for the renderer, the opacity was
+    CPPUNIT_ASSERT_MESSAGE("Renderer color removed", mChild->GetPropertyList(renderer)->GetProperty("color") == nullptr);
+    CPPUNIT_ASSERT_MESSAGE("Renderer opacity restored", mChild->GetOpacity(opacity,renderer) && (opacity == 0.3f));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(LevelOfDetailSwitcher)
@@ -0,0 +1,107 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// MITK includes
+#include <mitkRenderWindow.h>
+#include <QmitkRegisterClasses.h>
+// Module includes
+#include "RenderScheduler.h"
+
+class RenderSchedulerTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(RenderSchedulerTestSuite);
+  MITK_TEST(NothingChanged);
+  MITK_TEST(OnlyWindowsShowingTheNode);
+  MITK_TEST(ChangesAreCoalesced);
+  MITK_TEST(CrosshairTolerance);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  RenderScheduler*                        mScheduler;
+  mitk::RenderWindow::Pointer             mAxial;
+  mitk::RenderWindow::Pointer             mThreeD;
+  mitk::DataNode::Pointer                 mNode;
+
+public:
+  void setUp() override
+  {
+    // rendering manager factory
+    QmitkRegisterClasses();
+
+    mAxial = mitk::RenderWindow::New(nullptr,"RenderSchedulerTest axial");
+    mThreeD = mitk::RenderWindow::New(nullptr,"RenderSchedulerTest 3D");
+    mNode = mitk::DataNode::New();
+
+    mScheduler = new RenderScheduler;
+    std::vector<vtkRenderWindow*> windows;
+    windows.push_back(mAxial->GetVtkRenderWindow());
+    windows.push_back(mThreeD->GetVtkRenderWindow());
+    mScheduler->SetRenderWindows(windows);
+
+    // new windows are drawn once
+    mScheduler->Flush();
+  }
+
+  void tearDown() override
+  {
+    delete mScheduler;
+    mNode = nullptr;
+    mAxial = nullptr;
+    mThreeD = nullptr;
+  }
+
+  void NothingChanged()
+  {
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("No change, no render", 0u, mScheduler->Flush());
+  }
+
+  void OnlyWindowsShowingTheNode()
+  {
+    mNode->SetVisibility(false,mAxial->GetRenderer());
+
+    mScheduler->NodeChanged(mNode);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Window hiding the node is not updated", 1u, mScheduler->Flush());
+
+    mScheduler->WindowChanged(mAxial->GetVtkRenderWindow());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Window with changed overlays is updated", 1u, mScheduler->Flush());
+  }
+
+  void ChangesAreCoalesced()
+  {
+    for (int i=0; i<3; i++)
+      mScheduler->NodeChanged(mNode);
+    mScheduler->WindowChanged(mThreeD->GetVtkRenderWindow());
+
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("One request per window", 2u, mScheduler->Flush());
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Requests are not repeated", 0u, mScheduler->Flush());
+  }
+
+  void CrosshairTolerance()
+  {
+    mitk::Point3D position;
+    position.Fill(10.0);
+
+    mitk::Point3D applied;
+    mScheduler->SetSelectedPosition(position);
+    CPPUNIT_ASSERT_MESSAGE("First position is applied", mScheduler->TakeSelectedPosition(applied) && (applied == position));
+
+    position[0] += 0.05;
+    mScheduler->SetSelectedPosition(position);
+    CPPUNIT_ASSERT_MESSAGE("Move below tolerance is skipped", !mScheduler->TakeSelectedPosition(applied));
+
+    position[0] += 0.1;
+    mScheduler->SetSelectedPosition(position);
+    CPPUNIT_ASSERT_MESSAGE("Move above tolerance is applied", mScheduler->TakeSelectedPosition(applied) && (applied == position));
+    CPPUNIT_ASSERT_MESSAGE("Position is applied once", !mScheduler->TakeSelectedPosition(applied));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(RenderScheduler)
@@ -1,4 +1,6 @@
 set(MODULE_TESTS
+  RenderSchedulerTest.cpp
+  LevelOfDetailSwitcherTest.cpp
   SurfaceAdaptationTest.cpp
 )
 SET(MODULE_CUSTOM_TESTS
@@ -61,6 +61,9 @@ public:
 
 	static QString GetSimulationPointsLastPath();
 
+  /// Tracking log for a new session, stored next to the current scene (empty if recording is disabled)
+  static QString GetNewTrackingLogPath();
+
 private:
   static void StoreCurrentPath(QString file, SeriesType type);
 };
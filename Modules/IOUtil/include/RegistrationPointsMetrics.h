@@ -51,6 +51,8 @@ public:
 
   enum MarkerType{NoData=0,FlatSmall,FlatMedium,FlatBig,SphereSmall,SphereMedium,SphereBieg};
   static void ExportMetricsToFile(const std::vector<RegistrationPointsMetrics> &metrics, const QString &filename);
+  /// appends the metrics to the table of the file, without dialogs or progress if not interactive (streaming)
+  static bool ExportMetricsToFile(const RegistrationPointsMetrics* metrics, size_t count, const QString &filename, bool interactive=false);
   static const QString GetCombinationsLastPath();
 
   // model A
@@ -15,6 +15,7 @@ navCAS navigation system
 #include <QFile>
 #include <QMessageBox>
 #include <QTextStream>
+#include <QDateTime>
 #include <QtSql>
 
 #include <vtkMatrix4x4.h>
@@ -402,3 +403,17 @@ QString IOCommands::GetSimulationPointsLastPath()
 
 	return path;
 }
+
+QString IOCommands::GetNewTrackingLogPath()
+{
+  QSettings settings("CAS", "navCAS");
+  if (!settings.value("Record tracking sessions", true).toBool())
+    return QString();
+
+  auto scenePath = GetCurrentPath();
+  if (scenePath.isEmpty())
+    return QString();
+
+  scenePath.chop(4);
+  return scenePath + "_tracking_" + QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss") + ".navlog";
+}
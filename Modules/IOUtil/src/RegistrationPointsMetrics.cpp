@@ -17,21 +17,30 @@ navCAS navigation system
 using namespace std;
 
 void RegistrationPointsMetrics::ExportMetricsToFile(const std::vector<RegistrationPointsMetrics> &vec, const QString &filename)
+{
+  ExportMetricsToFile(vec.data(),vec.size(),filename,true);
+}
+
+bool RegistrationPointsMetrics::ExportMetricsToFile(const RegistrationPointsMetrics* vec, size_t count, const QString &filename, bool interactive)
 {
   // write data to local database
 
-  // read PERSON table using SQL
-  QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE");
+  // own connection, so repeated exports reuse it instead of replacing the default one
+  const QString connectionName("RegistrationPointsMetrics");
+  QSqlDatabase db = QSqlDatabase::contains(connectionName) ? QSqlDatabase::database(connectionName,false) :
+                                                             QSqlDatabase::addDatabase("QSQLITE",connectionName);
   db.setDatabaseName(filename);
   if (!db.open())
   {
-    QMessageBox::critical(nullptr, QObject::tr("Cannot open database"),
-        QObject::tr("Unable to establish a database connection.\n"
-                    "This example needs SQLite support. Please read "
-                    "the Qt SQL driver documentation for information how "
-                    "to build it.\n\n"
-                    "Click Cancel to exit."), QMessageBox::Cancel);
-    return;
+    if (interactive)
+      QMessageBox::critical(nullptr, QObject::tr("Cannot open database"),
+          QObject::tr("Unable to establish a database connection.\n"
+                      "This example needs SQLite support. Please read "
+                      "the Qt SQL driver documentation for information how "
+                      "to build it.\n\n"
+                      "Click Cancel to exit."), QMessageBox::Cancel);
+    cout << "Cannot open database " << filename.toStdString() << std::endl;
+    return false;
   }
 
   QString tableName("REGISTRATION_POINTS_COMBINATIONS");
@@ -40,7 +49,8 @@ void RegistrationPointsMetrics::ExportMetricsToFile(const std::vector<Registrati
   // creating the table twice leads to an error
   if (!db.tables().contains( tableName ))
   {
-    cout << "Creating registration points metrics table" << std::endl;
+    if (interactive)
+      cout << "Creating registration points metrics table" << std::endl;
 
     QString ins = QString("CREATE TABLE ") + tableName + " ("
             "combination INT PRIMARY KEY,"
@@ -73,31 +83,31 @@ void RegistrationPointsMetrics::ExportMetricsToFile(const std::vector<Registrati
 
             ")";
 
-    QSqlQuery createQuery;
+    QSqlQuery createQuery(db);
     if (!createQuery.exec(ins))
     {
       cout << "Error creating combinations table" << std::endl;
-      return;
+      db.close();
+      return false;
     }
-    else
+    else if (interactive)
       cout << "Combinations table created succesfully" << std::endl;
   }
   // table already existed
   else
   {
-    QSqlQuery readQuery("SELECT COUNT (*) FROM " + tableName);
+    QSqlQuery readQuery("SELECT COUNT (*) FROM " + tableName, db);
     readQuery.first();
     startingC = readQuery.value(0).toUInt();
-    cout << "Table already exists, and has " << startingC << " rows" << std::endl;
+    if (interactive)
+      cout << "Table already exists, and has " << startingC << " rows" << std::endl;
   }
 
 
   // fill table
-  cout << "Storing data..." << std::endl;
-  // get stored number of stimulations
-  QSqlQuery writeQuery;
-  writeQuery.exec(QString("SELECT * FROM ") + tableName);
-
+  if (interactive)
+    cout << "Storing data..." << std::endl;
+  QSqlQuery writeQuery(db);
   writeQuery.prepare("INSERT INTO " + tableName+ "("
       "combination,"
 
@@ -137,13 +147,16 @@ void RegistrationPointsMetrics::ExportMetricsToFile(const std::vector<Registrati
 
   if (!db.transaction())
   {
-    QMessageBox::critical(nullptr, QObject::tr("Could not start transaction"),QObject::tr("Aborting export"));
-    return;
+    if (interactive)
+      QMessageBox::critical(nullptr, QObject::tr("Could not start transaction"),QObject::tr("Aborting export"));
+    cout << "Could not start transaction" << std::endl;
+    db.close();
+    return false;
   }
 
-  for (unsigned int c = 0; c<vec.size(); ++c)
+  for (unsigned int c = 0; c<count; ++c)
   {
-    auto metric = vec[c];
+    const RegistrationPointsMetrics& metric = vec[c];
     // store new row
 
     writeQuery.addBindValue(startingC + c);
@@ -178,28 +191,37 @@ void RegistrationPointsMetrics::ExportMetricsToFile(const std::vector<Registrati
     {
       cout << "Error storing combination data " << c << std::endl;
       cout << "Aborting" << std::endl;
-      return;
+      db.rollback();
+      db.close();
+      return false;
     }
 
-    if (c%1000 == 0)
-      cout << (c+1)*100/vec.size() << "%" << std::endl;
+    if (interactive && (c%1000 == 0))
+      cout << (c+1)*100/count << "%" << std::endl;
 
   }
 
-  cout << "Commiting transaction.." << std::endl;
+  if (interactive)
+    cout << "Commiting transaction.." << std::endl;
   if(!db.commit())
   {
-    QMessageBox::critical(nullptr, QObject::tr("Could not start transaction"),QObject::tr("Aborting export"));
-    return;
+    if (interactive)
+      QMessageBox::critical(nullptr, QObject::tr("Could not start transaction"),QObject::tr("Aborting export"));
+    cout << "Could not commit transaction" << std::endl;
+    db.close();
+    return false;
   }
 
-  cout << "Finished storing all data " << std::endl;
+  if (interactive)
+    cout << "Finished storing all data " << std::endl;
 
   db.close();
 
   // store path in settings
   QSettings settings("CAS", "navCAS");
   settings.setValue("Points combinations for export", filename);
+
+  return true;
 }
 
 const QString RegistrationPointsMetrics::GetCombinationsLastPath()
@@ -1,5 +1,6 @@
 set(CPP_FILES
   NodesManager.cpp
+  NodeRoleRegistry.cpp
 	Markers.cpp
 )
 
@@ -0,0 +1,75 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef NodeRoleRegistry_h
+#define NodeRoleRegistry_h
+
+#include <vector>
+
+#include <mitkDataStorage.h>
+
+#include <vtkMatrix4x4.h>
+#include <vtkSmartPointer.h>
+
+#include <NodesManagerExports.h>
+
+/**
+  \class NodeRoleRegistry
+
+  Index of the nodes that navigation looks up while tracking (instrument, reference image, moving
+  marker surface and system setup node), kept up to date by the add, remove and change events
+  of the datastorage. Lookups do not query the datastorage, and the registration matrix stored in
+  a node (NodesManager::StoreTransformInNode) is only parsed again when its properties change.
+*/
+class NodesManager_EXPORT NodeRoleRegistry
+{
+public:
+
+  enum Role{Instrument, ReferenceImage, MovingMarkerSurface, SystemNode, NUMBER_OF_ROLES};
+
+  explicit NodeRoleRegistry(mitk::DataStorage::Pointer ds);
+  ~NodeRoleRegistry();
+
+  /// bool property that gives a node the role
+  static const char* GetRoleProperty(Role role);
+
+  /// names of the properties holding the rows of a stored registration matrix
+  static const char* const TRANSFORM_PROPERTY[4];
+
+  /// reads a registration matrix stored in the node, returns false if the node has none
+  static bool ReadTransform(const mitk::DataNode* node, vtkMatrix4x4* matrix);
+
+  /// the only node with the role, nullptr if there is none or more than one
+  mitk::DataNode* GetNode(Role role) const;
+  unsigned int GetNumberOfNodes(Role role) const;
+
+  /// registration matrix of GetNode(role), nullptr if there is no such node or it has no matrix.
+  /// The matrix belongs to the registry and is updated in place when the node changes
+  vtkMatrix4x4* GetTransform(Role role);
+
+private:
+  struct Entry
+  {
+    mitk::DataNode*               node;
+    unsigned long                 propertiesTime;
+    bool                          hasTransform;
+    vtkSmartPointer<vtkMatrix4x4> transform;
+  };
+
+  void NodeAdded(const mitk::DataNode* node);
+  void NodeRemoved(const mitk::DataNode* node);
+  void NodeChanged(const mitk::DataNode* node);
+
+  /// adds or removes the node from every role according to its properties
+  void Index(const mitk::DataNode* node, bool present);
+
+  mitk::DataStorage::Pointer          mDataStorage;
+  std::vector<Entry>                  mNodes[NUMBER_OF_ROLES];
+};
+
+#endif
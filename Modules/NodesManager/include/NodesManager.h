@@ -22,6 +22,7 @@ navCAS navigation system
 #include <NodesManagerExports.h>
 
 #include "ArrowSource.h"
+#include "NodeRoleRegistry.h"
 #include "Probe2DManager.h"
 
 /**
@@ -127,6 +128,9 @@ public:
   /// transforms the markers using the matrix, updates the probe (if marker == 2)
   void UpdateRelativeMarker(unsigned int marker, vtkMatrix4x4 *matrix);
 
+  /// appends the nodes moved by UpdateRelativeMarker(marker): fiducials, probe arrow or moving surface
+  void GetMarkerNodes(unsigned int marker, std::vector<mitk::DataNode*>& nodes) const;
+
 
   mitk::Point3D GetProbeLastPosition();
   mitk::Vector3D GetProbeDirection();
@@ -135,6 +139,9 @@ public:
   inline vector<mitk::Point3D> GetBigTrackerGeometry(){return mBigTrackerPos;}
   inline vector<mitk::Point3D> GetProbeGeometry(){return mProbePos;}
 
+  /// replaces the fiducials (and probe tip) of a geometry read by LoadMarkersGeometries
+  void SetMarkerGeometry(navAPI::MarkerId type, const vector<mitk::Point3D>& points);
+
   void SetUsePlannedPoint(mitk::DataNode::Pointer im,unsigned int pos, bool valid);
   bool GetUsePlannedPoint(mitk::DataNode::Pointer im, unsigned int pos);
 
@@ -146,6 +153,9 @@ public:
 
   // probe2D drawing
   void SetRenderWindow(QmitkRenderWindow* axial, QmitkRenderWindow* coronal, QmitkRenderWindow* sagittal);
+  /// the probe 2D renders are requested through the scheduler, directly if nullptr
+  void SetRenderScheduler(RenderScheduler* scheduler);
+  inline RenderScheduler* GetRenderScheduler() const {return mRenderScheduler;}
 
   /// creates the systemsetup node (overrides already existing one)
   void InitializeSetup();
@@ -161,11 +171,21 @@ public:
 
   inline vtkSmartPointer<vtkMatrix4x4> GetLastMovingMarkerRelativeMatrix(){return mLastMovingMarkerRelativeMatrix;}
 
+  /// navigation nodes indexed by role, for lookups that must not query the datastorage
+  inline NodeRoleRegistry* GetRoleRegistry(){return &mRoles;}
+
 private:
-  /// updates marker spheres (fiducials) and probe in screen
-  void UpdateMarker(unsigned int m,std::vector<mitk::Point3D> pos);
+  /// updates marker spheres (fiducials) and probe in screen, pos holds NUMBER_FIDUCIALS[m] points
+  void UpdateMarker(unsigned int m, const mitk::Point3D* pos);
 
-  void UpdateInstrument(vtkTransform* transform);
+  /// stored geometry of the marker type, nullptr if it has no representation
+  const vector<mitk::Point3D>* GetMarkerGeometry(navAPI::MarkerId type) const;
+
+  /// moves the 3D probe arrow (tip at center + normal) by setting the pose of its node
+  void UpdateProbeArrow(const mitk::Point3D& center, const mitk::Vector3D& normal);
+
+  /// moves the moving marker surface (instrument) by setting the pose of its node
+  void UpdateInstrument(vtkMatrix4x4* matrix);
 
   /// seeks the system node in the datastorage
   mitk::DataNode::Pointer GetSystemNode();
@@ -179,6 +199,7 @@ signals:
 
 private:
   mitk::DataStorage::Pointer                mDataStorage;
+  NodeRoleRegistry                          mRoles;
 
   // Stored geometries (TODO: turn into vector of vector)
   vector<mitk::Point3D>                     mSmallTrackerPos;
@@ -190,6 +211,7 @@ private:
   mitk::DataNode::Pointer                   mProbeNode;
 
   ArrowSource::Pointer                      mProbeSource;
+  vtkSmartPointer<vtkMatrix4x4>             mProbePose;
 
   // surface node that will be moved: surface is a deep copy of the selected instrument node
   mitk::DataNode::Pointer                   mMovingMarkerNode;
@@ -220,8 +242,13 @@ private:
 
   std::vector<Probe2DManager::Pointer>      mProbe2DManager;
   std::vector<QmitkRenderWindow*>           mRenderWindow;
+  RenderScheduler*                          mRenderScheduler;
 
   vtkSmartPointer<vtkMatrix4x4>             mLastMovingMarkerRelativeMatrix;
+
+  // reused by every pose update, so that no memory is allocated per tracking frame
+  static const unsigned int                 MAX_MARKER_POINTS = 6;
+  mitk::Point3D                             mMarkerPoints[MAX_MARKER_POINTS];
 };
 
 #endif
@@ -0,0 +1,144 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#include <algorithm>
+
+#include <mitkProperties.h>
+
+#include "NodeRoleRegistry.h"
+
+typedef mitk::MessageDelegate1<NodeRoleRegistry, const mitk::DataNode*> NodeDelegate;
+
+const char* const NodeRoleRegistry::TRANSFORM_PROPERTY[4] = {"navCAS.navreg.transformation.line0",
+                                                             "navCAS.navreg.transformation.line1",
+                                                             "navCAS.navreg.transformation.line2",
+                                                             "navCAS.navreg.transformation.line3"};
+
+NodeRoleRegistry::NodeRoleRegistry(mitk::DataStorage::Pointer ds) :
+  mDataStorage(ds)
+{
+  if (mDataStorage.IsNull())
+    return;
+
+  mDataStorage->AddNodeEvent.AddListener(NodeDelegate(this,&NodeRoleRegistry::NodeAdded));
+  mDataStorage->RemoveNodeEvent.AddListener(NodeDelegate(this,&NodeRoleRegistry::NodeRemoved));
+  mDataStorage->ChangedNodeEvent.AddListener(NodeDelegate(this,&NodeRoleRegistry::NodeChanged));
+
+  // nodes already in the scene
+  mitk::DataStorage::SetOfObjects::ConstPointer so = mDataStorage->GetAll();
+  for (mitk::DataStorage::SetOfObjects::ConstIterator it = so->Begin(); it != so->End(); ++it)
+    Index(it->Value(),true);
+}
+
+NodeRoleRegistry::~NodeRoleRegistry()
+{
+  if (mDataStorage.IsNull())
+    return;
+
+  mDataStorage->AddNodeEvent.RemoveListener(NodeDelegate(this,&NodeRoleRegistry::NodeAdded));
+  mDataStorage->RemoveNodeEvent.RemoveListener(NodeDelegate(this,&NodeRoleRegistry::NodeRemoved));
+  mDataStorage->ChangedNodeEvent.RemoveListener(NodeDelegate(this,&NodeRoleRegistry::NodeChanged));
+}
+
+const char* NodeRoleRegistry::GetRoleProperty(Role role)
+{
+  switch (role)
+  {
+  case Instrument:          return "navCAS.isInstrument";
+  case ReferenceImage:      return "navCAS.registration.isReferencePatientImage";
+  case MovingMarkerSurface: return "navCAS.isMovingMarkerSurface";
+  case SystemNode:          return "navCAS.systemSetup.isSetupNode";
+  default:                  return "";
+  }
+}
+
+bool NodeRoleRegistry::ReadTransform(const mitk::DataNode* node, vtkMatrix4x4* matrix)
+{
+  for (unsigned int i=0; i<4; i++)
+  {
+    mitk::Point4D line;
+    if (!node->GetPropertyValue(TRANSFORM_PROPERTY[i],line))
+      return false;
+
+    for (unsigned int j=0; j<4; j++)
+      matrix->SetElement(i,j,line[j]);
+  }
+  return true;
+}
+
+mitk::DataNode* NodeRoleRegistry::GetNode(Role role) const
+{
+  if (mNodes[role].size() != 1)
+    return nullptr;
+
+  return mNodes[role].front().node;
+}
+
+unsigned int NodeRoleRegistry::GetNumberOfNodes(Role role) const
+{
+  return mNodes[role].size();
+}
+
+vtkMatrix4x4* NodeRoleRegistry::GetTransform(Role role)
+{
+  if (mNodes[role].size() != 1)
+    return nullptr;
+
+  // parse again only if a property was set since the last time
+  Entry& entry = mNodes[role].front();
+  unsigned long propertiesTime = entry.node->GetPropertyList()->GetMTime();
+  if (propertiesTime != entry.propertiesTime)
+  {
+    entry.hasTransform = ReadTransform(entry.node,entry.transform);
+    entry.propertiesTime = propertiesTime;
+  }
+
+  return entry.hasTransform ? entry.transform.GetPointer() : nullptr;
+}
+
+void NodeRoleRegistry::NodeAdded(const mitk::DataNode* node)
+{
+  Index(node,true);
+}
+
+void NodeRoleRegistry::NodeRemoved(const mitk::DataNode* node)
+{
+  Index(node,false);
+}
+
+void NodeRoleRegistry::NodeChanged(const mitk::DataNode* node)
+{
+  // roles are bool properties, which may have been set or cleared
+  Index(node,true);
+}
+
+void NodeRoleRegistry::Index(const mitk::DataNode* node, bool present)
+{
+  for (unsigned int r=0; r<NUMBER_OF_ROLES; r++)
+  {
+    bool hasRole = false;
+    if (present)
+      node->GetBoolProperty(GetRoleProperty(static_cast<Role>(r)),hasRole);
+
+    std::vector<Entry>& nodes = mNodes[r];
+    auto it = std::find_if(nodes.begin(),nodes.end(),[node](const Entry& e){return e.node == node;});
+    bool indexed = (it != nodes.end());
+
+    if (hasRole && !indexed)
+    {
+      Entry entry;
+      entry.node = const_cast<mitk::DataNode*>(node);
+      entry.propertiesTime = 0;
+      entry.hasTransform = false;
+      entry.transform = vtkSmartPointer<vtkMatrix4x4>::New();
+      nodes.push_back(entry);
+    }
+    else if (!hasRole && indexed)
+      nodes.erase(it);
+  }
+}
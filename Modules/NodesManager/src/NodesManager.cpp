@@ -8,6 +8,7 @@ navCAS navigation system
 
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
 // vtk
 #include <vtkSphereSource.h>
@@ -28,6 +29,8 @@ navCAS navigation system
 #include <mitkNodePredicateNot.h>
 #include <mitkNodePredicateAnd.h>
 
+#include <RigidTransformVtk.h>
+
 #include "NodesManager.h"
 #include "LabeledPointSetMapper3D.h"
 #include "LabeledPointSetMapper2D.h"
@@ -40,7 +43,9 @@ const string NodesManager::SURFACE_NAME = string("navCAS_planning_surface");
 const unsigned int NodesManager::NUMBER_FIDUCIALS[3] = {4,4,6}; // Probe actually has 5 fiducials
 
 NodesManager::NodesManager(mitk::DataStorage::Pointer ds) :
-  mDataStorage(ds)
+  mDataStorage(ds),
+  mRoles(ds),
+  mRenderScheduler(nullptr)
 {
   mPrimaryPlannedPoints = mitk::PointSet::New();
   mPrimaryRealPoints = mitk::PointSet::New();
@@ -49,6 +54,12 @@ NodesManager::NodesManager(mitk::DataStorage::Pointer ds) :
   mUseMoving = false;
 
   mLastMovingMarkerRelativeMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  mProbePose = vtkSmartPointer<vtkMatrix4x4>::New();
+
+  // reference, moving marker and probe (until the system setup is loaded)
+  mMarkerType.push_back(navAPI::MarkerId::None);
+  mMarkerType.push_back(navAPI::MarkerId::None);
+  mMarkerType.push_back(navAPI::MarkerId::Probe);
 
   // probe 2D
   for (int i = 0; i < 3; i++)
@@ -134,6 +145,50 @@ void NodesManager::LoadMarkersGeometries()
   cout << "**************************** original probe tip: " << mProbePos[5] << std::endl;
 }
 
+void NodesManager::SetMarkerGeometry(navAPI::MarkerId type, const vector<mitk::Point3D>& points)
+{
+  switch(type)
+  {
+  case navAPI::MarkerId::SmallTracker:
+    mSmallTrackerPos = points;
+    break;
+
+  case navAPI::MarkerId::MediumTracker:
+    mMediumTrackerPos = points;
+    break;
+
+  case navAPI::MarkerId::BigTracker:
+    mBigTrackerPos = points;
+    break;
+
+  case navAPI::MarkerId::Probe:
+  case navAPI::MarkerId::TemporalProbe:
+    mProbePos = points;
+    break;
+
+  default:
+    cerr << "Wrong marker passed to function" << std::endl;
+    break;
+  }
+}
+
+const vector<mitk::Point3D>* NodesManager::GetMarkerGeometry(navAPI::MarkerId type) const
+{
+  switch (type)
+  {
+  case navAPI::SmallTracker:
+    return &mSmallTrackerPos;
+  case navAPI::MediumTracker:
+    return &mMediumTrackerPos;
+  case navAPI::BigTracker:
+    return &mBigTrackerPos;
+  case navAPI::Probe:
+    return &mProbePos;
+  default:
+    return nullptr;
+  }
+}
+
 void NodesManager::GenerateMarkerPointsFromGeometry(navAPI::MarkerId type, mitk::Point3D* pivot)
 {
   vector<mitk::Point3D> *marker;
@@ -287,8 +342,9 @@ mitk::Point3D NodesManager::UpdateProbeTip(mitk::Vector3D correction)
   cout << "Distance to fiducial is: " << normal.GetNorm() << std::endl;
   mProbeSource = ArrowSource::New(normal.GetDataPointer(),mProbePos[3].GetDataPointer(),normal.GetNorm());
   auto surf = dynamic_cast<mitk::Surface*>(so->Begin()->Value()->GetData());
-  surf->SetVtkPolyData(mProbeSource->GetOutput());
+  surf->SetVtkPolyData(mProbeSource->GetLocalOutput());
   mProbeNode->SetData(surf);
+  UpdateProbeArrow(mProbePos[3],normal);
 
   return mProbePos[5];
 }
@@ -329,7 +385,7 @@ void NodesManager::CreateMarkers()
   {
     mProbeNode = so->Begin()->Value();
     auto arrowSurf = dynamic_cast<mitk::Surface*>(mProbeNode->GetData());
-    arrowSurf->SetVtkPolyData(mProbeSource->GetOutput());
+    arrowSurf->SetVtkPolyData(mProbeSource->GetLocalOutput());
     mProbeNode->SetData(arrowSurf);
   }
   else
@@ -344,7 +400,7 @@ void NodesManager::CreateMarkers()
     // 3D arrow probe
     mProbeNode = mitk::DataNode::New();
     mitk::Surface::Pointer arrowSurf = mitk::Surface::New();
-    arrowSurf->SetVtkPolyData(mProbeSource->GetOutput());
+    arrowSurf->SetVtkPolyData(mProbeSource->GetLocalOutput());
     mProbeNode->SetData(arrowSurf);
     mProbeNode->SetBoolProperty("navCAS.isProbeSurface",true);
     mProbeNode->SetColor(0,1,1);
@@ -352,6 +408,7 @@ void NodesManager::CreateMarkers()
     mProbeNode->SetBoolProperty("helper object",!GetShowHelperObjects());
     mDataStorage->Add(mProbeNode);
   }
+  UpdateProbeArrow(mProbePos[3],normal);
 
 
   // Check if all markers already exist and exit
@@ -485,13 +542,7 @@ mitk::DataNode::Pointer NodesManager::GetSystemNode()
     cerr << "Error: DataStorage is null! Can't retrieve the system node" << std::endl;
     return nullptr;
   }
-  mitk::NodePredicateProperty::Pointer pred = mitk::NodePredicateProperty::New("navCAS.systemSetup.isSetupNode",mitk::BoolProperty::New(true));
-  mitk::DataStorage::SetOfObjects::ConstPointer so = mDataStorage->GetSubset(pred);
-
-  if (so->size() != 1)
-    return nullptr;
-
-  return so->Begin()->Value();
+  return mRoles.GetNode(NodeRoleRegistry::SystemNode);
 }
 
 navAPI::MarkerId NodesManager::GetReferenceMarker()
@@ -542,28 +593,33 @@ mitk::Vector3D NodesManager::GetProbeDirection()
   return dir;
 }
 
-void NodesManager::UpdateMarker(unsigned int m, std::vector<mitk::Point3D> pos)
+void NodesManager::UpdateMarker(unsigned int m, const mitk::Point3D* pos)
 {
-  unsigned int numberFiducials = 4;
-  if (m == 2)
-    numberFiducials = 6;  // actually is 5 fiducials and the tip position
+  // probe actually is 5 fiducials and the tip position
+  const unsigned int numberFiducials = NUMBER_FIDUCIALS[m];
 
+  // the fiducial poses are written in place, only moved fiducials are invalidated
   for (unsigned int i=0; i<numberFiducials; i++)
   {
-    mFiducials[m][i]->GetData()->SetOrigin(pos[i]);
+    mitk::BaseGeometry* geometry = mFiducials[m][i]->GetData()->GetGeometry();
+    mitk::AffineTransform3D* transform = geometry->GetIndexToWorldTransform();
+    if (transform->GetOffset() == pos[i].GetVectorFromOrigin())
+      continue;
+
+    transform->SetOffset(pos[i].GetVectorFromOrigin());
+    geometry->TransferItkToVtkTransform();
+    geometry->Modified();
   }
 
   // update probe polydata
   if (m == 2)
   {
     mitk::Vector3D normal = pos[5] - pos[3];
-    mProbeSource->SetCenter(pos[3].GetDataPointer());
-    mProbeSource->SetNormal(normal.GetDataPointer());
-    mProbeSource->Update();
-    dynamic_cast<mitk::Surface*>(mProbeNode->GetData())->SetVtkPolyData(mProbeSource->GetOutput());
+    UpdateProbeArrow(pos[3],normal);
 
-    // TO DO: only change this in update of show probe
-    mProbeNode->SetVisibility(mShowProbe);
+    // setting the property modifies the node, even with the same value
+    if (mProbeNode->IsVisible(nullptr) != mShowProbe)
+      mProbeNode->SetVisibility(mShowProbe);
 
     double axis[3][3] = {{0.0}};
     axis[0][2]=-1;//axial plane
@@ -579,7 +635,10 @@ void NodesManager::UpdateMarker(unsigned int m, std::vector<mitk::Point3D> pos)
         return;
       }
       mProbe2DManager[i]->ShowCircle(mShowProbe);
+      if (!mShowProbe)
+        continue;
 
+      // the overlay is only rebuilt and rendered if the projection moved on screen
       mitk::Point2D tip;
       mRenderWindow[i]->GetRenderer()->WorldToDisplay(pos[5],tip);
 
@@ -608,95 +667,72 @@ void NodesManager::UpdateMarker(unsigned int m, std::vector<mitk::Point3D> pos)
   }
 }
 
-void NodesManager::UpdateInstrument(vtkTransform* transform)
+void NodesManager::UpdateProbeArrow(const mitk::Point3D& center, const mitk::Vector3D& normal)
 {
-  // load selected surface from datastorage
-  // Polydata is already transformed according to instrument registration
-  mitk::NodePredicateProperty::Pointer pred = mitk::NodePredicateProperty::New("navCAS.isInstrument",mitk::BoolProperty::New(true));
-  mitk::DataStorage::SetOfObjects::ConstPointer so = mDataStorage->GetSubset(pred);
+  // the arrow polydata stays the same, only the pose of the node changes
+  mProbeSource->SetCenter(center.GetDataPointer());
+  mProbeSource->SetNormal(normal.GetDataPointer());
+  mProbeSource->GetPoseMatrix(mProbePose);
+  mProbeNode->GetData()->GetGeometry()->SetIndexToWorldTransformByVtkMatrix(mProbePose);
+}
 
-  if (so->size() != 1)
+void NodesManager::UpdateInstrument(vtkMatrix4x4* matrix)
+{
+  // selected surface from datastorage
+  // Polydata is already transformed according to instrument registration
+  mitk::DataNode* instrumentNode = mRoles.GetNode(NodeRoleRegistry::Instrument);
+  if (instrumentNode == nullptr)
   {
-    cout << "ERROR: Number of instruments in datastorage = " << so->size() << std::endl;
+    cout << "ERROR: Number of instruments in datastorage = " << mRoles.GetNumberOfNodes(NodeRoleRegistry::Instrument) << std::endl;
     return;
   }
 
-  // Transform instrument surface if required
-  auto instrumentNode = so->Begin()->Value();
+  // Move instrument surface if required: the moving surface shares the instrument polydata and
+  // only its geometry follows the marker, so the mesh is never copied nor uploaded again
   if  (mNavigationMode == InstrumentTracking)
   {
-    vtkSmartPointer<vtkTransformPolyDataFilter> filter = vtkSmartPointer<vtkTransformPolyDataFilter>::New();
-    filter->SetInputData(dynamic_cast<mitk::Surface*>(instrumentNode->GetData())->GetVtkPolyData());
-    filter->SetTransform(transform);
-    filter->Update();
-    dynamic_cast<mitk::Surface*>(mMovingMarkerNode->GetData())->SetVtkPolyData(filter->GetOutput());
-    mMovingMarkerNode->SetVisibility(true);
-  }
+    vtkPolyData* instrument = dynamic_cast<mitk::Surface*>(instrumentNode->GetData())->GetVtkPolyData();
+    auto movingSurface = dynamic_cast<mitk::Surface*>(mMovingMarkerNode->GetData());
+    if (movingSurface->GetVtkPolyData() != instrument)
+      movingSurface->SetVtkPolyData(instrument);
+
+    movingSurface->GetGeometry()->SetIndexToWorldTransformByVtkMatrix(matrix);
 
-  // get movement and angle of coil transformation
-  //cout << "Coil transformation: " << std::endl;
-  double wxyz[4];
-  transform->GetOrientationWXYZ(wxyz);
-  //cout << "Angle: " << wxyz[0] << std::endl;
-  double offset[3];
-  transform->GetPosition(offset);
-  //cout << "Offset: " << mitk::Point3D(offset) << std::endl;
+    // setting a property creates a new one, even with the same value
+    if (!mMovingMarkerNode->IsVisible(nullptr))
+      mMovingMarkerNode->SetVisibility(true);
+  }
 
   // get moving marker registration matrix
-  pred = mitk::NodePredicateProperty::New("navCAS.isInstrument",mitk::BoolProperty::New(true));
-  so = mDataStorage->GetSubset(pred);
+  vtkMatrix4x4* movingRegistration = mRoles.GetTransform(NodeRoleRegistry::Instrument);
 
-  if (so->Size() == 1)
+  if (movingRegistration != nullptr)
   {
-    //vtkSmartPointer<vtkMatrix4x4> movingRegistration = GetTransformFromPatientNode(mMovingMarkerNode);
-    vtkSmartPointer<vtkMatrix4x4> movingRegistration = GetTransformFromNode(so->Begin()->Value());
-
-    if (movingRegistration != nullptr)
+    // compute and inform offset and ange error
+    if (mNavigationMode == InstrumentTracking)
     {
-      // compute and inform offset and ange error
-      if (mNavigationMode == InstrumentTracking)
-      {
-        vtkSmartPointer<vtkTransform> movingTransform = vtkSmartPointer<vtkTransform>::New();
-        movingTransform->SetMatrix(movingRegistration);
-        movingTransform->Update();
-        //cout << "Moving surface transformation: " << std::endl;
-        movingTransform->GetOrientationWXYZ(wxyz);
-        //cout << "Angle: " << wxyz[0] << std::endl;
-        movingTransform->GetPosition(offset);
-        //cout << "Offset: " << mitk::Point3D(offset) << std::endl;
-
-        // compute total error
-        vtkSmartPointer<vtkMatrix4x4> invRelativeMarker = vtkSmartPointer<vtkMatrix4x4>::New();
-        vtkMatrix4x4::Invert(transform->GetMatrix(),invRelativeMarker);
-
-        vtkSmartPointer<vtkMatrix4x4> errorMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-        vtkMatrix4x4::Multiply4x4(invRelativeMarker,movingRegistration,errorMatrix);
-
-
-        vtkSmartPointer<vtkTransform> errorTransform = vtkSmartPointer<vtkTransform>::New();
-        errorTransform->SetMatrix(errorMatrix);
-        errorTransform->Update();
-        //cout << "Total error transformation: " << std::endl;
-        errorTransform->GetOrientationWXYZ(wxyz);
-        double angleError = abs(wxyz[0]);
-        //cout << "Angle error: " << angleError << " deg" << std::endl;
-        errorTransform->GetPosition(offset);
-        mitk::Vector3D offsetVec(offset);
-        double offsetError = offsetVec.GetNorm();
-        //cout << "Offset error: " << offsetError << " mm" << std::endl;
-
-        // change node color
-        if ((offsetError < 2.0) && (angleError < 2.0))
-          mMovingMarkerNode->SetColor(0,1,0);
-        else if ((offsetError < 9.0) && (angleError < 8.0))
-          mMovingMarkerNode->SetColor(1,1,0);
-        else
-          mMovingMarkerNode->SetColor(1,0,0);
-
-        // show text labels
-        emit AngleError(angleError);
-        emit OffsetError(offsetError);
-      }
+      // total error: relative marker pose against the instrument registration
+      const RigidTransform error = RigidTransformFromVtk(matrix).Inverse() * RigidTransformFromVtk(movingRegistration);
+      const double angleError = vtkMath::DegreesFromRadians(error.GetRotationAngle());
+      const double offsetError = error.GetTranslationNorm();
+
+      // change node color (only when the error range changes)
+      const float green[3] = {0.0f, 1.0f, 0.0f};
+      const float yellow[3] = {1.0f, 1.0f, 0.0f};
+      const float red[3] = {1.0f, 0.0f, 0.0f};
+      const float* color = red;
+      if ((offsetError < 2.0) && (angleError < 2.0))
+        color = green;
+      else if ((offsetError < 9.0) && (angleError < 8.0))
+        color = yellow;
+
+      float current[3];
+      if (!mMovingMarkerNode->GetColor(current) || !std::equal(color,color+3,current))
+        mMovingMarkerNode->SetColor(color);
+
+      // show text labels
+      emit AngleError(angleError);
+      emit OffsetError(offsetError);
     }
   }
 }
@@ -722,15 +758,15 @@ void NodesManager::SetReferenceMarker(navAPI::MarkerId type)
   switch(type)
     {
     case navAPI::MarkerId::SmallTracker:
-      UpdateMarker(0,mSmallTrackerPos);
+      UpdateMarker(0,mSmallTrackerPos.data());
       break;
 
     case navAPI::MarkerId::MediumTracker:
-      UpdateMarker(0,mMediumTrackerPos);
+      UpdateMarker(0,mMediumTrackerPos.data());
       break;
 
     case navAPI::MarkerId::BigTracker:
-      UpdateMarker(0,mBigTrackerPos);
+      UpdateMarker(0,mBigTrackerPos.data());
       break;
 
     default:
@@ -845,41 +881,37 @@ bool NodesManager::GetUseMovingMarker()
 
 void NodesManager::UpdateRelativeMarker(unsigned int m, vtkMatrix4x4* matrix)
 {
-  // to do: use reference instead of copy
-  std::vector<mitk::Point3D> pos;
-
-  switch (mMarkerType[m])
-  {
-  case navAPI::SmallTracker:
-    pos = mSmallTrackerPos;
-    break;
-  case navAPI::MediumTracker:
-    pos = mMediumTrackerPos;
-    break;
-  case navAPI::BigTracker:
-    pos = mBigTrackerPos;
-    break;
-  case navAPI::Probe:
-    pos = mProbePos;
-    break;
-  default:
+  const vector<mitk::Point3D>* geometry = GetMarkerGeometry(mMarkerType[m]);
+  if ((geometry == nullptr) || (geometry->size() < NUMBER_FIDUCIALS[m]))
     return;
-  }
 
   // store last matrix of relative position between reference and moving marker
   if (m == 1)
     mLastMovingMarkerRelativeMatrix->DeepCopy(matrix);
 
-  vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
-  transform->SetMatrix(matrix);
+  // rigid transform of the geometry points into the reused buffer
+  const RigidTransform transform = RigidTransformFromVtk(matrix);
+  for (unsigned int p=0; p<NUMBER_FIDUCIALS[m]; p++)
+    transform.TransformPoint((*geometry)[p].GetDataPointer(),mMarkerPoints[p].GetDataPointer());
 
-  for (unsigned int p=0; p<pos.size(); p++)
-    pos[p] = mitk::Point3D(transform->TransformDoublePoint(pos[p][0],pos[p][1],pos[p][2]));
-
-  UpdateMarker(m,pos);
+  UpdateMarker(m,mMarkerPoints);
 
   if (mUseMoving && (mMarkerType[m] != navAPI::Probe))
-    UpdateInstrument(transform);
+    UpdateInstrument(matrix);
+}
+
+void NodesManager::GetMarkerNodes(unsigned int m, std::vector<mitk::DataNode*>& nodes) const
+{
+  if (m >= mFiducials.size())
+    return;
+
+  for (const mitk::DataNode::Pointer& fiducial : mFiducials[m])
+    nodes.push_back(fiducial);
+
+  if (m == 2)
+    nodes.push_back(mProbeNode);
+  else if (mUseMoving && (mMarkerType[m] != navAPI::Probe))
+    nodes.push_back(mMovingMarkerNode);
 }
 
 // ** PLANNED SERIES ** //
@@ -1208,10 +1240,7 @@ void NodesManager::StoreTransformInNode(const vtkMatrix4x4* transform, mitk::Dat
     for (unsigned int j=0; j<4; j++)
       line[j] = transform->GetElement(i,j);
 
-    stringstream name;
-    name << "navCAS.navreg.transformation.line";
-    name << i;
-    node->SetProperty(name.str().c_str(),mitk::Point4dProperty::New(line));
+    node->SetProperty(NodeRoleRegistry::TRANSFORM_PROPERTY[i],mitk::Point4dProperty::New(line));
   }
 }
 
@@ -1220,19 +1249,8 @@ vtkSmartPointer<vtkMatrix4x4> NodesManager::GetTransformFromNode(mitk::DataNode:
 {
   vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
 
-  for (unsigned int i=0; i<4; i++)
-  {
-    stringstream name;
-    name << "navCAS.navreg.transformation.line";
-    name << i;
-
-    mitk::Point4D line;
-    if (!node->GetPropertyValue(name.str().c_str(),line))
-      return nullptr;
-
-    for (unsigned int j=0; j<4; j++)
-      matrix->SetElement(i,j,line[j]);
-  }
+  if (!NodeRoleRegistry::ReadTransform(node,matrix))
+    return nullptr;
 
   return matrix;
 }
@@ -1266,6 +1284,18 @@ void NodesManager::SetRenderWindow(QmitkRenderWindow* axial, QmitkRenderWindow*
   mProbe2DManager[0]->ShowCircle(true);
   mProbe2DManager[1]->ShowCircle(true);
   mProbe2DManager[2]->ShowCircle(true);
+
+  SetRenderScheduler(mRenderScheduler);
+}
+
+void NodesManager::SetRenderScheduler(RenderScheduler* scheduler)
+{
+  mRenderScheduler = scheduler;
+  for (unsigned int i=0; i<mProbe2DManager.size(); i++)
+  {
+    if (mProbe2DManager[i].IsNotNull())
+      mProbe2DManager[i]->SetRenderScheduler(scheduler);
+  }
 }
 
 
@@ -0,0 +1,102 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// MITK includes
+#include <mitkStandaloneDataStorage.h>
+// Module includes
+#include "NodeRoleRegistry.h"
+#include "NodesManager.h"
+
+class NodeRoleRegistryTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(NodeRoleRegistryTestSuite);
+  MITK_TEST(IndexFollowsDataStorage);
+  MITK_TEST(ExistingNodesAreIndexed);
+  MITK_TEST(TransformIsCachedUntilChanged);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::DataStorage::Pointer  mDs;
+
+  mitk::DataNode::Pointer AddNode(const char* role)
+  {
+    mitk::DataNode::Pointer node = mitk::DataNode::New();
+    node->SetBoolProperty(role,true);
+    mDs->Add(node);
+    return node;
+  }
+
+public:
+  void setUp() override
+  {
+    mDs = mitk::StandaloneDataStorage::New().GetPointer();
+  }
+
+  void tearDown() override
+  {
+    mDs = nullptr;
+  }
+
+  void IndexFollowsDataStorage()
+  {
+    NodeRoleRegistry roles(mDs);
+    CPPUNIT_ASSERT_MESSAGE("Empty scene has no instrument", roles.GetNode(NodeRoleRegistry::Instrument) == nullptr);
+
+    mitk::DataNode::Pointer instrument = AddNode(NodeRoleRegistry::GetRoleProperty(NodeRoleRegistry::Instrument));
+    CPPUNIT_ASSERT_MESSAGE("Added instrument is indexed", roles.GetNode(NodeRoleRegistry::Instrument) == instrument.GetPointer());
+
+    // a second instrument makes the role ambiguous, as the datastorage queries it replaces
+    mitk::DataNode::Pointer other = AddNode(NodeRoleRegistry::GetRoleProperty(NodeRoleRegistry::Instrument));
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Both instruments are indexed", 2u, roles.GetNumberOfNodes(NodeRoleRegistry::Instrument));
+    CPPUNIT_ASSERT_MESSAGE("Ambiguous role returns no node", roles.GetNode(NodeRoleRegistry::Instrument) == nullptr);
+
+    // property cleared on an existing node
+    other->SetBoolProperty(NodeRoleRegistry::GetRoleProperty(NodeRoleRegistry::Instrument),false);
+    CPPUNIT_ASSERT_MESSAGE("Cleared role is removed", roles.GetNode(NodeRoleRegistry::Instrument) == instrument.GetPointer());
+
+    // property set on an existing node
+    other->SetBoolProperty(NodeRoleRegistry::GetRoleProperty(NodeRoleRegistry::SystemNode),true);
+    CPPUNIT_ASSERT_MESSAGE("Set role is indexed", roles.GetNode(NodeRoleRegistry::SystemNode) == other.GetPointer());
+
+    mDs->Remove(instrument);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Removed instrument is not indexed", 0u, roles.GetNumberOfNodes(NodeRoleRegistry::Instrument));
+  }
+
+  void ExistingNodesAreIndexed()
+  {
+    mitk::DataNode::Pointer surface = AddNode(NodeRoleRegistry::GetRoleProperty(NodeRoleRegistry::MovingMarkerSurface));
+
+    NodeRoleRegistry roles(mDs);
+    CPPUNIT_ASSERT_MESSAGE("Node added before the registry is indexed",
+                           roles.GetNode(NodeRoleRegistry::MovingMarkerSurface) == surface.GetPointer());
+  }
+
+  void TransformIsCachedUntilChanged()
+  {
+    NodeRoleRegistry roles(mDs);
+    mitk::DataNode::Pointer image = AddNode(NodeRoleRegistry::GetRoleProperty(NodeRoleRegistry::ReferenceImage));
+    CPPUNIT_ASSERT_MESSAGE("Node without matrix has no transform", roles.GetTransform(NodeRoleRegistry::ReferenceImage) == nullptr);
+
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    matrix->SetElement(0,3,12.5);
+    NodesManager::StoreTransformInNode(matrix,image);
+
+    vtkMatrix4x4* transform = roles.GetTransform(NodeRoleRegistry::ReferenceImage);
+    CPPUNIT_ASSERT_MESSAGE("Stored transform is read", (transform != nullptr) && (transform->GetElement(0,3) == 12.5));
+    CPPUNIT_ASSERT_MESSAGE("Unchanged node returns the cached matrix", roles.GetTransform(NodeRoleRegistry::ReferenceImage) == transform);
+
+    matrix->SetElement(1,3,-4.0);
+    NodesManager::StoreTransformInNode(matrix,image);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("New transform is read again", -4.0, roles.GetTransform(NodeRoleRegistry::ReferenceImage)->GetElement(1,3));
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(NodeRoleRegistry)
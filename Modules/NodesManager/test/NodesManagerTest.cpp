@@ -0,0 +1,246 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// std includes
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+// MITK includes
+#include <mitkStandaloneDataStorage.h>
+#include <mitkNodePredicateProperty.h>
+#include <mitkNodePredicateAnd.h>
+#include <mitkSurface.h>
+#include <QmitkRegisterClasses.h>
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkSphereSource.h>
+// Module includes
+#include "NodesManager.h"
+
+// Counts the allocations of the test driver while enabled. On Windows every module has its own
+// allocator, so only the allocations of the driver itself are seen.
+static std::atomic<bool>        gCountAllocations(false);
+static std::atomic<unsigned>    gAllocations(0);
+
+void* operator new(std::size_t size)
+{
+  if (gCountAllocations)
+    gAllocations++;
+
+  void* p = std::malloc(size ? size : 1);
+  if (p == nullptr)
+    throw std::bad_alloc();
+  return p;
+}
+
+void* operator new[](std::size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+  std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+  std::free(p);
+}
+
+class NodesManagerTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(NodesManagerTestSuite);
+  MITK_TEST(UpdateRelativeMarker);
+  MITK_TEST(NoAllocationsPerFrame);
+  MITK_TEST(ProbeArrowMovedByPose);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  mitk::DataStorage::Pointer  mDs;
+  NodesManager*               mManager;
+
+  static std::vector<mitk::Point3D> Square(double side)
+  {
+    std::vector<mitk::Point3D> points(4);
+    for (unsigned int i=0; i<4; i++)
+    {
+      points[i][0] = (i & 1) ? side : 0.0;
+      points[i][1] = (i & 2) ? side : 0.0;
+      points[i][2] = 0.0;
+    }
+    return points;
+  }
+
+  mitk::Point3D GetFiducialPosition(int marker, int fid)
+  {
+    auto pred = mitk::NodePredicateAnd::New(mitk::NodePredicateProperty::New("navCAS.fiducial.marker",mitk::IntProperty::New(marker)),
+                                            mitk::NodePredicateProperty::New("navCAS.fiducial.fid",mitk::IntProperty::New(fid)));
+    return mDs->GetNode(pred)->GetData()->GetGeometry()->GetOrigin();
+  }
+
+public:
+  void setUp() override
+  {
+    // rendering manager used by NodesManager
+    QmitkRegisterClasses();
+
+    mDs = mitk::StandaloneDataStorage::New().GetPointer();
+    mManager = new NodesManager(mDs);
+
+    // geometries that do not depend on the installed geometry files
+    mManager->SetMarkerGeometry(navAPI::SmallTracker, Square(10.0));
+    mManager->SetMarkerGeometry(navAPI::MediumTracker, Square(20.0));
+    mManager->SetMarkerGeometry(navAPI::BigTracker, Square(30.0));
+
+    std::vector<mitk::Point3D> probe(6);
+    for (unsigned int i=0; i<6; i++)
+    {
+      probe[i].Fill(0.0);
+      probe[i][0] = 10.0*i;
+    }
+    mManager->SetMarkerGeometry(navAPI::Probe, probe);
+
+    mManager->InitializeSetup();
+    mManager->CreateMarkers();
+    mManager->SetReferenceMarker(navAPI::SmallTracker);
+    mManager->SetMovingMarker(navAPI::MediumTracker);
+  }
+
+  void tearDown() override
+  {
+    delete mManager;
+    mManager = nullptr;
+    mDs = nullptr;
+  }
+
+  void UpdateRelativeMarker()
+  {
+    // 90 degrees around z and a translation
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    matrix->SetElement(0,0,0.0);  matrix->SetElement(0,1,-1.0); matrix->SetElement(0,3,5.0);
+    matrix->SetElement(1,0,1.0);  matrix->SetElement(1,1,0.0);  matrix->SetElement(1,3,-3.0);
+    matrix->SetElement(2,3,7.0);
+
+    mManager->UpdateRelativeMarker(1,matrix);
+
+    const std::vector<mitk::Point3D> geometry = Square(20.0);
+    for (int i=0; i<4; i++)
+    {
+      mitk::Point3D expected;
+      expected[0] = -geometry[i][1] + 5.0;
+      expected[1] = geometry[i][0] - 3.0;
+      expected[2] = geometry[i][2] + 7.0;
+
+      CPPUNIT_ASSERT_MESSAGE("Moving marker fiducial is transformed", expected.EuclideanDistanceTo(GetFiducialPosition(1,i)) < 1e-9);
+    }
+
+    CPPUNIT_ASSERT_MESSAGE("Relative matrix of the moving marker is stored",
+                           mManager->GetLastMovingMarkerRelativeMatrix()->GetElement(1,3) == -3.0);
+  }
+
+  void NoAllocationsPerFrame()
+  {
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+
+    // first update may initialize lazily created objects
+    mManager->UpdateRelativeMarker(1,matrix);
+
+    gAllocations = 0;
+    gCountAllocations = true;
+    for (int frame=1; frame<=100; frame++)
+    {
+      matrix->SetElement(0,3,0.1*frame);
+      mManager->UpdateRelativeMarker(1,matrix);
+    }
+    gCountAllocations = false;
+
+    MITK_INFO << "Allocations in 100 moving marker updates: " << gAllocations;
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Pose updates do not allocate", 0u, static_cast<unsigned>(gAllocations));
+    CPPUNIT_ASSERT_MESSAGE("Last pose is displayed", std::abs(GetFiducialPosition(1,0)[0] - 10.0) < 1e-9);
+
+    // instrument tracking: the moving surface follows the marker and is colored by the registration error
+    vtkSmartPointer<vtkSphereSource> sphere = vtkSmartPointer<vtkSphereSource>::New();
+    sphere->Update();
+    mitk::Surface::Pointer surface = mitk::Surface::New();
+    surface->SetVtkPolyData(sphere->GetOutput());
+    mitk::DataNode::Pointer instrument = mitk::DataNode::New();
+    instrument->SetData(surface);
+    instrument->SetBoolProperty("navCAS.isInstrument",true);
+    NodesManager::StoreTransformInNode(vtkSmartPointer<vtkMatrix4x4>::New(),instrument);
+    mDs->Add(instrument);
+
+    mManager->SetUseMovingMarker(true);
+    mManager->SetNavigationModeToInstrumentTracking();
+
+    matrix->Identity();
+    mManager->UpdateRelativeMarker(1,matrix);
+
+    gAllocations = 0;
+    gCountAllocations = true;
+    for (int frame=1; frame<=100; frame++)
+    {
+      // within the 2 mm of the green range
+      matrix->SetElement(0,3,0.01*frame);
+      mManager->UpdateRelativeMarker(1,matrix);
+    }
+    gCountAllocations = false;
+
+    MITK_INFO << "Allocations in 100 instrument updates: " << gAllocations;
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Instrument updates do not allocate", 0u, static_cast<unsigned>(gAllocations));
+
+    mitk::DataNode* movingSurface = mManager->GetRoleRegistry()->GetNode(NodeRoleRegistry::MovingMarkerSurface);
+    float color[3];
+    CPPUNIT_ASSERT_MESSAGE("Moving surface shown", movingSurface->IsVisible(nullptr));
+    CPPUNIT_ASSERT_MESSAGE("Green within the tolerance", movingSurface->GetColor(color) && (color[0] == 0.0f) && (color[1] == 1.0f));
+    CPPUNIT_ASSERT_MESSAGE("Moving surface follows the marker",
+                           std::abs(movingSurface->GetData()->GetGeometry()->GetVtkMatrix()->GetElement(0,3) - 1.0) < 1e-9);
+  }
+
+  void ProbeArrowMovedByPose()
+  {
+    auto pred = mitk::NodePredicateProperty::New("navCAS.isProbeSurface",mitk::BoolProperty::New(true));
+    auto arrow = dynamic_cast<mitk::Surface*>(mDs->GetNode(pred)->GetData());
+    vtkPolyData* polyData = arrow->GetVtkPolyData();
+
+    // 90 degrees around z and a translation
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    matrix->SetElement(0,0,0.0);  matrix->SetElement(0,1,-1.0); matrix->SetElement(0,3,5.0);
+    matrix->SetElement(1,0,1.0);  matrix->SetElement(1,1,0.0);  matrix->SetElement(1,3,-3.0);
+    matrix->SetElement(2,3,7.0);
+
+    mManager->UpdateRelativeMarker(2,matrix);
+
+    CPPUNIT_ASSERT_MESSAGE("Arrow mesh is not regenerated", arrow->GetVtkPolyData() == polyData);
+
+    // arrow starts at fiducial 3 (30,0,0) and points along the probe (+x), both rotated
+    vtkMatrix4x4* pose = arrow->GetGeometry()->GetVtkMatrix();
+    const double expected[3][2] = {{0.0,5.0},{1.0,27.0},{0.0,7.0}};
+    for (int i=0; i<3; i++)
+    {
+      CPPUNIT_ASSERT_MESSAGE("Arrow direction", std::abs(pose->GetElement(i,0) - expected[i][0]) < 1e-9);
+      CPPUNIT_ASSERT_MESSAGE("Arrow position", std::abs(pose->GetElement(i,3) - expected[i][1]) < 1e-9);
+    }
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(NodesManager)
@@ -1,5 +1,7 @@
 set(MODULE_TESTS
   MarkersTest.cpp
+  NodeRoleRegistryTest.cpp
+  NodesManagerTest.cpp
 )
 SET(MODULE_CUSTOM_TESTS
 )
@@ -0,0 +1,288 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef RIGIDTRANSFORM_H
+#define RIGIDTRANSFORM_H
+
+#include <cmath>
+#include <cstddef>
+
+/*  Rigid transform math for the tracking paths, without VTK or ITK objects: plain value types
+    that live on the stack. VTK and ITK adapters are in RigidTransformVtk.h and
+    RigidTransformItk.h, to be used at the API boundaries only.*/
+
+/// Rotation as a unit quaternion (w,x,y,z)
+struct Quaternion
+{
+  double w, x, y, z;
+
+  static constexpr Quaternion Identity(){return Quaternion{1.0,0.0,0.0,0.0};}
+
+  /// rotation q first, then this one
+  constexpr Quaternion operator*(const Quaternion& q) const
+  {
+    return Quaternion{w*q.w - x*q.x - y*q.y - z*q.z,
+                      w*q.x + x*q.w + y*q.z - z*q.y,
+                      w*q.y - x*q.z + y*q.w + z*q.x,
+                      w*q.z + x*q.y - y*q.x + z*q.w};
+  }
+
+  /// inverse rotation (for unit quaternions)
+  constexpr Quaternion Conjugate() const {return Quaternion{w,-x,-y,-z};}
+
+  Quaternion Normalized() const
+  {
+    const double norm = std::sqrt(w*w + x*x + y*y + z*z);
+    return Quaternion{w/norm, x/norm, y/norm, z/norm};
+  }
+
+  /// rotation vector (axis * angle in rad) to quaternion
+  static Quaternion FromRotationVector(const double v[3])
+  {
+    const double angle = std::sqrt(v[0]*v[0] + v[1]*v[1] + v[2]*v[2]);
+    const double s = (angle > 1e-12) ? std::sin(0.5*angle)/angle : 0.5;
+    return Quaternion{std::cos(0.5*angle), s*v[0], s*v[1], s*v[2]};
+  }
+
+  /// rotation vector (axis * angle in rad) of the shortest rotation
+  void GetRotationVector(double v[3]) const
+  {
+    const double sign = (w < 0.0) ? -1.0 : 1.0;
+    const double sinHalf = std::sqrt(x*x + y*y + z*z);
+    const double angle = 2.0*std::atan2(sinHalf, sign*w);
+    const double s = (sinHalf > 1e-12) ? sign*angle/sinHalf : 2.0*sign;
+    v[0] = s*x;
+    v[1] = s*y;
+    v[2] = s*z;
+  }
+
+  /// angle of the shortest rotation, in rad [0, pi]
+  double GetAngle() const
+  {
+    return 2.0*std::atan2(std::sqrt(x*x + y*y + z*z), std::abs(w));
+  }
+
+  /// angle (rad) and unit axis of the rotation, the axis is x if there is no rotation
+  void GetAngleAxis(double& angle, double axis[3]) const
+  {
+    const double sinHalf = std::sqrt(x*x + y*y + z*z);
+    angle = 2.0*std::atan2(sinHalf, w);
+    if (sinHalf > 1e-12)
+    {
+      axis[0] = x/sinHalf;
+      axis[1] = y/sinHalf;
+      axis[2] = z/sinHalf;
+    }
+    else
+    {
+      axis[0] = 1.0;
+      axis[1] = axis[2] = 0.0;
+    }
+  }
+
+  /// from the rotation part (R[i][j], i,j < 3) of any row-indexable matrix
+  template <typename Matrix>
+  static Quaternion FromMatrix(const Matrix& R)
+  {
+    Quaternion q;
+    const double trace = R[0][0] + R[1][1] + R[2][2];
+    if (trace > 0.0)
+    {
+      const double s = 0.5 / std::sqrt(trace + 1.0);
+      q.w = 0.25 / s;
+      q.x = (R[2][1] - R[1][2]) * s;
+      q.y = (R[0][2] - R[2][0]) * s;
+      q.z = (R[1][0] - R[0][1]) * s;
+    }
+    else if ((R[0][0] > R[1][1]) && (R[0][0] > R[2][2]))
+    {
+      const double s = 2.0 * std::sqrt(1.0 + R[0][0] - R[1][1] - R[2][2]);
+      q.w = (R[2][1] - R[1][2]) / s;
+      q.x = 0.25 * s;
+      q.y = (R[0][1] + R[1][0]) / s;
+      q.z = (R[0][2] + R[2][0]) / s;
+    }
+    else if (R[1][1] > R[2][2])
+    {
+      const double s = 2.0 * std::sqrt(1.0 + R[1][1] - R[0][0] - R[2][2]);
+      q.w = (R[0][2] - R[2][0]) / s;
+      q.x = (R[0][1] + R[1][0]) / s;
+      q.y = 0.25 * s;
+      q.z = (R[1][2] + R[2][1]) / s;
+    }
+    else
+    {
+      const double s = 2.0 * std::sqrt(1.0 + R[2][2] - R[0][0] - R[1][1]);
+      q.w = (R[1][0] - R[0][1]) / s;
+      q.x = (R[0][2] + R[2][0]) / s;
+      q.y = (R[1][2] + R[2][1]) / s;
+      q.z = 0.25 * s;
+    }
+    return q;
+  }
+
+  /// writes the rotation part (R[i][j], i,j < 3) of any row-indexable matrix
+  template <typename Matrix>
+  void GetMatrix(Matrix& R) const
+  {
+    R[0][0] = 1-2*(y*y+z*z);  R[0][1] = 2*(x*y-w*z);    R[0][2] = 2*(x*z+w*y);
+    R[1][0] = 2*(x*y+w*z);    R[1][1] = 1-2*(x*x+z*z);  R[1][2] = 2*(y*z-w*x);
+    R[2][0] = 2*(x*z-w*y);    R[2][1] = 2*(y*z+w*x);    R[2][2] = 1-2*(x*x+y*y);
+  }
+};
+
+/*  Points in structure-of-arrays form (x[i], y[i], z[i] contiguous), so that transforming a batch
+    is a unit-stride loop the compiler vectorizes.*/
+template <std::size_t Capacity>
+struct PointBatch
+{
+  static constexpr std::size_t GetCapacity(){return Capacity;}
+
+  std::size_t     count = 0;
+  alignas(32) double x[Capacity];
+  alignas(32) double y[Capacity];
+  alignas(32) double z[Capacity];
+};
+
+/*  Rigid transform p' = R p + t in 3x4 matrix form (rotation in mm-free units, translation in mm).
+    Composition, inversion and point transforms are constexpr, so fixed transforms can be
+    evaluated at compile time.*/
+struct RigidTransform
+{
+  double rotation[3][3];
+  double translation[3];
+
+  static constexpr RigidTransform Identity()
+  {
+    return RigidTransform{{{1.0,0.0,0.0},{0.0,1.0,0.0},{0.0,0.0,1.0}},{0.0,0.0,0.0}};
+  }
+
+  static constexpr RigidTransform Translation(double tx, double ty, double tz)
+  {
+    return RigidTransform{{{1.0,0.0,0.0},{0.0,1.0,0.0},{0.0,0.0,1.0}},{tx,ty,tz}};
+  }
+
+  static RigidTransform FromQuaternion(const Quaternion& q, const double t[3])
+  {
+    RigidTransform transform{};
+    q.GetMatrix(transform.rotation);
+    for (unsigned int i=0; i<3; i++)
+      transform.translation[i] = t[i];
+    return transform;
+  }
+
+  /// from the 3x4 upper part (M[i][j], i < 3, j < 4) of any row-indexable matrix
+  template <typename Matrix>
+  static RigidTransform FromMatrix(const Matrix& M)
+  {
+    RigidTransform transform{};
+    for (unsigned int i=0; i<3; i++)
+    {
+      for (unsigned int j=0; j<3; j++)
+        transform.rotation[i][j] = M[i][j];
+      transform.translation[i] = M[i][3];
+    }
+    return transform;
+  }
+
+  /// writes the 3x4 upper part (M[i][j], i < 3, j < 4) of any row-indexable matrix
+  template <typename Matrix>
+  void GetMatrix(Matrix& M) const
+  {
+    for (unsigned int i=0; i<3; i++)
+    {
+      for (unsigned int j=0; j<3; j++)
+        M[i][j] = rotation[i][j];
+      M[i][3] = translation[i];
+    }
+  }
+
+  /// transform b first, then this one
+  constexpr RigidTransform operator*(const RigidTransform& b) const
+  {
+    RigidTransform c{};
+    for (unsigned int i=0; i<3; i++)
+    {
+      for (unsigned int j=0; j<3; j++)
+        c.rotation[i][j] = rotation[i][0]*b.rotation[0][j] + rotation[i][1]*b.rotation[1][j] + rotation[i][2]*b.rotation[2][j];
+      c.translation[i] = rotation[i][0]*b.translation[0] + rotation[i][1]*b.translation[1] + rotation[i][2]*b.translation[2] + translation[i];
+    }
+    return c;
+  }
+
+  /// R^T, -R^T t (the rotation is orthonormal)
+  constexpr RigidTransform Inverse() const
+  {
+    RigidTransform inverse{};
+    for (unsigned int i=0; i<3; i++)
+    {
+      for (unsigned int j=0; j<3; j++)
+        inverse.rotation[i][j] = rotation[j][i];
+      inverse.translation[i] = -(rotation[0][i]*translation[0] + rotation[1][i]*translation[1] + rotation[2][i]*translation[2]);
+    }
+    return inverse;
+  }
+
+  constexpr void TransformPoint(const double in[3], double out[3]) const
+  {
+    const double p0 = in[0], p1 = in[1], p2 = in[2];
+    for (unsigned int i=0; i<3; i++)
+      out[i] = rotation[i][0]*p0 + rotation[i][1]*p1 + rotation[i][2]*p2 + translation[i];
+  }
+
+  constexpr void TransformVector(const double in[3], double out[3]) const
+  {
+    const double v0 = in[0], v1 = in[1], v2 = in[2];
+    for (unsigned int i=0; i<3; i++)
+      out[i] = rotation[i][0]*v0 + rotation[i][1]*v1 + rotation[i][2]*v2;
+  }
+
+  /// n points stored as consecutive x,y,z triplets (in and out may be the same array)
+  void TransformPoints(const double* in, double* out, std::size_t n) const
+  {
+    for (std::size_t p=0; p<n; p++)
+      TransformPoint(in + 3*p, out + 3*p);
+  }
+
+  template <std::size_t Capacity>
+  void TransformPoints(const PointBatch<Capacity>& in, PointBatch<Capacity>& out) const
+  {
+    const std::size_t n = in.count;
+    out.count = n;
+
+    const double r00 = rotation[0][0], r01 = rotation[0][1], r02 = rotation[0][2], t0 = translation[0];
+    const double r10 = rotation[1][0], r11 = rotation[1][1], r12 = rotation[1][2], t1 = translation[1];
+    const double r20 = rotation[2][0], r21 = rotation[2][1], r22 = rotation[2][2], t2 = translation[2];
+
+    for (std::size_t p=0; p<n; p++)
+    {
+      const double x = in.x[p], y = in.y[p], z = in.z[p];
+      out.x[p] = r00*x + r01*y + r02*z + t0;
+      out.y[p] = r10*x + r11*y + r12*z + t1;
+      out.z[p] = r20*x + r21*y + r22*z + t2;
+    }
+  }
+
+  Quaternion GetQuaternion() const
+  {
+    return Quaternion::FromMatrix(rotation).Normalized();
+  }
+
+  /// angle of the rotation, in rad [0, pi]
+  double GetRotationAngle() const
+  {
+    return GetQuaternion().GetAngle();
+  }
+
+  double GetTranslationNorm() const
+  {
+    return std::sqrt(translation[0]*translation[0] + translation[1]*translation[1] + translation[2]*translation[2]);
+  }
+};
+
+#endif // RIGIDTRANSFORM_H
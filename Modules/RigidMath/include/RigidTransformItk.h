@@ -0,0 +1,34 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef RIGIDTRANSFORMITK_H
+#define RIGIDTRANSFORMITK_H
+
+#include <itkMatrixOffsetTransformBase.h>
+
+#include "RigidTransform.h"
+
+/*  Rigid transform applied by an ITK 3D transform (e.g. itk::Rigid3DTransform). The center of
+    rotation is already folded into the ITK offset: p' = M p + offset.*/
+template <typename TParametersValueType>
+inline RigidTransform RigidTransformFromItk(const itk::MatrixOffsetTransformBase<TParametersValueType,3,3>* transform)
+{
+  const auto& matrix = transform->GetMatrix();
+  const auto& offset = transform->GetOffset();
+
+  RigidTransform rigid{};
+  for (unsigned int i=0; i<3; i++)
+  {
+    for (unsigned int j=0; j<3; j++)
+      rigid.rotation[i][j] = matrix[i][j];
+    rigid.translation[i] = offset[i];
+  }
+  return rigid;
+}
+
+#endif // RIGIDTRANSFORMITK_H
@@ -0,0 +1,31 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+#ifndef RIGIDTRANSFORMVTK_H
+#define RIGIDTRANSFORMVTK_H
+
+#include <vtkMatrix4x4.h>
+
+#include "RigidTransform.h"
+
+/// rigid part of a homogeneous VTK matrix (the last row is ignored)
+inline RigidTransform RigidTransformFromVtk(const vtkMatrix4x4* matrix)
+{
+  return RigidTransform::FromMatrix(matrix->Element);
+}
+
+/// writes the transform into an existing VTK matrix, without allocating
+inline void RigidTransformToVtk(const RigidTransform& transform, vtkMatrix4x4* matrix)
+{
+  transform.GetMatrix(matrix->Element);
+  matrix->Element[3][0] = matrix->Element[3][1] = matrix->Element[3][2] = 0.0;
+  matrix->Element[3][3] = 1.0;
+  matrix->Modified();
+}
+
+#endif // RIGIDTRANSFORMVTK_H
@@ -0,0 +1,130 @@
+/*===================================================================
+
+navCAS navigation system
+
+@author: Axel V. A. Mancino (axel.mancino@gmail.com)
+
+===================================================================*/
+
+// Testing
+#include "mitkTestFixture.h"
+#include "mitkTestingMacros.h"
+// VTK includes
+#include <vtkMath.h>
+#include <vtkSmartPointer.h>
+#include <vtkTransform.h>
+// Module includes
+#include "RigidTransform.h"
+#include "RigidTransformVtk.h"
+
+static const double TOLERANCE = 1e-9;
+
+// compile time evaluation
+static constexpr RigidTransform SHIFT = RigidTransform::Translation(1.0,2.0,3.0) * RigidTransform::Translation(-1.0,0.0,1.0);
+static_assert(SHIFT.translation[1] == 2.0 && SHIFT.translation[2] == 4.0, "constexpr composition");
+
+class RigidTransformTestSuite : public mitk::TestFixture
+{
+  CPPUNIT_TEST_SUITE(RigidTransformTestSuite);
+  MITK_TEST(ComposeAndInverse);
+  MITK_TEST(QuaternionRoundTrip);
+  MITK_TEST(BatchMatchesScalar);
+  MITK_TEST(MatchesVtkTransform);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  vtkSmartPointer<vtkTransform>   mVtkTransform;
+  RigidTransform                  mTransform;
+
+public:
+  void setUp() override
+  {
+    mVtkTransform = vtkSmartPointer<vtkTransform>::New();
+    mVtkTransform->Translate(10.0,-5.0,2.5);
+    mVtkTransform->RotateWXYZ(35.0,0.2,-1.0,0.4);
+    mVtkTransform->Update();
+
+    mTransform = RigidTransformFromVtk(mVtkTransform->GetMatrix());
+  }
+
+  void tearDown() override
+  {
+    mVtkTransform = nullptr;
+  }
+
+  void ComposeAndInverse()
+  {
+    const RigidTransform identity = mTransform.Inverse() * mTransform;
+    for (unsigned int i=0; i<3; i++)
+    {
+      for (unsigned int j=0; j<3; j++)
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Rotation of T^-1 T", (i==j) ? 1.0 : 0.0, identity.rotation[i][j], TOLERANCE);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Translation of T^-1 T", 0.0, identity.translation[i], TOLERANCE);
+    }
+
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Rotation angle", vtkMath::RadiansFromDegrees(35.0), mTransform.GetRotationAngle(), TOLERANCE);
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Inverse rotation angle", vtkMath::RadiansFromDegrees(35.0), mTransform.Inverse().GetRotationAngle(), TOLERANCE);
+  }
+
+  void QuaternionRoundTrip()
+  {
+    const RigidTransform copy = RigidTransform::FromQuaternion(mTransform.GetQuaternion(),mTransform.translation);
+    for (unsigned int i=0; i<3; i++)
+      for (unsigned int j=0; j<3; j++)
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Rotation from quaternion", mTransform.rotation[i][j], copy.rotation[i][j], TOLERANCE);
+
+    double v[3];
+    mTransform.GetQuaternion().GetRotationVector(v);
+    const Quaternion q = Quaternion::FromRotationVector(v);
+    const Quaternion difference = q.Conjugate() * mTransform.GetQuaternion();
+    CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Rotation vector round trip", 0.0, difference.GetAngle(), 1e-7);
+  }
+
+  void BatchMatchesScalar()
+  {
+    PointBatch<8> points;
+    points.count = 5;
+    for (unsigned int p=0; p<points.count; p++)
+    {
+      points.x[p] = 1.0 + p;
+      points.y[p] = -2.0*p;
+      points.z[p] = 0.5*p*p;
+    }
+
+    PointBatch<8> transformed;
+    mTransform.TransformPoints(points,transformed);
+    CPPUNIT_ASSERT_EQUAL_MESSAGE("Batch size", points.count, transformed.count);
+
+    for (unsigned int p=0; p<points.count; p++)
+    {
+      const double in[3] = {points.x[p], points.y[p], points.z[p]};
+      double out[3];
+      mTransform.TransformPoint(in,out);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Batch x", out[0], transformed.x[p], TOLERANCE);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Batch y", out[1], transformed.y[p], TOLERANCE);
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Batch z", out[2], transformed.z[p], TOLERANCE);
+    }
+  }
+
+  void MatchesVtkTransform()
+  {
+    const double point[3] = {3.0, -7.0, 12.0};
+    double expected[3];
+    mVtkTransform->TransformPoint(point,expected);
+    double result[3];
+    mTransform.TransformPoint(point,result);
+    for (unsigned int i=0; i<3; i++)
+      CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Point transformed as VTK", expected[i], result[i], TOLERANCE);
+
+    // inverse written back into a vtk matrix
+    vtkSmartPointer<vtkMatrix4x4> inverse = vtkSmartPointer<vtkMatrix4x4>::New();
+    RigidTransformToVtk(mTransform.Inverse(),inverse);
+    vtkSmartPointer<vtkMatrix4x4> expectedInverse = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkMatrix4x4::Invert(mVtkTransform->GetMatrix(),expectedInverse);
+    for (unsigned int i=0; i<4; i++)
+      for (unsigned int j=0; j<4; j++)
+        CPPUNIT_ASSERT_DOUBLES_EQUAL_MESSAGE("Inverse as VTK", expectedInverse->GetElement(i,j), inverse->GetElement(i,j), TOLERANCE);
+  }
+};
+
+MITK_TEST_SUITE_REGISTRATION(RigidTransform)
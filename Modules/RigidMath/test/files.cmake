@@ -0,0 +1,5 @@
+set(MODULE_TESTS
+  RigidTransformTest.cpp
+)
+SET(MODULE_CUSTOM_TESTS
+)
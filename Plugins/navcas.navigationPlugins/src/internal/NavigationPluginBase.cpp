@@ -15,12 +15,16 @@ navCAS navigation system
 
 // Qt
 #include <QMessageBox>
+#include <QTimer>
+#include <QSettings>
 
 // Vtk
 #include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
 #include <vtkPolyData.h>
 #include <vtkCellLocator.h>
+#include <vtkCallbackCommand.h>
+#include <vtkRenderWindow.h>
 
 // Mitk
 #include <mitkDataNode.h>
@@ -28,6 +32,7 @@ navCAS navigation system
 #include <mitkImage.h>
 #include <mitkNodePredicateProperty.h>
 #include <mitkLayoutAnnotationRenderer.h>
+#include <mitkRenderingManager.h>
 
 // qmitk
 #include <QmitkRenderWindow.h>
@@ -35,6 +40,7 @@ navCAS navigation system
 #include <navAPI.h>
 #include "NavigationPluginBase.h"
 #include "ViewCommands.h"
+#include "IOCommands.h"
 
 using namespace std;
 
@@ -42,17 +48,43 @@ NavigationPluginBase::NavigationPluginBase():
   mMoveCrosshair(false),
   mCameraConnected(false),
   mCancelCameraConection(false),
-  mProbeRepetitions(10)
+  mNavigationType(Traditional),
+  mVerboseConnection(false),
+  mDisplayedTracker(navAPI::None),
+  mProbeRepetitions(10),
+  mAveragingProbe(false),
+  mLatencyPending(false),
+  mPendingPublishTime(0),
+  mSceneUpdateTime(0)
 {
   mNodesManager = new NodesManager(GetDataStorage());
   mAPI = new navAPI;
 
+  // the camera is connected in the background, its state changes arrive through queued signals
+  mCameraConnection = new CameraConnectionManager(mAPI);
+  connect(mCameraConnection,SIGNAL(StateChanged(int)),this,SLOT(OnCameraStateChanged(int)));
+
   mNodesManager->LoadMarkersGeometries();
   mNodesManager->CreateMarkers();
   mNodesManager->ShowAllFiducials(false);
   mNodesManager->ShowAllProbes(false);
 
   mRegistrationTransformation = vtkSmartPointer<vtkMatrix4x4>::New();
+  mRelativeMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  mRegisteredMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  mFilteredMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  mFilterClock.start();
+  mLevelOfDetail.SetDataStorage(GetDataStorage());
+
+  // poses are pulled from navAPI once per display refresh
+  mRenderTimer = new QTimer(this);
+  mRenderTimer->setInterval(RENDER_PERIOD);
+  connect(mRenderTimer,SIGNAL(timeout()),this,SLOT(OnRenderTick()));
+
+  // the render of the 3D window closes the latency samples (see ObserveRenderingEnd)
+  mRenderingEndCommand = vtkSmartPointer<vtkCallbackCommand>::New();
+  mRenderingEndCommand->SetCallback(&NavigationPluginBase::RenderingEndCallback);
+  mRenderingEndCommand->SetClientData(this);
 }
 
 NavigationPluginBase::~NavigationPluginBase()
@@ -60,7 +92,10 @@ NavigationPluginBase::~NavigationPluginBase()
   cout << "Plugin base destructor called" << std::endl;
 
   StopNavigation();
+  ObserveRenderingEnd(nullptr);
 
+  // waits for the camera to be closed
+  delete mCameraConnection;
   delete mAPI;
 
   if (mNodesManager != nullptr)
@@ -72,7 +107,6 @@ void NavigationPluginBase::ConnectNavigationActionsAndFunctions()
   connect(mAPI, SIGNAL(MultipleMarkersInView(std::vector<navAPI::MarkerId>)), this, SLOT(OnMultipleMarkersInView(std::vector<navAPI::MarkerId>)));
   connect(mAPI, SIGNAL(SingleMarkerInView(navAPI::MarkerId)), this, SLOT(OnSingleMarkerInView(navAPI::MarkerId)));
 	connect(mAPI, SIGNAL(MultipleOrNullMarkersInView()), this, SLOT(OnMultipleOrNullMarkersInView()));
-	connect(mAPI, SIGNAL(MarkerRelativePosition(unsigned int, vtkMatrix4x4*)), this, SLOT(UpdateRelativeMarker(unsigned int, vtkMatrix4x4*)));
 	connect(mAPI, SIGNAL(ValidProbeInView()), this, SLOT(OnValidProbeInView()));
 	connect(mAPI, SIGNAL(InvalidProbeInView()), this, SLOT(OnInvalidProbeInView()));
 }
@@ -81,26 +115,30 @@ bool NavigationPluginBase::IsReadyToNavigate()
 {
   // Registration transform is loaded from valid patient
   // bug: should differentiate registration from navigation
-  mitk::NodePredicateProperty::Pointer pred = mitk::NodePredicateProperty::New("navCAS.registration.isReferencePatientImage",mitk::BoolProperty::New(true));
-  mitk::DataStorage::SetOfObjects::ConstPointer so = GetDataStorage()->GetSubset(pred);
+  NodeRoleRegistry* roles = mNodesManager->GetRoleRegistry();
+  mitk::DataNode* referenceImage = roles->GetNode(NodeRoleRegistry::ReferenceImage);
 
-  if (so->size() != 1)
+  if (referenceImage == nullptr)
   {
-    cout << "Found " << so->size() << " current registration images" << std::endl;
+    cout << "Found " << roles->GetNumberOfNodes(NodeRoleRegistry::ReferenceImage) << " current registration images" << std::endl;
     return false;
   }
 
   bool isRegistered = false;
-  so->Begin()->Value()->GetBoolProperty("navCAS.registration.isRegistered",isRegistered);
+  referenceImage->GetBoolProperty("navCAS.registration.isRegistered",isRegistered);
 
   if (!isRegistered)
     return false;
 
-  mRegistrationTransformation = mNodesManager->GetTransformFromNode(so->Begin()->Value());
+  vtkMatrix4x4* transform = roles->GetTransform(NodeRoleRegistry::ReferenceImage);
 
-  if (mRegistrationTransformation == nullptr)
+  if (transform == nullptr)
     return false;
 
+  // the registry updates its matrix in place, navigation keeps the one it was started with
+  mRegistrationTransformation = vtkSmartPointer<vtkMatrix4x4>::New();
+  mRegistrationTransformation->DeepCopy(transform);
+
   return true;
 }
 
@@ -121,6 +159,16 @@ void NavigationPluginBase::CheckValidRenderWindow()
 
   mNodesManager->SetRenderWindow(axial,coronal,sagittal);
 
+  QmitkRenderWindow* threeD = GetRenderWindowPart(mitk::WorkbenchUtil::OPEN)->GetQmitkRenderWindow("3d");
+  std::vector<vtkRenderWindow*> windows;
+  windows.push_back(axial->GetVtkRenderWindow());
+  windows.push_back(coronal->GetVtkRenderWindow());
+  windows.push_back(sagittal->GetVtkRenderWindow());
+  windows.push_back(threeD->GetVtkRenderWindow());
+  mRenderScheduler.SetRenderWindows(windows);
+  mLevelOfDetail.SetRenderer(threeD->GetRenderer());
+  ObserveRenderingEnd(threeD->GetVtkRenderWindow());
+
   connect(axial, SIGNAL(destroyed(QObject*)), this, SLOT(RenderWindowClosed()));
 
   Hide3DCrosshair();
@@ -138,6 +186,12 @@ void NavigationPluginBase::RenderWindowClosed()
   std::cout << "Render window destroyed" << std::endl;
 
   mNodesManager->SetRenderWindow(nullptr,nullptr,nullptr);
+  mRenderScheduler.SetRenderWindows(std::vector<vtkRenderWindow*>());
+
+  // the 3D renderer is being destroyed with its window
+  mLevelOfDetail.Clear();
+  mLevelOfDetail.SetRenderer(nullptr);
+  ObserveRenderingEnd(nullptr);
 }
 
 
@@ -147,63 +201,46 @@ bool NavigationPluginBase::StartNavigation(bool verbose, NavigationType type)
   //setlocale(LC_ALL,"C");
 	std::cout << "Checking decimal precision: " << std::atof("1.2345") << std::endl;
   mCameraConnected=false;
-
-  if (!mAPI->InitializeCamera())
-  {
-    if (verbose)
-    {
-      QMessageBox msgBox;
-      msgBox.setText("No camera detected!");
-      msgBox.setInformativeText("Please make sure the navigation camera is correctly plugged in.");
-      msgBox.setIcon(QMessageBox::Critical);
-      msgBox.exec();
-    }
-    return false;
-  }
+  mRenderTimer->stop();
 
   if (type == NavigationType::Traditional)
   {
     // Hide instrument node
-    // to do: get instrument from NodesManager
-    mitk::NodePredicateProperty::Pointer pred = mitk::NodePredicateProperty::New("navCAS.isInstrument",mitk::BoolProperty::New(true));
-    mitk::DataStorage::SetOfObjects::ConstPointer so = GetDataStorage()->GetSubset(pred);
-    if (so->size() == 1)
-      so->Begin()->Value()->SetVisibility(false);
+    mitk::DataNode* instrument = mNodesManager->GetRoleRegistry()->GetNode(NodeRoleRegistry::Instrument);
+    if (instrument != nullptr)
+      instrument->SetVisibility(false);
   }
 	
   // Hide moving surface in 2D if application is TMS (for dissociated navigation should not do this)
-  auto pred = mitk::NodePredicateProperty::New("navCAS.isMovingMarkerSurface",mitk::BoolProperty::New(true));
-  auto so = GetDataStorage()->GetSubset(pred);
-  if (so->size() == 1)
+  mitk::DataNode* movingSurface = mNodesManager->GetRoleRegistry()->GetNode(NodeRoleRegistry::MovingMarkerSurface);
+  if (movingSurface != nullptr)
   {
     mitk::BaseRenderer* axial = GetRenderWindowPart()->GetQmitkRenderWindow("axial")->GetRenderer();
     mitk::BaseRenderer* coronal = GetRenderWindowPart()->GetQmitkRenderWindow("coronal")->GetRenderer();
     mitk::BaseRenderer* sagittal = GetRenderWindowPart()->GetQmitkRenderWindow("sagittal")->GetRenderer();
-    so->Begin()->Value()->SetVisibility(false,axial);
-    so->Begin()->Value()->SetVisibility(false,coronal);
-    so->Begin()->Value()->SetVisibility(false,sagittal);
+    movingSurface->SetVisibility(false,axial);
+    movingSurface->SetVisibility(false,coronal);
+    movingSurface->SetVisibility(false,sagittal);
   }
 
   // load geometries according to navigation type
+  std::vector<navAPI::MarkerId> geometries;
   if ((Traditional == type) || (RegistrationInstrument == type) || (RegistrationPatient == type))
   {
-    // Add geometries and start navigation
-    mAPI->AddGeometry(navAPI::Probe);
-    mAPI->AddGeometry(navAPI::SmallTracker);
-    mAPI->AddGeometry(navAPI::MediumTracker);
-    mAPI->AddGeometry(navAPI::BigTracker);
-    //mAPI->AddGeometry(navAPI::LineProbe);
+    geometries.push_back(navAPI::Probe);
+    geometries.push_back(navAPI::SmallTracker);
+    geometries.push_back(navAPI::MediumTracker);
+    geometries.push_back(navAPI::BigTracker);
+    //geometries.push_back(navAPI::LineProbe);
   }
   else if (Calibration == type)
   {
-    mAPI->AddGeometry(navAPI::MediumTracker);
-    mAPI->AddGeometry(navAPI::BigTracker);
-    mAPI->AddGeometry(navAPI::TemporalProbe);
-    //mAPI->AddGeometry(navAPI::TemporalLineProbe);
+    geometries.push_back(navAPI::MediumTracker);
+    geometries.push_back(navAPI::BigTracker);
+    geometries.push_back(navAPI::TemporalProbe);
+    //geometries.push_back(navAPI::TemporalLineProbe);
   }
 
-  mAPI->start();
-
   // Update nodesManager members according to systemSetup node in datastorage
   mNodesManager->UpdateNavigationConfiguration();
 
@@ -213,26 +250,97 @@ bool NavigationPluginBase::StartNavigation(bool verbose, NavigationType type)
   else
     mAPI->SetReferenceMarker(mNodesManager->GetReferenceMarker());
 
-  mCameraConnected=true;
+  // a single tracker is shown as moving marker: the instrument, or the patient marker while the instrument is the reference
+  mDisplayedTracker = (type == RegistrationInstrument) ? mNodesManager->GetReferenceMarker() : mNodesManager->GetMovingMarker();
 
-  // disable 2D views interaction
-  GetRenderWindowPart()->GetQmitkRenderWindow("axial")->GetVtkRenderWindow()->GetInteractor()->Disable();
-  GetRenderWindowPart()->GetQmitkRenderWindow("coronal")->GetVtkRenderWindow()->GetInteractor()->Disable();
-  GetRenderWindowPart()->GetQmitkRenderWindow("sagittal")->GetVtkRenderWindow()->GetInteractor()->Disable();
+  // detection, connection and geometries are handled by the connection thread (see OnCameraStateChanged)
+  mNavigationType = type;
+  mVerboseConnection = verbose;
+  mCameraConnection->Connect(geometries);
 
   return true;
 }
 
+void NavigationPluginBase::OnCameraStateChanged(int state)
+{
+  // states are queued: a stale transition must not restart a closed connection
+  const CameraConnectionManager::State current = mCameraConnection->GetState();
+
+  if ((state == CameraConnectionManager::Streaming) && (current == CameraConnectionManager::Streaming) &&
+      mCameraConnection->IsConnectionRequested())
+  {
+    if (!mCameraConnected)
+    {
+      // ignore poses left from a previous session
+      mAPI->GetSnapshotBuffer().Clear();
+      mRenderScheduler.Reset();
+      mNodesManager->SetRenderScheduler(&mRenderScheduler);
+      ConfigurePoseFilters(mNavigationType);
+      ConfigureLevelOfDetail();
+
+      // keep every frame of the session for post-op review (a reconnection continues the same log)
+      QString trackingLog = IOCommands::GetNewTrackingLogPath();
+      if (!mAPI->IsRecording() && !trackingLog.isEmpty() && (mNavigationType != Calibration))
+        mAPI->StartRecording(trackingLog.toStdString());
+
+      mRenderTimer->start();
+      mCameraConnected=true;
+      mVerboseConnection=false;
+
+      // disable 2D views interaction
+      GetRenderWindowPart()->GetQmitkRenderWindow("axial")->GetVtkRenderWindow()->GetInteractor()->Disable();
+      GetRenderWindowPart()->GetQmitkRenderWindow("coronal")->GetVtkRenderWindow()->GetInteractor()->Disable();
+      GetRenderWindowPart()->GetQmitkRenderWindow("sagittal")->GetVtkRenderWindow()->GetInteractor()->Disable();
+
+      WaitCursorOff();
+    }
+  }
+  else if ((current != CameraConnectionManager::Streaming) && mCameraConnected)
+  {
+    // connection lost or closed: poses are no longer updated
+    mRenderTimer->stop();
+    mLatencyPending = false;
+    mCameraConnected=false;
+
+    if (mLevelOfDetail.Restore())
+      mitk::RenderingManager::GetInstance()->RequestUpdate(mLevelOfDetail.GetRenderer()->GetRenderWindow());
+  }
+
+  CameraStateChanged(static_cast<CameraConnectionManager::State>(state));
+
+  // only the first failed attempt of a verbose request is reported, later attempts are silent
+  if ((state == CameraConnectionManager::WaitingForCamera) && mVerboseConnection)
+  {
+    mVerboseConnection = false;
+
+    QMessageBox msgBox;
+    msgBox.setText("No camera detected!");
+    msgBox.setInformativeText("Please make sure the navigation camera is correctly plugged in.");
+    msgBox.setIcon(QMessageBox::Critical);
+    msgBox.exec();
+  }
+}
+
 void NavigationPluginBase::StopNavigation()
 {
-  mAPI->StopNavigation();
+  mRenderTimer->stop();
+  mLatencyPending = false;
+  mVerboseConnection = false;
+
+  // the acquisition thread is stopped and the camera closed in the background (see OnCameraStateChanged)
+  mCameraConnection->Disconnect();
+  mCameraConnected = false;
+  mAPI->StopRecording();
   WaitCursorOff();
 
-	if (mAPI->CloseCamera())
-		cout << "Camera closed succesfully" << std::endl;
+  if (mLevelOfDetail.Restore())
+    mitk::RenderingManager::GetInstance()->RequestUpdate(mLevelOfDetail.GetRenderer()->GetRenderWindow());
 
   if (mNodesManager != nullptr)
   {
+    // the render tick is stopped: the probe 2D renders are requested directly again
+    if (mNodesManager->GetRenderScheduler() == &mRenderScheduler)
+      mNodesManager->SetRenderScheduler(nullptr);
     mNodesManager->HideProbe2D();
     mNodesManager->ShowAllProbes(false);
     mNodesManager->ShowAllFiducials(false);
@@ -249,13 +357,208 @@ void NavigationPluginBase::StopNavigation()
   GetRenderWindowPart()->GetQmitkRenderWindow("sagittal")->GetVtkRenderWindow()->GetInteractor()->Enable();
 }
 
+int NavigationPluginBase::GetDisplayRole(uint32_t geometryId) const
+{
+  switch (geometryId)
+  {
+  case navAPI::SmallTracker:
+  case navAPI::MediumTracker:
+  case navAPI::BigTracker:
+    // without a configured tracker, the first one of each snapshot is shown (see OnRenderTick)
+    return ((mDisplayedTracker == navAPI::None) || (geometryId == static_cast<uint32_t>(mDisplayedTracker))) ? 1 : -1;
+
+  case navAPI::Probe:
+  case navAPI::TemporalProbe:
+    return 2;
+
+  default:
+    return -1;
+  }
+}
+
+void NavigationPluginBase::ConfigurePoseFilters(NavigationType type)
+{
+  const char* modes[] = {"Traditional","Calibration","RegistrationPatient","RegistrationInstrument"};
+
+  QSettings settings("CAS","navCAS");
+  settings.beginGroup("Pose filter");
+
+  // only the navigation smooths the probe by default, calibration and registrations use raw poses
+  const int defaultType = (type == Traditional) ? PoseFilter::OneEuro : PoseFilter::NoFilter;
+  const int filterType = settings.value(QString(modes[type]) + "/Type", defaultType).toInt();
+  const double prediction = settings.value(QString(modes[type]) + "/Prediction ms", 0.0).toDouble();
+
+  const double minCutoff = settings.value("One Euro min cutoff", 1.0).toDouble();
+  const double beta = settings.value("One Euro beta", 0.05).toDouble();
+  const double rotationBeta = settings.value("One Euro rotation beta", 0.5).toDouble();
+  const double derivativeCutoff = settings.value("One Euro derivative cutoff", 1.0).toDouble();
+
+  const double positionNoise = settings.value("Kalman position noise", 0.1).toDouble();
+  const double orientationNoise = settings.value("Kalman orientation noise", 0.002).toDouble();
+  const double acceleration = settings.value("Kalman acceleration", 100.0).toDouble();
+  const double angularAcceleration = settings.value("Kalman angular acceleration", 2.0).toDouble();
+  settings.endGroup();
+
+  for (PoseFilter& filter : mPoseFilter)
+  {
+    filter.SetType((filterType >= PoseFilter::NoFilter) && (filterType <= PoseFilter::Kalman) ? static_cast<PoseFilter::FilterType>(filterType) : PoseFilter::NoFilter);
+    filter.SetOneEuroParameters(minCutoff,beta,rotationBeta,derivativeCutoff);
+    filter.SetKalmanParameters(positionNoise,orientationNoise,acceleration,angularAcceleration);
+    filter.SetPredictionHorizon(prediction);
+    filter.Reset();
+  }
+
+  cout << "Pose filter for " << modes[type] << ": type " << filterType << ", prediction " << prediction << " ms" << std::endl;
+}
+
+void NavigationPluginBase::ConfigureLevelOfDetail()
+{
+  QSettings settings("CAS","navCAS");
+  settings.beginGroup("Level of detail");
+
+  // integrated GPUs cannot redraw the full resolution surfaces at the tracking rate
+  mLevelOfDetail.SetEnabled(settings.value("Enabled", true).toBool());
+  mLevelOfDetail.SetDwellTime(settings.value("Dwell time ms", 500.0).toDouble()/1000.0);
+  mLevelOfDetail.SetMotionThreshold(settings.value("Motion threshold mm", 1.0).toDouble(), settings.value("Motion threshold deg", 1.0).toDouble());
+  settings.endGroup();
+
+  mLevelOfDetail.Restore();
+}
+
+void NavigationPluginBase::UpdateLevelOfDetail()
+{
+  if (mLevelOfDetail.Update(mFilterClock.nsecsElapsed()*1e-9))
+    mRenderScheduler.WindowChanged(mLevelOfDetail.GetRenderer()->GetRenderWindow());
+}
+
+LatencyMonitor& NavigationPluginBase::GetLatencyMonitor()
+{
+  static LatencyMonitor monitor;
+  return monitor;
+}
+
+void NavigationPluginBase::ObserveRenderingEnd(vtkRenderWindow* window)
+{
+  // the window may already be destroyed (weak pointer)
+  if (mLatencyWindow != nullptr)
+    mLatencyWindow->RemoveObserver(mRenderingEndCommand);
+
+  mLatencyWindow = window;
+  mLatencyPending = false;
+
+  if (window != nullptr)
+    window->AddObserver(vtkCommand::EndEvent, mRenderingEndCommand);
+}
+
+void NavigationPluginBase::RenderingEndCallback(vtkObject*, unsigned long, void* clientData, void*)
+{
+  static_cast<NavigationPluginBase*>(clientData)->OnRenderingEnd();
+}
+
+void NavigationPluginBase::OnRenderingEnd()
+{
+  if (!mLatencyPending)
+    return;
+
+  const uint64_t now = LatencyMonitor::Now();
+  GetLatencyMonitor().AddSample(LatencyMonitor::SceneUpdateToRender, static_cast<double>(now - mSceneUpdateTime));
+  GetLatencyMonitor().AddSample(LatencyMonitor::PublishToRender, static_cast<double>(now - mPendingPublishTime));
+  mLatencyPending = false;
+}
+
+void NavigationPluginBase::OnRenderTick()
+{
+  // every snapshot since the previous tick goes through the filters, the last poses are displayed
+  bool pending[3] = {false, false, false};
+  while (mAPI->GetSnapshotBuffer().Pop(mSnapshot))
+  {
+    // one pose per display node and snapshot
+    bool seen[3] = {false, false, false};
+
+    for (unsigned int p=0; p<mSnapshot.posesCount; p++)
+    {
+      const unsigned int slot = mSnapshot.poseSlot[p];
+      const PoseRecord& record = mSnapshot.poses[p];
+
+      // tools without a scene representation are still tracked and recorded
+      const int role = GetDisplayRole(record.markerId);
+      if ((role < 0) || seen[role])
+        continue;
+      seen[role] = true;
+
+      const unsigned int m = static_cast<unsigned int>(role);
+      mTickRecord[m] = record;
+      pending[m] = true;
+
+      // averaged acquisitions need the raw probe position
+      if (mAveragingProbe && (m == 2))
+      {
+        mPoseFilter[slot].Reset();
+        continue;
+      }
+
+      // device time if available, otherwise the publication time (every frame of the tick is read now)
+      const double time = (record.timestamp != 0) ? record.timestamp*1e-6 : record.publishTime*1e-6;
+      mPoseFilter[slot].Update(record.pose,time,mTickPose[m]);
+    }
+  }
+
+  for (unsigned int m=0; m<3; m++)
+  {
+    if (!pending[m])
+      continue;
+
+    const PoseRecord& record = mTickRecord[m];
+
+    const uint64_t deliveryTime = LatencyMonitor::Now();
+    GetLatencyMonitor().AddCaptureSample(record.timestamp,record.publishTime);
+    GetLatencyMonitor().AddSample(LatencyMonitor::PublishToDelivery, static_cast<double>(deliveryTime - record.publishTime));
+
+    for (unsigned int i=0; i<3; i++)
+      for (unsigned int j=0; j<4; j++)
+        mRelativeMatrix->SetElement(i,j,record.pose[i][j]);
+
+    if (mAveragingProbe && (m == 2))
+      UpdateRelativeMarker(m,mRelativeMatrix);
+    else
+    {
+      for (unsigned int i=0; i<3; i++)
+        for (unsigned int j=0; j<4; j++)
+          mFilteredMatrix->SetElement(i,j,mTickPose[m][i][j]);
+
+      UpdateRelativeMarker(m,mFilteredMatrix);
+    }
+
+    GetLatencyMonitor().AddSample(LatencyMonitor::DeliveryToSceneUpdate, static_cast<double>(mSceneUpdateTime - deliveryTime));
+
+    // the oldest pose of the tick is on screen after the next render of the 3D window
+    if (!mLatencyPending && (mLatencyWindow != nullptr))
+    {
+      mLatencyPending = true;
+      mPendingPublishTime = record.publishTime;
+    }
+
+    // listeners (e.g. calibration) get the unfiltered pose
+    emit RelativeMarkerUpdated(m,mRelativeMatrix);
+
+    if (mAveragingProbe && (m == 2) && (record.markerId == navAPI::Probe))
+      OnAddAcquisition();
+  }
+
+  // all the poses of the tick are rendered together (the full resolution comes back once the tools
+  // are still, even without new frames)
+  UpdateLevelOfDetail();
+  FlushRender();
+}
+
 void NavigationPluginBase::UpdateRelativeMarker(unsigned int m, vtkMatrix4x4* matrix)
 {
   // Transform position using registration matrix
-  vtkSmartPointer<vtkMatrix4x4> registeredMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  vtkMatrix4x4::Multiply4x4(mRegistrationTransformation,matrix,registeredMatrix);
+  vtkMatrix4x4::Multiply4x4(mRegistrationTransformation,matrix,mRegisteredMatrix);
 
-  mNodesManager->UpdateRelativeMarker(m,registeredMatrix);
+  mNodesManager->UpdateRelativeMarker(m,mRegisteredMatrix);
+  mSceneUpdateTime = LatencyMonitor::Now();
+  mLevelOfDetail.AddPose(m,mRegisteredMatrix,mFilterClock.nsecsElapsed()*1e-9);
 
   // probe
   if (m == 2)
@@ -265,11 +568,24 @@ void NavigationPluginBase::UpdateRelativeMarker(unsigned int m, vtkMatrix4x4* ma
     mProbeDirection = mNodesManager->GetProbeDirection();
     //cout << "Probe position: " << mProbeLastPosition << std::endl;
 
-    // move crosshair
+    // move crosshair (applied once per refresh by OnRenderTick)
 		if (mMoveCrosshair)
-			GetRenderWindowPart()->SetSelectedPosition(mProbeLastPosition);
+			mRenderScheduler.SetSelectedPosition(mProbeLastPosition);
   }
-  mitk::RenderingManager::GetInstance()->RequestUpdateAll();
+
+  mMovedNodes.clear();
+  mNodesManager->GetMarkerNodes(m,mMovedNodes);
+  for (mitk::DataNode* node : mMovedNodes)
+    mRenderScheduler.NodeChanged(node);
+}
+
+void NavigationPluginBase::FlushRender()
+{
+  mitk::Point3D crosshair;
+  if (mRenderScheduler.TakeSelectedPosition(crosshair))
+    GetRenderWindowPart()->SetSelectedPosition(crosshair);
+
+  mRenderScheduler.Flush();
 }
 
 void NavigationPluginBase::SilentlyRetryCameraConnection()
@@ -277,14 +593,16 @@ void NavigationPluginBase::SilentlyRetryCameraConnection()
   if ( !GetSite()->GetPage()->IsPartVisible(GetSite()->GetPage()->FindView(GetSite()->GetId())) )
     return;
 
-  if (!mCameraConnected)
+  // the connection manager already retries until the camera is available
+  if (mCameraConnected || mCameraConnection->IsConnectionRequested())
   {
-    //try to silently connect camera
-    if (!StartNavigation(false))
-      QTimer::singleShot(1000,this,SLOT(SilentlyRetryCameraConnection()));
-    else
-      WaitCursorOff();
+    WaitCursorOff();
+    return;
   }
+
+  // navigation could not start (e.g. missing configuration): try again later
+  if (!StartNavigation(false))
+    QTimer::singleShot(1000,this,SLOT(SilentlyRetryCameraConnection()));
   else
     WaitCursorOff();
 }
@@ -295,7 +613,7 @@ void NavigationPluginBase::AverageProbeAcquisitions(int repetitions)
   mProbeRepetitions = repetitions;
 
   mCurrentAcquisitionPoint.Fill(0.0);
-  connect(mAPI, SIGNAL(ValidProbeInView()), this, SLOT(OnAddAcquisition()));
+  mAveragingProbe = true;
 }
 
 void NavigationPluginBase::OnAddAcquisition()
@@ -305,7 +623,7 @@ void NavigationPluginBase::OnAddAcquisition()
   mAcquisitionPoints.push_back(mProbeLastPosition);
   if (++repetitions == mProbeRepetitions)
   {
-    disconnect(mAPI, SIGNAL(ValidProbeInView()), this, SLOT(OnAddAcquisition()));
+    mAveragingProbe = false;
 
     // average point acquisitions
     for (int i=0; i<3; i++)
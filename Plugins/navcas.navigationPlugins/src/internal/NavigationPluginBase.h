@@ -13,6 +13,17 @@ navCAS navigation system
 #include <QmitkAbstractView.h>
 
 #include <navAPI.h>
+#include <CameraConnectionManager.h>
+#include <PoseFilter.h>
+#include <LatencyMonitor.h>
+
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <vtkCallbackCommand.h>
+#include <vtkSmartPointer.h>
+#include <vtkWeakPointer.h>
+class vtkRenderWindow;
 
 #include <mitkPointSet.h>
 #include <mitkILifecycleAwarePart.h>
@@ -20,6 +31,8 @@ navCAS navigation system
 #include "navcas_navigationPlugins_Export.h"
 
 #include "NodesManager.h"
+#include "RenderScheduler.h"
+#include "LevelOfDetailSwitcher.h"
 
 using namespace std;
 
@@ -41,13 +54,22 @@ protected:
 	void SetMoveCrosshair(bool val) { mMoveCrosshair = val; }
   void Hide3DCrosshair();
 
+  /// latency statistics of the tracking-to-render path, shared by all navigation views
+  static LatencyMonitor& GetLatencyMonitor();
+
 protected slots:
+  /*  Prepares the scene and requests the camera connection, which continues in the background.
+      Returns false if navigation cannot start (the camera being unavailable is not a failure).*/
   virtual bool StartNavigation(bool verbose=true, NavigationType=Traditional);
 
   /// stops navigation thread and hides all probes and markers
   void StopNavigation();
   void SilentlyRetryCameraConnection();
+  void OnCameraStateChanged(int state);
   void UpdateRelativeMarker(unsigned int,vtkMatrix4x4* matrix);
+
+  /// filters every snapshot published by navAPI since the last tick and updates the scene with the last poses
+  void OnRenderTick();
   void RenderWindowClosed();
   void CheckValidRenderWindow();
 
@@ -59,6 +81,13 @@ protected slots:
 
   virtual void NewAveragedAcquisition(const mitk::Point3D /*point*/, double /*sd*/, int /*rep*/){}
 
+  /// called on the GUI thread after every camera connection state change
+  virtual void CameraStateChanged(CameraConnectionManager::State /*state*/){}
+
+signals:
+  /// emitted on the GUI thread after the scene was updated with a new marker pose
+  void RelativeMarkerUpdated(unsigned int,vtkMatrix4x4*);
+
 protected:
 	void ConnectNavigationActionsAndFunctions();
   void AverageProbeAcquisitions(int repetitions);
@@ -68,25 +97,85 @@ protected:
 	bool																	mMoveCrosshair;
 
   navAPI*                               mAPI;
+  CameraConnectionManager*              mCameraConnection;
   navAPI::MarkerId                      mSingleMarkerType;
   mitk::Point3D                         mProbeLastPosition;
   mitk::Vector3D                        mProbeDirection;
   NodesManager*                         mNodesManager;
   vtkSmartPointer<vtkMatrix4x4>         mRegistrationTransformation;
 
-private slots:
+private:
   void OnAddAcquisition();
 
-private:
+  /// marker role used by NodesManager for a tracked geometry (1 = moving marker, 2 = probe), -1 if not displayed.
+  /// NodesManager has a single moving marker: only mDisplayedTracker is shown, other trackers are tracked and recorded.
+  int GetDisplayRole(uint32_t geometryId) const;
+
+  /// reads the pose filter and prediction of the navigation type from the settings
+  void ConfigurePoseFilters(NavigationType type);
+
+  /// reads the level of detail switching of the 3D view from the settings
+  void ConfigureLevelOfDetail();
+
+  /// switches the resolution of the 3D surfaces according to the tools motion
+  void UpdateLevelOfDetail();
+
+  /// completes the latency sample of the last updated pose once it is on screen
+  void OnRenderingEnd();
+  /// the latency samples are closed by the renders of this window only (the 3D window, which shows every tracked tool)
+  void ObserveRenderingEnd(vtkRenderWindow* window);
+  static void RenderingEndCallback(vtkObject* caller, unsigned long event, void* clientData, void* callData);
+
+  /// moves the crosshair and requests the render of the windows changed by the updated poses
+  void FlushRender();
+
+  static const int              RENDER_PERIOD = 16;  // ms (~60 Hz)
 
   bool                          mCameraConnected;
   bool                          mCancelCameraConection;
 
+  // navigation requested to the connection manager
+  NavigationType                mNavigationType;
+  bool                          mVerboseConnection;
+
+  // tracker shown by the moving marker display (None: the first tracker of each snapshot)
+  navAPI::MarkerId              mDisplayedTracker;
+
   // points average
   std::vector<mitk::Point3D>    mAcquisitionPoints;
   mitk::Point3D                 mCurrentAcquisitionPoint;
   double                        mCurrentAcquisitionPointSd;
   int                           mProbeRepetitions;
+  bool                          mAveragingProbe;
+
+  // poses pulled from navAPI at render time
+  QTimer*                       mRenderTimer;
+  vtkSmartPointer<vtkMatrix4x4> mRelativeMatrix;
+  vtkSmartPointer<vtkMatrix4x4> mRegisteredMatrix;
+
+  /// last snapshot read from navAPI, and per display node the last pose of the tick (filtered)
+  TrackingSnapshot              mSnapshot;
+  PoseRecord                    mTickRecord[3];
+  double                        mTickPose[3][3][4];
+
+  // smoothing/prediction between navAPI and NodesManager (one per tool slot)
+  PoseFilter                    mPoseFilter[navAPI::MAX_TOOLS];
+  vtkSmartPointer<vtkMatrix4x4> mFilteredMatrix;
+  QElapsedTimer                 mFilterClock;
+
+  // one render request per window and display refresh
+  RenderScheduler               mRenderScheduler;
+  std::vector<mitk::DataNode*>  mMovedNodes;
+
+  // low resolution 3D surfaces while the tools move
+  LevelOfDetailSwitcher         mLevelOfDetail;
+
+  // latency sample waiting for the render to finish (host times, see LatencyMonitor::Now)
+  bool                          mLatencyPending;
+  uint64_t                      mPendingPublishTime;
+  uint64_t                      mSceneUpdateTime;
+  vtkWeakPointer<vtkRenderWindow>       mLatencyWindow;
+  vtkSmartPointer<vtkCallbackCommand>   mRenderingEndCommand;
 };
 
 #endif
@@ -15,6 +15,7 @@ navCAS navigation system
 
 // Qt
 #include <QMessageBox>
+#include <QTimer>
 #include <QInputDialog>
 #include <QtSql>
 #include <QFileDialog>
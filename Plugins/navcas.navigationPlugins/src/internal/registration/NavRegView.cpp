@@ -47,7 +47,8 @@ NavRegView::NavRegView() :
   mIsNavigating(false),
   mAcceptedRegistration(false),
   mAcceptedPrimaryRegistration(false),
-  mSetupIsConfigured(false)
+  mSetupIsConfigured(false),
+  mProbeInView(false)
 {
   mNodesManager->CreatePlannedPoints();
   mNodesManager->CreatePrimaryRealPoints();
@@ -245,6 +246,7 @@ void NavRegView::OnAcceptPrimaryRegistration()
 
   // enable secondary registration
   mAcceptedPrimaryRegistration = true;
+  UpdateProbeButtons();
 
   // disable the addition/removal of points
   for (int i=0; i<mPointGroupStack.size(); i++)
@@ -296,8 +298,8 @@ bool NavRegView::OnCancelPrimaryRegistration()
   mControls.pbCancelPrimary->setEnabled(false);
   mControls.pbAcceptPrimary->setEnabled(false);
 
-  // hide buttons
-  OnInvalidProbeInView();
+  // navigation stopped: probe buttons disabled
+  UpdateProbeButtons();
 
   return true;
 }
@@ -548,18 +550,23 @@ void NavRegView::OnAddPoint()
 
 void NavRegView::OnValidProbeInView()
 {
-  mControls.pbAddPoint->setEnabled(mAcceptedPrimaryRegistration);
-
-  for (int i=0; i<mPointGroupStack.size(); i++)
-    mPointGroupStack[i]->pbSet->setEnabled(!mAcceptedPrimaryRegistration);
+  mProbeInView = true;
+  UpdateProbeButtons();
 }
 
 void NavRegView::OnInvalidProbeInView()
 {
-  mControls.pbAddPoint->setEnabled(false);
+  mProbeInView = false;
+  UpdateProbeButtons();
+}
+
+void NavRegView::UpdateProbeButtons()
+{
+  // primary points are set before accepting the primary registration, secondary points after
+  mControls.pbAddPoint->setEnabled(mProbeInView && mAcceptedPrimaryRegistration);
 
   for (int i=0; i<mPointGroupStack.size(); i++)
-    mPointGroupStack[i]->pbSet->setEnabled(false);
+    mPointGroupStack[i]->pbSet->setEnabled(mProbeInView && !mAcceptedPrimaryRegistration);
 }
 
 void NavRegView::OnCancelRegistration()
@@ -576,6 +583,9 @@ void NavRegView::StopRegistration()
 {
   NavigationPluginBase::StopNavigation();
 
+  // the visibility is reported again when navigation restarts
+  mProbeInView = false;
+
   // gui
   mControls.pbCancelRegistration->setEnabled(false);
   mControls.pbAcceptRegistration->setEnabled(false);
@@ -651,6 +661,7 @@ bool NavRegView::StartRegistration(mitk::DataNode::Pointer series, navAPI::Marke
   ClearSecondaryPoints();
   mAcceptedPrimaryRegistration = false;
   mAcceptedRegistration = false;
+  UpdateProbeButtons();
 
   bool registrationLoaded = false;
 
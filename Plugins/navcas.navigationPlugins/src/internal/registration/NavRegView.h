@@ -137,6 +137,9 @@ private:
 
   void NewAveragedAcquisition(mitk::Point3D,double,int) override;
 
+  /// enables the point buttons from the probe visibility and the registration stage
+  void UpdateProbeButtons();
+
   Ui::NavRegViewControls                mControls;
 
   /// selected node in datamanager (either patient or instrument)
@@ -160,6 +163,9 @@ private:
   bool                                  mAcceptedPrimaryRegistration;
   bool                                  mSetupIsConfigured;
 
+  // probe visibility last reported by navAPI (signals are only emitted when it changes)
+  bool                                  mProbeInView;
+
   SurfaceRefinementThread*              mSurfaceRefinementThread;
   QProgressBar*                         mProgressbar;
 
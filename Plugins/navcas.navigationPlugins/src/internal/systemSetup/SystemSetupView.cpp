@@ -14,6 +14,7 @@ navCAS navigation system
 #include <QButtonGroup>
 #include <QMessageBox>
 #include <QTimer>
+#include <QFileDialog>
 
 // Mitk
 #include <mitkDataNode.h>
@@ -37,7 +38,8 @@ using namespace std;
 // Don't forget to initialize the VIEW_ID.
 const std::string SystemSetupView::VIEW_ID = "navcas.systemsetup";
 
-SystemSetupView::SystemSetupView()
+SystemSetupView::SystemSetupView() :
+  mDiagnosticsTimer(nullptr)
 {
   mNodesManager->InitializeSetup();
 }
@@ -91,6 +93,13 @@ void SystemSetupView::CreateQtPartControl(QWidget* parent)
   mControls.lblMediumWarning->setVisible(false);
   mControls.lblBigWarning->setVisible(false);
 
+  // diagnostics, refreshed while the view is visible
+  connect(mControls.pbExportLatency, SIGNAL(clicked()), this, SLOT(OnExportLatency()));
+  connect(mControls.pbResetLatency, SIGNAL(clicked()), this, SLOT(OnResetLatency()));
+  mDiagnosticsTimer = new QTimer(parent);
+  mDiagnosticsTimer->setInterval(1000);
+  connect(mDiagnosticsTimer, SIGNAL(timeout()), this, SLOT(OnUpdateDiagnostics()));
+
   // Navigation
   ConnectNavigationActionsAndFunctions();
 
@@ -285,6 +294,8 @@ void SystemSetupView::OnInstrumentTrackerChanged()
 
 void SystemSetupView::OnMultipleMarkersInView(std::vector<navAPI::MarkerId> list)
 {
+  mMarkersInView = list;
+
   int smallCount = std::count(list.begin(),list.end(),navAPI::MarkerId::SmallTracker);
   int mediumCount = std::count(list.begin(),list.end(),navAPI::MarkerId::MediumTracker);
   int bigCount = std::count(list.begin(),list.end(),navAPI::MarkerId::BigTracker);
@@ -351,6 +362,10 @@ void SystemSetupView::OnNavigationModeChanged()
 
   // enable/disable instrument marker
   mControls.gbInstrument->setVisible(!mControls.rbTraditional->isChecked());
+
+  // markers are only reported when they change, re-evaluate the instrument buttons
+  if (IsCameraConnected())
+    OnMultipleMarkersInView(mMarkersInView);
 }
 
 void SystemSetupView::UpdateCameraStatusLabels(bool isConnected)
@@ -372,20 +387,19 @@ void SystemSetupView::UpdateCameraStatusLabels(bool isConnected)
 
 bool SystemSetupView::StartNavigation(bool verbose, NavigationType type)
 {
-  cout << "Trying to detect the navigation camera" << std::endl;
-  if (!mAPI->DetectCamera())
-  {
-    UpdateCameraStatusLabels(false);
-    return false;
-  }
-
   cout << "Trying to start navigation" << std::endl;
-  NavigationPluginBase::StartNavigation(verbose,type);
+  UpdateCameraStatusLabels(false);
 
-  UpdateCameraStatusLabels(IsCameraConnected());
+  return NavigationPluginBase::StartNavigation(verbose,type);
+}
 
+void SystemSetupView::CameraStateChanged(CameraConnectionManager::State state)
+{
   // allow start zeroing
-  return IsCameraConnected();
+  UpdateCameraStatusLabels(IsCameraConnected());
+
+  if (!IsCameraConnected() && (state != CameraConnectionManager::Disconnected))
+    mControls.lblCameraStatus->setText(QString(CameraConnectionManager::GetStateName(state)) + "...");
 }
 
 
@@ -395,10 +409,7 @@ bool SystemSetupView::StartNavigation(bool verbose, NavigationType type)
 
 void SystemSetupView::OnStartProbeCalibration()
 {
-  if ((mAPI != nullptr) && (mAPI->isRunning()) )
-    mAPI->CloseCamera();
-
-  mAPI->StopNavigation();
+  mCameraConnection->Disconnect();
 
 	// start pivot calibration process
 	mControls.lblInformation->setText("Pivot the probe around a known fixed medium marker)");
@@ -421,7 +432,7 @@ void SystemSetupView::StartDetectingMarker()
 	mError = 100.0;
 
   connect(mAPI, SIGNAL(ValidTemporalProbeInView()), this, SLOT(OnValidTemporalProbe()));
-  connect(mAPI, SIGNAL(MarkerRelativePosition(unsigned int, vtkMatrix4x4*)), this, SLOT(OnAcquireTemporalPosition(unsigned int, vtkMatrix4x4*)));
+  connect(this, SIGNAL(RelativeMarkerUpdated(unsigned int, vtkMatrix4x4*)), this, SLOT(OnAcquireTemporalPosition(unsigned int, vtkMatrix4x4*)));
 
 	// create calibration database
 	if (mControls.cbStoreAcquisitions->isChecked())
@@ -434,6 +445,10 @@ void SystemSetupView::StartDetectingMarker()
   mControls.lblInformation->setText(QString("0/")+QString::number(mControls.sbAcquisitions->value()));
   mControls.lblInformation->setVisible(true);
 
+  // raw fiducials of the frames acquired from now on, to check the probe is fully seen
+  mAPI->GetRawFrameBuffer().Clear();
+  mAPI->SetRawCaptureEnabled(true);
+
   // start calibration navigation
   mAPI->SetSamplingPeriod(20); // 50 Hz
   StartNavigation(true,NavigationPluginBase::NavigationType::Calibration);
@@ -443,9 +458,21 @@ void SystemSetupView::OnAcquireTemporalPosition(unsigned int marker, vtkMatrix4x
 {
   const unsigned long ACQUISITIONS = static_cast<unsigned long>(mControls.sbAcquisitions->value());
   static const double MAX_ERROR = 0.1;
+  static const unsigned int TEMPORAL_PROBE_FIDUCIALS = 5;
 
-  // in case disconnect failed
-  if (mTemporalProbePositions.size() == ACQUISITIONS)
+  // only the temporal probe is acquired, in case disconnect failed
+  if ((marker != 2) || (mTemporalProbePositions.size() == ACQUISITIONS))
+    return;
+
+  // the newest raw frame since the previous acquisition: a pose fitted to an occluded probe is
+  // less accurate, and without a new frame the pose was already acquired
+  bool newFrame = false;
+  while (mAPI->GetRawFrameBuffer().Pop(mRawFrame))
+    newFrame = true;
+
+  mitk::Point3D fiducials[TRACKING_MAX_MARKER_FIDUCIALS];
+  bool valid[TRACKING_MAX_MARKER_FIDUCIALS];
+  if (!newFrame || (navAPI::GetMarkerFiducials(mRawFrame,navAPI::TemporalProbe,fiducials,valid) < TEMPORAL_PROBE_FIDUCIALS))
     return;
 
 	// store matrix
@@ -453,8 +480,7 @@ void SystemSetupView::OnAcquireTemporalPosition(unsigned int marker, vtkMatrix4x
   matrix->DeepCopy(mat);
   mTemporalMatrix.push_back(matrix);
 
-	// update probe in the 3d scene
-  UpdateRelativeMarker(marker, mat);
+	// the probe in the 3d scene was already updated by the render tick
 
 	// store probe position in vector for statistics
   //cout << "Acquisition " << mTemporalProbePositions.size() << "/" << ACQUISITIONS << std::endl;
@@ -466,7 +492,7 @@ void SystemSetupView::OnAcquireTemporalPosition(unsigned int marker, vtkMatrix4x
 	{
 		// stop data acquisitions
 		disconnect(mAPI, SIGNAL(ValidTemporalProbeInView()), this, SLOT(OnValidTemporalProbe()));
-    disconnect(mAPI, SIGNAL(MarkerRelativePosition(unsigned int, vtkMatrix4x4*)), this, SLOT(OnAcquireTemporalPosition(unsigned int, vtkMatrix4x4*)));
+    disconnect(this, SIGNAL(RelativeMarkerUpdated(unsigned int, vtkMatrix4x4*)), this, SLOT(OnAcquireTemporalPosition(unsigned int, vtkMatrix4x4*)));
 		
 		// store acquisitions in data base
 		if (mControls.cbStoreAcquisitions->isChecked())
@@ -529,7 +555,8 @@ void SystemSetupView::OnAcquireTemporalPosition(unsigned int marker, vtkMatrix4x
 		if (mError < MAX_ERROR)
 		{
 			cout << "Zeroing process converged towards std deviation lower than " << MAX_ERROR << " mm" << std::endl;
-			mAPI->CloseCamera();
+      mAPI->SetRawCaptureEnabled(false);
+			mCameraConnection->Disconnect();
 			return;
 		}
 
@@ -543,7 +570,7 @@ void SystemSetupView::OnAcquireTemporalPosition(unsigned int marker, vtkMatrix4x
 		msgBox1.exec();
 		if (msgBox1.clickedButton() != accept1)
 		{
-			mAPI->CloseCamera();
+			mCameraConnection->Disconnect();
 			mCalibrationDB->close();
 			return;
 		}
@@ -558,7 +585,7 @@ void SystemSetupView::OnAcquireTemporalPosition(unsigned int marker, vtkMatrix4x
 		mTemporalMatrix.clear();
 
 		connect(mAPI, SIGNAL(ValidTemporalProbeInView()), this, SLOT(OnValidTemporalProbe()));
-    connect(mAPI, SIGNAL(MarkerRelativePosition(unsigned int, vtkMatrix4x4*)), this, SLOT(OnAcquireTemporalPosition(unsigned int, vtkMatrix4x4*)));
+    connect(this, SIGNAL(RelativeMarkerUpdated(unsigned int, vtkMatrix4x4*)), this, SLOT(OnAcquireTemporalPosition(unsigned int, vtkMatrix4x4*)));
 	}
 }
 
@@ -571,15 +598,66 @@ void SystemSetupView::Visible()
   if (!StartNavigation(true))
     QTimer::singleShot(1000,this,SLOT(SilentlyRetryCameraConnection()));
   WaitCursorOff();
+
+  if (mDiagnosticsTimer != nullptr)
+  {
+    OnUpdateDiagnostics();
+    mDiagnosticsTimer->start();
+  }
 }
 
 void SystemSetupView::Hidden()
 {
   cout << "SystemSetup hidden: closing device" << std::endl;
 
+  if (mDiagnosticsTimer != nullptr)
+    mDiagnosticsTimer->stop();
+  mAPI->SetRawCaptureEnabled(false);
   StopNavigation();
 }
 
+void SystemSetupView::OnUpdateDiagnostics()
+{
+  QString text = QString::fromStdString(GetLatencyMonitor().ToText());
+
+  // frame accounting of the tracking source
+  const TrackingSource* source = mAPI->GetTrackingSource();
+  text += QString("\nFrames: %1, skipped: %2, overflows: %3, reprocess failures: %4")
+      .arg(source->GetNumberOfFrames())
+      .arg(source->GetNumberOfSkippedFrames())
+      .arg(source->GetNumberOfOverflows())
+      .arg(source->GetNumberOfReprocessFailures());
+
+  mControls.lblLatency->setText(text);
+}
+
+void SystemSetupView::OnExportLatency()
+{
+  QString fileName = QFileDialog::getSaveFileName(nullptr, "Export latency statistics", QString(), "CSV (*.csv);;JSON (*.json)");
+  if (fileName.isEmpty())
+    return;
+
+  bool ok;
+  if (fileName.endsWith(".json",Qt::CaseInsensitive))
+    ok = GetLatencyMonitor().ExportJSON(fileName.toStdString());
+  else
+  {
+    if (!fileName.endsWith(".csv",Qt::CaseInsensitive))
+      fileName += ".csv";
+    ok = GetLatencyMonitor().ExportCSV(fileName.toStdString());
+  }
+
+  if (!ok)
+    QMessageBox::critical(nullptr, "Error", "Cannot write " + fileName);
+}
+
+void SystemSetupView::OnResetLatency()
+{
+  GetLatencyMonitor().Reset();
+  mAPI->GetTrackingSource()->ResetStatistics();
+  OnUpdateDiagnostics();
+}
+
 void SystemSetupView::NodeAdded(const mitk::DataNode* node)
 {
   auto pred = mitk::NodePredicateProperty::New("navCAS.systemSetup.isSetupNode",mitk::BoolProperty::New(true));
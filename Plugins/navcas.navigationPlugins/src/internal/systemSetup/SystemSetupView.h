@@ -42,6 +42,7 @@ private:
   void StartDetectingMarker();
 
   virtual bool StartNavigation(bool verbose=true, NavigationType=Traditional) override;
+  void CameraStateChanged(CameraConnectionManager::State state) override;
   void UpdateCameraStatusLabels(bool isConnected);
 
   // life cycle aware
@@ -70,6 +71,11 @@ private slots:
   void OnValidTemporalProbe();
   void OnAcquireTemporalPosition(unsigned int, vtkMatrix4x4*);
 
+  // diagnostics
+  void OnUpdateDiagnostics();
+  void OnExportLatency();
+  void OnResetLatency();
+
 private:
   // Typically a one-liner. Set the focus to the default widget.
   void SetFocus() override;
@@ -86,11 +92,18 @@ private:
 
   mitk::DataNode::Pointer               mSelectedInstrument;
 
+  /// last markers reported by navAPI (probe excluded)
+  std::vector<navAPI::MarkerId>         mMarkersInView;
+
 	// all acquired temporal probe positions during pivot calibration
 	std::vector<mitk::Point3D>									mTemporalProbePositions;
   std::vector<vtkSmartPointer<vtkMatrix4x4> > mTemporalMatrix;
 	double																			mError;
+  /// newest raw frame read during the pivot calibration
+  TrackingFrame                         mRawFrame;
 	QSqlDatabase*																mCalibrationDB;
+
+  QTimer*                               mDiagnosticsTimer;
 };
 
 #endif
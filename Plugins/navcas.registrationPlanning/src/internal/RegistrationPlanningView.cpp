@@ -9,6 +9,7 @@ navCAS navigation system
 #include <iostream>
 
 #include <QHBoxLayout>
+#include <QSettings>
 
 #include <berryISelectionService.h>
 #include <berryIWorkbenchWindow.h>
@@ -124,6 +125,13 @@ void RegistrationPlanningView::CreateQtPartControl(QWidget* parent)
 
   connect(mControls.pbRoundPoints,SIGNAL(clicked()), this, SLOT(OnRoundPoints()));
 
+  // predicted TRE
+  QSettings settings("CAS","navCAS");
+  mControls.sbFLE->setValue(settings.value("Planning FLE", 0.5).toDouble());
+  mTREMap.SetFLE(mControls.sbFLE->value());
+  connect(mControls.cbShowPredictedTRE, SIGNAL(toggled(bool)), this, SLOT(OnShowPredictedTRE(bool)));
+  connect(mControls.sbFLE, SIGNAL(valueChanged(double)), this, SLOT(OnFLEChanged(double)));
+
   // Configure panel
   //mControls.PointsBox->setEnabled(false);
 
@@ -255,6 +263,7 @@ void RegistrationPlanningView::SetPoint(unsigned int pos, const mitk::Point3D po
 
   mRegistrationPointsNode->SetVisibility(true);
 
+  UpdatePredictedTRE();
   mitk::RenderingManager::GetInstance()->RequestUpdateAll();
 }
 
@@ -267,12 +276,17 @@ void RegistrationPlanningView::RemovePoint(unsigned int pos)
   propUseName << "navCAS.registration.useP" << pos+1;
   mRegistrationImageNode->SetBoolProperty(propUseName.str().c_str(),false);
 
+  UpdatePredictedTRE();
   mitk::RenderingManager::GetInstance()->RequestUpdateAll();
 }
 
 
 void RegistrationPlanningView::SetRegistrationNode(mitk::DataNode::Pointer node)
 {
+  // the colormap belongs to the planning of the previous node
+  if (mRegistrationImageNode.IsNotNull() && (mRegistrationImageNode != node))
+    mTREMap.Hide(mRegistrationImageNode);
+
   mRegistrationImageNode = node;
   node->SetBoolProperty("navCAS.canUseForRegistration",true);
 
@@ -317,6 +331,7 @@ void RegistrationPlanningView::SetRegistrationNode(mitk::DataNode::Pointer node)
 
   mControls.pbRoundPoints->setEnabled(true);
   UpdateCoordinatesTable();
+  UpdatePredictedTRE();
 }
 
 void RegistrationPlanningView::OnSetPoint()
@@ -456,6 +471,7 @@ void RegistrationPlanningView::Activated()
     datanode->SetVisibility(true);
 
   mInteractor->ShowArrow(true);
+  UpdatePredictedTRE();
 }
 
 void RegistrationPlanningView::Hidden()
@@ -466,6 +482,10 @@ void RegistrationPlanningView::Hidden()
 
   mInteractor->ShowArrow(false);
   mNodesManager->ShowPlannedPoints(false);
+
+  // the colormap is only meaningful while planning
+  if (mRegistrationImageNode.IsNotNull())
+    mTREMap.Hide(mRegistrationImageNode);
 }
 
 void RegistrationPlanningView::OnAddPoint()
@@ -518,3 +538,39 @@ void RegistrationPlanningView::OnRoundPoints()
   mNodesManager->ShowPlannedPoints(true,mRegistrationImageNode);
   UpdateCoordinatesTable();
 }
+
+void RegistrationPlanningView::OnShowPredictedTRE(bool)
+{
+  UpdatePredictedTRE();
+  mitk::RenderingManager::GetInstance()->RequestUpdateAll();
+}
+
+void RegistrationPlanningView::OnFLEChanged(double fle)
+{
+  QSettings settings("CAS","navCAS");
+  settings.setValue("Planning FLE", fle);
+
+  mTREMap.SetFLE(fle);
+  UpdatePredictedTRE();
+  mitk::RenderingManager::GetInstance()->RequestUpdateAll();
+}
+
+void RegistrationPlanningView::UpdatePredictedTRE()
+{
+  if (mRegistrationImageNode.IsNull())
+    return;
+
+  // only surfaces can be colored, the TRE of image voxels is not shown
+  if (dynamic_cast<mitk::Surface*>(mRegistrationImageNode->GetData()) == nullptr)
+    return;
+
+  if (!mControls.cbShowPredictedTRE->isChecked())
+  {
+    mTREMap.Hide(mRegistrationImageNode);
+    return;
+  }
+
+  // less than 3 points (or collinear ones) cannot be registered
+  if (!mTREMap.Show(mRegistrationImageNode,mRegistrationPoints))
+    cout << "Predicted TRE not available for the planned points" << std::endl;
+}
@@ -20,6 +20,7 @@ navCAS navigation system
 #include "PlanningInteractor.h"
 #include "NodesManager.h"
 #include "PointGroupStack.h"
+#include "TREMap.h"
 
 using namespace std;
 
@@ -72,9 +73,13 @@ private slots:
 
   void OnRoundPoints();
 
+  void OnShowPredictedTRE(bool show);
+  void OnFLEChanged(double fle);
+
 private:
 
   void UpdateCoordinatesTable();
+  void UpdatePredictedTRE();
 
   Ui::RegistrationPlanningViewControls  mControls;
 
@@ -91,6 +96,9 @@ private:
   PlanningInteractor::Pointer           mInteractor;
 
   NodesManager*                         mNodesManager;
+
+  // expected TRE of the planned points over the registration surface
+  TREMap                                mTREMap;
 };
 
 #endif